@@ -4,132 +4,397 @@
 #include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_CollisionQueries.h"
 
 #include "BlueprintFunctionLibraries/GCBlueprintFunctionLibrary_MathHelpers.h"
-#include "BlueprintFunctionLibraries/GCBlueprintFunctionLibrary_ArrayHelpers.h"
 #include "BlueprintFunctionLibraries/Debugging/GCBlueprintFunctionLibrary_DrawDebugHelpers.h"
 #include "DrawDebugHelpers.h"
 #include "BlueprintFunctionLibraries/GCBlueprintFunctionLibrary_HitResultHelpers.h"
+#include "Async/ParallelFor.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "Utilities/GCQueryRecorder.h"
 
 
 
 const float UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastStartWallAvoidancePadding = .01f; // good number for bumping a scene cast start location away from the surface of geometry
 const TFunctionRef<bool(const FHitResult&)>& UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable = [](const FHitResult&) { return false; };
 
+/** For the penetration scene casts that nothing can stop (e.g. the backwards ones that find exits). Lets the impenetrable checks compile out. */
+static auto NeverImpenetrable = [](const FHitResult&) { return false; };
+
+
+
+bool FExitAwareHitResult::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	FHitResult::NetSerialize(Ar, Map, bOutSuccess);
+
+	uint8 bExitHit = bIsExitHit;
+	Ar.SerializeBits(&bExitHit, 1);
+	bIsExitHit = bExitHit;
+
+	return true;
+}
+
+FExitAwareHitResult FCompactHitRecord::ToExitAwareHitResult(const FVector& InTraceStart, const FVector& InTraceEnd) const
+{
+	FExitAwareHitResult HitResult;
+	HitResult.bIsExitHit = bIsExitHit;
+	HitResult.bBlockingHit = bBlockingHit;
+	HitResult.bStartPenetrating = bStartPenetrating;
+	HitResult.FaceIndex = FaceIndex;
+
+	HitResult.TraceStart = InTraceStart;
+	HitResult.TraceEnd = InTraceEnd;
+	HitResult.Distance = Distance;
+	const float TraceLength = FVector::Distance(InTraceStart, InTraceEnd);
+	HitResult.Time = (TraceLength > 0.f ? (Distance / TraceLength) : 0.f);
+
+	HitResult.Location = Location;
+	HitResult.ImpactPoint = Location;
+	HitResult.Normal = FVector(Normal);
+	HitResult.ImpactNormal = FVector(Normal);
+
+	HitResult.Component = Component;
+	HitResult.HitObjectHandle = FActorInstanceHandle(Component.IsValid() ? Component->GetOwner() : nullptr);
+	HitResult.BoneName = BoneName;
+	return HitResult;
+}
+
+
+
+FExitHitsQueryScratch::FExitHitsQueryScratch()
+	: BackwardsStart(FVector::ZeroVector)
+	, BufferSize(0)
+	, NumBufferGrowths(0)
+{
+}
+FExitHitsQueryScratch::FExitHitsQueryScratch(const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams)
+	: FExitHitsQueryScratch()
+{
+	SetCollisionParams(InCollisionQueryParams, InCollisionResponseParams);
+}
+
+void FExitHitsQueryScratch::SetCollisionParams(const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams)
+{
+	CollisionQueryParams = InCollisionQueryParams;
+	CollisionResponseParams = InCollisionResponseParams;
+	SetDerivedCollisionParams(InCollisionQueryParams, InCollisionResponseParams, true);
+}
+
+void FExitHitsQueryScratch::SetDerivedCollisionParams(const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bInForPenetration)
+{
+	BackwardsCollisionQueryParams = InCollisionQueryParams;
+	BackwardsCollisionQueryParams.bFindInitialOverlaps = false;
+
+	if (bInForPenetration)
+	{
+		UGCBlueprintFunctionLibrary_CollisionQueries::MakePenetrationSceneCastParams(PenetrationCollisionQueryParams, PenetrationCollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams);
+		UGCBlueprintFunctionLibrary_CollisionQueries::MakePenetrationSceneCastParams(PenetrationBackwardsCollisionQueryParams, PenetrationCollisionResponseParams, BackwardsCollisionQueryParams, InCollisionResponseParams);
+	}
+}
+
+void FExitHitsQueryScratch::ResetBuffers()
+{
+	BufferSize = GetBufferSize();
+
+	// Reset() keeps the memory. The furthest possible exit lists and the response cache are sized (or reset) by whoever uses them.
+	EntranceHitResults.Reset();
+	ExitHitResults.Reset();
+	SimpleBodyExitHitResults.Reset();
+	SpanExitHitResults.Reset();
+	ChunkHitResults.Reset();
+	BodiesWithExitsFound.Reset();
+	Spans.Reset();
+}
+void FExitHitsQueryScratch::TrackBufferGrowth()
+{
+	const SIZE_T NewBufferSize = GetBufferSize();
+	if (NewBufferSize > BufferSize)
+	{
+		++NumBufferGrowths;
+	}
+	BufferSize = NewBufferSize;
+}
+SIZE_T FExitHitsQueryScratch::GetBufferSize() const
+{
+	SIZE_T Size = EntranceHitResults.GetAllocatedSize() + ExitHitResults.GetAllocatedSize() + SimpleBodyExitHitResults.GetAllocatedSize() + SpanExitHitResults.GetAllocatedSize() + ChunkHitResults.GetAllocatedSize();
+	Size += BodiesWithExitsFound.GetAllocatedSize() + Spans.GetAllocatedSize() + ResponseCache.GetAllocatedSize();
+
+	const FFurthestPossibleExitWorkingMemory& WorkingMemory = FurthestPossibleExitWorkingMemory;
+	Size += WorkingMemory.FurthestPossibleExitDistances.GetAllocatedSize() + WorkingMemory.EntranceDistances.GetAllocatedSize() + WorkingMemory.FallbackDistances.GetAllocatedSize();
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Size += WorkingMemory.SlabOffsets[Axis].GetAllocatedSize() + WorkingMemory.SlabDirs[Axis].GetAllocatedSize() + WorkingMemory.SlabExtents[Axis].GetAllocatedSize();
+	}
+	return Size;
+}
+
 
 
 //  BEGIN Custom query
 bool UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiByChannel(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams)
 {
+	INC_DWORD_STAT(STAT_GCSceneCastsIssued);
+	FGCQueryHeatmap::CountSceneCast();
+
 	// UWorld has SweepMultiByChannel() which already checks for zero extent shapes, but it doesn't explicitly check for ECollisionChannel::LineShape and its name can lead you to think that it doesn't support line traces
+	bool bHitBlockingHit;
 	if (InCollisionShape.IsLine())
 	{
-		return InWorld->LineTraceMultiByChannel(OutHits, InStart, InEnd, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams);
+		bHitBlockingHit = InWorld->LineTraceMultiByChannel(OutHits, InStart, InEnd, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams);
 	}
 	else
 	{
-		return InWorld->SweepMultiByChannel(OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams);
+		bHitBlockingHit = InWorld->SweepMultiByChannel(OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams);
 	}
-}
-//  END Custom query
 
-//  BEGIN Custom query
-bool UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart)
+	INC_DWORD_STAT_BY(STAT_GCHitsProcessed, OutHits.Num());
+	return bHitBlockingHit;
+}
+FTraceHandle UGCBlueprintFunctionLibrary_CollisionQueries::AsyncSceneCastMultiByChannel(UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const FTraceDelegate* InDelegate)
 {
-	// FORWARDS SCENE CAST to get our entrance hits
-	TArray<FHitResult> EntranceHitResults;
-	const bool bHitBlockingHit = SceneCastMultiByChannel(InWorld, EntranceHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams);
-	if (bOptimizeBackwardsSceneCastLength && EntranceHitResults.Num() <= 0)
+	INC_DWORD_STAT(STAT_GCSceneCastsIssued);
+	FGCQueryHeatmap::CountSceneCast();
+
+	if (InCollisionShape.IsLine())
 	{
-		return bHitBlockingHit; // no entrance hits for our optimization to work with. Also this will always return false here
+		return InWorld->AsyncLineTraceByChannel(EAsyncTraceType::Multi, InStart, InEnd, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams, InDelegate);
 	}
-
-
-	// BACKWARDS SCENE CAST to get our exit hits
-	const FVector BackwardsStart = DetermineBackwardsSceneCastStart(EntranceHitResults, InStart, InEnd, (bHitBlockingHit ? &EntranceHitResults.Last() : nullptr), bOptimizeBackwardsSceneCastLength, UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(InCollisionShape));
-#if ENABLE_DRAW_DEBUG
-	if (bDrawDebugForBackwardsStart)
+	else
 	{
-		const FVector BackwardsDir = (InStart - BackwardsStart).GetSafeNormal();
-		DrawDebugForBackwardsStart(InWorld, InCollisionShape, InRotation, BackwardsStart, BackwardsDir);
+		return InWorld->AsyncSweepByChannel(EAsyncTraceType::Multi, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InDelegate);
 	}
-#endif // ENABLE_DRAW_DEBUG
-	FCollisionQueryParams BackwardsCollisionQueryParams = InCollisionQueryParams;
-	BackwardsCollisionQueryParams.bFindInitialOverlaps = false;
+}
+//  END Custom query
 
-	TArray<FHitResult> ExitHitResults;
-	ExitHitResults.Reserve(EntranceHitResults.Num());
-	SceneCastMultiByChannel(InWorld, ExitHitResults, BackwardsStart, InStart, InRotation, InTraceChannel, InCollisionShape, BackwardsCollisionQueryParams, InCollisionResponseParams);
+//  BEGIN Custom query
+bool UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	FExitHitsQueryScratch Scratch;
+	Scratch.SetDerivedCollisionParams(InCollisionQueryParams, InCollisionResponseParams, false);
+	const bool bHitBlockingHit = SceneCastMultiWithExitHitsInternal(Scratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
 
-	MakeBackwardsHitsDataRelativeToForwadsSceneCast(ExitHitResults, EntranceHitResults);
+	// Lastly combine these hits together into our output value with the entrance and exit hits in order
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	OrderHitResultsInForwardsDirection(OutHits, Scratch.EntranceHitResults, Scratch.ExitHitResults, ForwardsDir);
+	return bHitBlockingHit;
+}
+bool UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	const bool bHitBlockingHit = SceneCastMultiWithExitHitsInternal(InOutScratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.CollisionQueryParams, InOutScratch.CollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
 
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	OrderHitResultsInForwardsDirection(OutHits, InOutScratch.EntranceHitResults, InOutScratch.ExitHitResults, ForwardsDir);
+
+	InOutScratch.TrackBufferGrowth();
+	return bHitBlockingHit;
+}
+bool UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FCompactHitRecord>& OutHitRecords, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	const bool bHitBlockingHit = SceneCastMultiWithExitHitsInternal(InOutScratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.CollisionQueryParams, InOutScratch.CollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
 
-	// Lastly combine these hits together into our output value with the entrance and exit hits in order
 	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
-	OrderHitResultsInForwardsDirection(OutHits, EntranceHitResults, ExitHitResults, ForwardsDir);
+	OrderHitResultsInForwardsDirection(OutHitRecords, InOutScratch.EntranceHitResults, InOutScratch.ExitHitResults, ForwardsDir);
 
+	InOutScratch.TrackBufferGrowth();
 	return bHitBlockingHit;
 }
-bool UGCBlueprintFunctionLibrary_CollisionQueries::LineTraceMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart)
+bool UGCBlueprintFunctionLibrary_CollisionQueries::LineTraceMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
 {
 	FCollisionShape LineShape = FCollisionShape();
-	return SceneCastMultiWithExitHits(InWorld, OutHits, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart);
+	return SceneCastMultiWithExitHits(InWorld, OutHits, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
 }
-bool UGCBlueprintFunctionLibrary_CollisionQueries::SweepMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart)
+bool UGCBlueprintFunctionLibrary_CollisionQueries::SweepMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
 {
 	UE_CLOG(InCollisionShape.IsLine(), LogGCCollisionQueries, Warning, TEXT("%s() was used with a FCollisionShape::LineShape. Use the linetrace version if you want a line traces."), ANSI_TO_TCHAR(__FUNCTION__));
-	return SceneCastMultiWithExitHits(InWorld, OutHits, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart);
+	return SceneCastMultiWithExitHits(InWorld, OutHits, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
 }
 //  END Custom query
 
-
 //  BEGIN Custom query
-FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable)
+/**
+ * Everything an async exit hit query needs to carry from its forwards scene cast over to its backwards scene cast
+ */
+struct FGCAsyncExitHitsQueryState
 {
-	// Use ECR_Overlap to have this scene cast overlap through blocking hits. Our CollisionResponseParams overrides blocking responses to overlap.
-	FCollisionResponseParams CollisionResponseParams = InCollisionResponseParams;
-	CollisionResponseParams.CollisionResponse.ReplaceChannels(ECollisionResponse::ECR_Block, ECollisionResponse::ECR_Overlap);
+	TWeakObjectPtr<UWorld> World;
+	FVector Start;
+	FVector End;
+	FQuat Rotation;
+	ECollisionChannel TraceChannel;
+	FCollisionShape CollisionShape;
+	FCollisionQueryParams CollisionQueryParams;
+	FCollisionResponseParams CollisionResponseParams;
+	bool bOptimizeBackwardsSceneCastLength;
+	EFurthestPossibleExitMethod FurthestPossibleExitMethod;
 
-	// Ensure our collision query params do NOT ignore overlaps because we are scene casting as an ECR_Overlap (otherwise, we wouldn't get any Hit Results)
-	FCollisionQueryParams CollisionQueryParams = InCollisionQueryParams;
-	CollisionQueryParams.bIgnoreTouches = false;
+	/** Only for penetration queries */
+	TFunction<bool(const FHitResult&)> IsHitImpenetrable;
 
-	// Perform the trace/sweep
-	// Also use their InTraceChannel to ensure that their ignored hits are ignored (because FCollisionResponseParams don't affect ECR_Ignore).
-	SceneCastMultiByChannel(InWorld, OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, CollisionResponseParams);
+	FOnSceneCastWithExitHitsComplete OnSceneCastWithExitHitsComplete;
+	FOnPenetrationSceneCastWithExitHitsComplete OnPenetrationSceneCastWithExitHitsComplete;
 
-	// Using ECollisionResponse::ECR_Overlap to scene cast was nice since we can get all hits (both overlap and blocking) in the segment without being stopped, but as a result, all of these hits have bBlockingHit as false.
-	// So lets modify these hits to have the correct responses for the caller's Trace Channel and Collision Response Params.
-	ChangeHitsResponseData(OutHits, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams);
+	/** Filled by the forwards scene cast */
+	TArray<FHitResult> EntranceHitResults;
+	/** Stopping hit of the forwards scene cast (blocking hit or impenetrable hit) */
+	bool bStoppedAtHit = false;
+};
 
-	// Stop at any impenetrable hits
-	for (int32 i = 0; i < OutHits.Num(); ++i)
+void UGCBlueprintFunctionLibrary_CollisionQueries::AsyncSceneCastMultiWithExitHits(UWorld* InWorld, const FOnSceneCastWithExitHitsComplete& InOnComplete, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	if (!IsValid(InWorld))
 	{
-		if (IsHitImpenetrable(OutHits[i]))
+		UE_LOG(LogGCCollisionQueries, Error, TEXT("%s() was given an invalid world. No scene casts will be performed."), ANSI_TO_TCHAR(__FUNCTION__));
+		return;
+	}
+
+	const TSharedRef<FGCAsyncExitHitsQueryState> State = MakeShared<FGCAsyncExitHitsQueryState>();
+	State->World = InWorld;
+	State->Start = InStart;
+	State->End = InEnd;
+	State->Rotation = InRotation;
+	State->TraceChannel = InTraceChannel;
+	State->CollisionShape = InCollisionShape;
+	State->CollisionQueryParams = InCollisionQueryParams;
+	State->CollisionResponseParams = InCollisionResponseParams;
+	State->bOptimizeBackwardsSceneCastLength = bOptimizeBackwardsSceneCastLength;
+	State->FurthestPossibleExitMethod = InFurthestPossibleExitMethod;
+	State->OnSceneCastWithExitHitsComplete = InOnComplete;
+
+	// Called on the game thread once the backwards scene cast is done
+	const FTraceDelegate OnBackwardsSceneCastDone = FTraceDelegate::CreateLambda([State](const FTraceHandle& InTraceHandle, FTraceDatum& InTraceDatum)
+		{
+			GC_QUERY_SCOPE(STAT_GCAsyncSceneCastCompletion);
+			INC_DWORD_STAT_BY(STAT_GCHitsProcessed, InTraceDatum.OutHits.Num());
+
+			TArray<FHitResult>& ExitHitResults = InTraceDatum.OutHits;
+			MakeBackwardsHitsDataRelativeToForwadsSceneCast(ExitHitResults, State->EntranceHitResults);
+
+			TArray<FExitAwareHitResult> Hits;
+			const FVector ForwardsDir = (State->End - State->Start).GetSafeNormal();
+			OrderHitResultsInForwardsDirection(Hits, State->EntranceHitResults, ExitHitResults, ForwardsDir);
+
+			State->OnSceneCastWithExitHitsComplete.ExecuteIfBound(Hits, State->bStoppedAtHit);
+		});
+
+	// Called on the game thread once the forwards scene cast is done
+	const FTraceDelegate OnForwardsSceneCastDone = FTraceDelegate::CreateLambda([State, OnBackwardsSceneCastDone](const FTraceHandle& InTraceHandle, FTraceDatum& InTraceDatum)
 		{
-			// Remove the rest if there are any
-			if (OutHits.IsValidIndex(i + 1))
+			GC_QUERY_SCOPE(STAT_GCAsyncSceneCastCompletion);
+			INC_DWORD_STAT_BY(STAT_GCHitsProcessed, InTraceDatum.OutHits.Num());
+
+			State->EntranceHitResults = MoveTemp(InTraceDatum.OutHits);
+			State->bStoppedAtHit = (State->EntranceHitResults.Num() > 0 && State->EntranceHitResults.Last().bBlockingHit);
+
+			UWorld* World = State->World.Get();
+			if (!IsValid(World) || (State->bOptimizeBackwardsSceneCastLength && State->EntranceHitResults.Num() <= 0))
 			{
-				UGCBlueprintFunctionLibrary_ArrayHelpers::RemoveTheRestAt(OutHits, i + 1);
+				// Nothing for a backwards scene cast to find (or no world left to do it in). Give the entrance hits without exits.
+				TArray<FExitAwareHitResult> Hits;
+				const FVector ForwardsDir = (State->End - State->Start).GetSafeNormal();
+				OrderHitResultsInForwardsDirection(Hits, State->EntranceHitResults, TArray<FHitResult>(), ForwardsDir);
+
+				State->OnSceneCastWithExitHitsComplete.ExecuteIfBound(Hits, State->bStoppedAtHit);
+				return;
 			}
 
-			return &OutHits[i];
-		}
+			const FVector BackwardsStart = DetermineBackwardsSceneCastStart(State->EntranceHitResults, State->Start, State->End, (State->bStoppedAtHit ? &State->EntranceHitResults.Last() : nullptr), State->bOptimizeBackwardsSceneCastLength, UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(State->CollisionShape), State->FurthestPossibleExitMethod);
+
+			FCollisionQueryParams BackwardsCollisionQueryParams = State->CollisionQueryParams;
+			BackwardsCollisionQueryParams.bFindInitialOverlaps = false;
+
+			AsyncSceneCastMultiByChannel(World, BackwardsStart, State->Start, State->Rotation, State->TraceChannel, State->CollisionShape, BackwardsCollisionQueryParams, State->CollisionResponseParams, &OnBackwardsSceneCastDone);
+		});
+
+	AsyncSceneCastMultiByChannel(InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, &OnForwardsSceneCastDone);
+}
+void UGCBlueprintFunctionLibrary_CollisionQueries::AsyncLineTraceMultiWithExitHits(UWorld* InWorld, const FOnSceneCastWithExitHitsComplete& InOnComplete, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	FCollisionShape LineShape = FCollisionShape();
+	AsyncSceneCastMultiWithExitHits(InWorld, InOnComplete, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, InFurthestPossibleExitMethod);
+}
+void UGCBlueprintFunctionLibrary_CollisionQueries::AsyncSweepMultiWithExitHits(UWorld* InWorld, const FOnSceneCastWithExitHitsComplete& InOnComplete, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	UE_CLOG(InCollisionShape.IsLine(), LogGCCollisionQueries, Warning, TEXT("%s() was used with a FCollisionShape::LineShape. Use the linetrace version if you want a line traces."), ANSI_TO_TCHAR(__FUNCTION__));
+	AsyncSceneCastMultiWithExitHits(InWorld, InOnComplete, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, InFurthestPossibleExitMethod);
+}
+//  END Custom query
+
+//  BEGIN Custom query
+void UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHitsBatch(const UWorld* InWorld, const TArray<FSceneCastWithExitHitsQuery>& InQueries, TArray<FExitAwareHitResult>& OutHits, TArray<FSceneCastWithExitHitsBatchResult>& OutResults, const bool bInParallel)
+{
+	GC_QUERY_SCOPE(STAT_GCSceneCastMultiWithExitHitsBatch);
+
+	OutHits.Reset();
+	OutResults.Reset(InQueries.Num());
+	OutResults.AddDefaulted(InQueries.Num());
+
+	if (InQueries.Num() <= 0)
+	{
+		return;
 	}
 
-	// No impenetrable hits stopped us
-	return nullptr;
+	// Each query gets its own hits array so that the workers never write to the same memory
+	TArray<TArray<FExitAwareHitResult>> PerQueryHits;
+	PerQueryHits.SetNum(InQueries.Num());
+
+	// Both the forwards and backwards scene casts of a query are done by the same worker. Scene queries only read the physics scene so they are safe to run side by side.
+	ParallelFor(InQueries.Num(), [&](int32 QueryIndex)
+		{
+			const FSceneCastWithExitHitsQuery& Query = InQueries[QueryIndex];
+			OutResults[QueryIndex].bHitBlockingHit = SceneCastMultiWithExitHits(InWorld, PerQueryHits[QueryIndex], Query.Start, Query.End, Query.Rotation, Query.TraceChannel, Query.CollisionShape, Query.CollisionQueryParams, Query.CollisionResponseParams, Query.bOptimizeBackwardsSceneCastLength, false, Query.ExitHitsMethod, Query.FurthestPossibleExitMethod);
+		},
+		(bInParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread));
+
+	// Assign each query its range of the output
+	int32 TotalNumHits = 0;
+	for (int32 QueryIndex = 0; QueryIndex < InQueries.Num(); ++QueryIndex)
+	{
+		OutResults[QueryIndex].FirstHitIndex = TotalNumHits;
+		OutResults[QueryIndex].NumHits = PerQueryHits[QueryIndex].Num();
+		TotalNumHits += PerQueryHits[QueryIndex].Num();
+	}
+
+	// Pack the hits contiguously
+	OutHits.Reserve(TotalNumHits);
+	for (TArray<FExitAwareHitResult>& QueryHits : PerQueryHits)
+	{
+		OutHits.Append(MoveTemp(QueryHits));
+	}
+}
+//  END Custom query
+
+
+//  BEGIN Custom query
+FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const float InProgressiveChunkLength)
+{
+	GC_QUERY_SCOPE(STAT_GCPenetrationSceneCast);
+
+	FCollisionQueryParams CollisionQueryParams;
+	FCollisionResponseParams CollisionResponseParams;
+	MakePenetrationSceneCastParams(CollisionQueryParams, CollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams);
+
+	// Perform the trace/sweep
+	// Also use their InTraceChannel to ensure that their ignored hits are ignored (because FCollisionResponseParams don't affect ECR_Ignore).
+	if (InProgressiveChunkLength > 0.f)
+	{
+		TArray<FHitResult> ChunkHitResults;
+		return ProgressivePenetrationSceneCastWithPenetrationParams(InWorld, OutHits, ChunkHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, CollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, InProgressiveChunkLength);
+	}
+	return PenetrationSceneCastWithPenetrationParams(InWorld, OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, CollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable);
 }
 FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationLineTrace(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable)
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const float InProgressiveChunkLength)
 {
 	FCollisionShape LineShape = FCollisionShape(); // default constructor makes a line shape for us. I would want to use their FCollisionShape::LineShape but the engine doesn't seem to expose it for modules
-	return PenetrationSceneCast(InWorld, OutHits, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable);
+	return PenetrationSceneCast(InWorld, OutHits, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, InProgressiveChunkLength);
 }
 FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSweep(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable)
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const float InProgressiveChunkLength)
 {
 	UE_CLOG(InCollisionShape.IsLine(), LogGCCollisionQueries, Warning, TEXT("%s() was used with a FCollisionShape::LineShape. Use the linetrace version if you want a line traces."), ANSI_TO_TCHAR(__FUNCTION__));
-	return PenetrationSceneCast(InWorld, OutHits, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable);
+	return PenetrationSceneCast(InWorld, OutHits, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, InProgressiveChunkLength);
 }
 //  END Custom query
 
@@ -138,58 +403,195 @@ FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSweep(const
 FExitAwareHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
 	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
 	const bool bOptimizeBackwardsSceneCastLength,
-	const bool bDrawDebugForBackwardsStart)
+	const bool bDrawDebugForBackwardsStart,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
 {
-	TArray<FHitResult> EntranceHitResults;
-	FHitResult* ImpenetrableHit = PenetrationSceneCast(InWorld, EntranceHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable);
-	if (bOptimizeBackwardsSceneCastLength && EntranceHitResults.Num() <= 0)
+	FExitHitsQueryScratch Scratch;
+	Scratch.SetDerivedCollisionParams(InCollisionQueryParams, InCollisionResponseParams, true);
+	const FHitResult* ImpenetrableHit = PenetrationSceneCastWithExitHitsInternal(Scratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	OrderHitResultsInForwardsDirection(OutHits, Scratch.EntranceHitResults, Scratch.ExitHitResults, ForwardsDir);
+
+	if (!ImpenetrableHit)
 	{
 		return nullptr;
 	}
+	return &OutHits.Last();
+}
+FExitAwareHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const bool bOptimizeBackwardsSceneCastLength,
+	const bool bDrawDebugForBackwardsStart,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	const FHitResult* ImpenetrableHit = PenetrationSceneCastWithExitHitsInternal(InOutScratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.CollisionQueryParams, InOutScratch.CollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
 
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	OrderHitResultsInForwardsDirection(OutHits, InOutScratch.EntranceHitResults, InOutScratch.ExitHitResults, ForwardsDir);
 
-	const FVector BackwardsStart = DetermineBackwardsSceneCastStart(EntranceHitResults, InStart, InEnd, ImpenetrableHit, bOptimizeBackwardsSceneCastLength, UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(InCollisionShape));
-#if ENABLE_DRAW_DEBUG
-	if (bDrawDebugForBackwardsStart)
+	InOutScratch.TrackBufferGrowth();
+	if (!ImpenetrableHit)
 	{
-		const FVector BackwardsDir = (InStart - BackwardsStart).GetSafeNormal();
-		DrawDebugForBackwardsStart(InWorld, InCollisionShape, InRotation, BackwardsStart, BackwardsDir);
+		return nullptr;
 	}
-#endif // ENABLE_DRAW_DEBUG
-	FCollisionQueryParams BackwardsCollisionQueryParams = InCollisionQueryParams;
-	BackwardsCollisionQueryParams.bFindInitialOverlaps = false;
-
-	TArray<FHitResult> ExitHitResults;
-	ExitHitResults.Reserve(EntranceHitResults.Num());
-	PenetrationSceneCast(InWorld, ExitHitResults, BackwardsStart, InStart, InRotation, InTraceChannel, InCollisionShape, BackwardsCollisionQueryParams, InCollisionResponseParams);
-
-	MakeBackwardsHitsDataRelativeToForwadsSceneCast(ExitHitResults, EntranceHitResults);
-
+	return &OutHits.Last();
+}
+FCompactHitRecord* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FCompactHitRecord>& OutHitRecords, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const bool bOptimizeBackwardsSceneCastLength,
+	const bool bDrawDebugForBackwardsStart,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	const FHitResult* ImpenetrableHit = PenetrationSceneCastWithExitHitsInternal(InOutScratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.CollisionQueryParams, InOutScratch.CollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
 
 	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
-	OrderHitResultsInForwardsDirection(OutHits, EntranceHitResults, ExitHitResults, ForwardsDir);
+	OrderHitResultsInForwardsDirection(OutHitRecords, InOutScratch.EntranceHitResults, InOutScratch.ExitHitResults, ForwardsDir);
 
+	InOutScratch.TrackBufferGrowth();
 	if (!ImpenetrableHit)
 	{
 		return nullptr;
 	}
-	return &OutHits.Last();
+	return &OutHitRecords.Last();
 }
 FExitAwareHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationLineTraceWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
 	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
 	const bool bOptimizeBackwardsSceneCastLength,
-	const bool bDrawDebugForBackwardsStart)
+	const bool bDrawDebugForBackwardsStart,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
 {
 	FCollisionShape LineShape = FCollisionShape();
-	return PenetrationSceneCastWithExitHits(InWorld, OutHits, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart);
+	return PenetrationSceneCastWithExitHits(InWorld, OutHits, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
 }
 FExitAwareHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSweepWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
 	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
 	const bool bOptimizeBackwardsSceneCastLength,
-	const bool bDrawDebugForBackwardsStart)
+	const bool bDrawDebugForBackwardsStart,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
 {
 	UE_CLOG(InCollisionShape.IsLine(), LogGCCollisionQueries, Warning, TEXT("%s() was used with a FCollisionShape::LineShape. Use the linetrace version if you want a line traces."), ANSI_TO_TCHAR(__FUNCTION__));
-	return PenetrationSceneCastWithExitHits(InWorld, OutHits, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart);
+	return PenetrationSceneCastWithExitHits(InWorld, OutHits, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+//  END Custom query
+
+//  BEGIN Custom query
+void UGCBlueprintFunctionLibrary_CollisionQueries::AsyncPenetrationSceneCastWithExitHits(UWorld* InWorld, const FOnPenetrationSceneCastWithExitHitsComplete& InOnComplete, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	TFunction<bool(const FHitResult&)> IsHitImpenetrable,
+	const bool bOptimizeBackwardsSceneCastLength,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	if (!IsValid(InWorld))
+	{
+		UE_LOG(LogGCCollisionQueries, Error, TEXT("%s() was given an invalid world. No scene casts will be performed."), ANSI_TO_TCHAR(__FUNCTION__));
+		return;
+	}
+
+	const TSharedRef<FGCAsyncExitHitsQueryState> State = MakeShared<FGCAsyncExitHitsQueryState>();
+	State->World = InWorld;
+	State->Start = InStart;
+	State->End = InEnd;
+	State->Rotation = InRotation;
+	State->TraceChannel = InTraceChannel;
+	State->CollisionShape = InCollisionShape;
+	State->CollisionQueryParams = InCollisionQueryParams;
+	State->CollisionResponseParams = InCollisionResponseParams;
+	State->bOptimizeBackwardsSceneCastLength = bOptimizeBackwardsSceneCastLength;
+	State->FurthestPossibleExitMethod = InFurthestPossibleExitMethod;
+	State->IsHitImpenetrable = MoveTemp(IsHitImpenetrable);
+	State->OnPenetrationSceneCastWithExitHitsComplete = InOnComplete;
+
+	// Called on the game thread once the backwards scene cast is done
+	const FTraceDelegate OnBackwardsSceneCastDone = FTraceDelegate::CreateLambda([State](const FTraceHandle& InTraceHandle, FTraceDatum& InTraceDatum)
+		{
+			GC_QUERY_SCOPE(STAT_GCAsyncSceneCastCompletion);
+			INC_DWORD_STAT_BY(STAT_GCHitsProcessed, InTraceDatum.OutHits.Num());
+
+			TArray<FHitResult>& ExitHitResults = InTraceDatum.OutHits;
+			FinishPenetrationSceneCast(ExitHitResults, State->TraceChannel, State->CollisionQueryParams, State->CollisionResponseParams, NeverImpenetrable);
+			MakeBackwardsHitsDataRelativeToForwadsSceneCast(ExitHitResults, State->EntranceHitResults);
+
+			TArray<FExitAwareHitResult> Hits;
+			const FVector ForwardsDir = (State->End - State->Start).GetSafeNormal();
+			OrderHitResultsInForwardsDirection(Hits, State->EntranceHitResults, ExitHitResults, ForwardsDir);
+
+			State->OnPenetrationSceneCastWithExitHitsComplete.ExecuteIfBound(Hits, (State->bStoppedAtHit ? &Hits.Last() : nullptr));
+		});
+
+	// Called on the game thread once the forwards scene cast is done
+	const FTraceDelegate OnForwardsSceneCastDone = FTraceDelegate::CreateLambda([State, OnBackwardsSceneCastDone](const FTraceHandle& InTraceHandle, FTraceDatum& InTraceDatum)
+		{
+			GC_QUERY_SCOPE(STAT_GCAsyncSceneCastCompletion);
+			INC_DWORD_STAT_BY(STAT_GCHitsProcessed, InTraceDatum.OutHits.Num());
+
+			State->EntranceHitResults = MoveTemp(InTraceDatum.OutHits);
+
+			const FHitResult* ImpenetrableHit;
+			if (State->IsHitImpenetrable)
+			{
+				ImpenetrableHit = FinishPenetrationSceneCast(State->EntranceHitResults, State->TraceChannel, State->CollisionQueryParams, State->CollisionResponseParams, State->IsHitImpenetrable);
+			}
+			else
+			{
+				ImpenetrableHit = FinishPenetrationSceneCast(State->EntranceHitResults, State->TraceChannel, State->CollisionQueryParams, State->CollisionResponseParams, NeverImpenetrable);
+			}
+			State->bStoppedAtHit = (ImpenetrableHit != nullptr);
+
+			UWorld* World = State->World.Get();
+			if (!IsValid(World) || (State->bOptimizeBackwardsSceneCastLength && State->EntranceHitResults.Num() <= 0))
+			{
+				// Nothing for a backwards scene cast to find (or no world left to do it in). Give the entrance hits and the impenetrable hit without exits.
+				TArray<FExitAwareHitResult> Hits;
+				const FVector ForwardsDir = (State->End - State->Start).GetSafeNormal();
+				OrderHitResultsInForwardsDirection(Hits, State->EntranceHitResults, TArray<FHitResult>(), ForwardsDir);
+
+				State->OnPenetrationSceneCastWithExitHitsComplete.ExecuteIfBound(Hits, (State->bStoppedAtHit && Hits.Num() > 0 ? &Hits.Last() : nullptr));
+				return;
+			}
+
+			const FVector BackwardsStart = DetermineBackwardsSceneCastStart(State->EntranceHitResults, State->Start, State->End, ImpenetrableHit, State->bOptimizeBackwardsSceneCastLength, UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(State->CollisionShape), State->FurthestPossibleExitMethod);
+
+			FCollisionQueryParams BackwardsCollisionQueryParams = State->CollisionQueryParams;
+			BackwardsCollisionQueryParams.bFindInitialOverlaps = false;
+
+			FCollisionQueryParams PenetrationCollisionQueryParams;
+			FCollisionResponseParams PenetrationCollisionResponseParams;
+			MakePenetrationSceneCastParams(PenetrationCollisionQueryParams, PenetrationCollisionResponseParams, BackwardsCollisionQueryParams, State->CollisionResponseParams);
+
+			AsyncSceneCastMultiByChannel(World, BackwardsStart, State->Start, State->Rotation, State->TraceChannel, State->CollisionShape, PenetrationCollisionQueryParams, PenetrationCollisionResponseParams, &OnBackwardsSceneCastDone);
+		});
+
+	FCollisionQueryParams PenetrationCollisionQueryParams;
+	FCollisionResponseParams PenetrationCollisionResponseParams;
+	MakePenetrationSceneCastParams(PenetrationCollisionQueryParams, PenetrationCollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams);
+
+	AsyncSceneCastMultiByChannel(InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, PenetrationCollisionQueryParams, PenetrationCollisionResponseParams, &OnForwardsSceneCastDone);
+}
+void UGCBlueprintFunctionLibrary_CollisionQueries::AsyncPenetrationLineTraceWithExitHits(UWorld* InWorld, const FOnPenetrationSceneCastWithExitHitsComplete& InOnComplete, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	TFunction<bool(const FHitResult&)> IsHitImpenetrable,
+	const bool bOptimizeBackwardsSceneCastLength,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	FCollisionShape LineShape = FCollisionShape();
+	AsyncPenetrationSceneCastWithExitHits(InWorld, InOnComplete, InTraceStart, InTraceEnd, FQuat::Identity, InTraceChannel, LineShape, InCollisionQueryParams, InCollisionResponseParams, MoveTemp(IsHitImpenetrable), bOptimizeBackwardsSceneCastLength, InFurthestPossibleExitMethod);
+}
+void UGCBlueprintFunctionLibrary_CollisionQueries::AsyncPenetrationSweepWithExitHits(UWorld* InWorld, const FOnPenetrationSceneCastWithExitHitsComplete& InOnComplete, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	TFunction<bool(const FHitResult&)> IsHitImpenetrable,
+	const bool bOptimizeBackwardsSceneCastLength,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	UE_CLOG(InCollisionShape.IsLine(), LogGCCollisionQueries, Warning, TEXT("%s() was used with a FCollisionShape::LineShape. Use the linetrace version if you want a line traces."), ANSI_TO_TCHAR(__FUNCTION__));
+	AsyncPenetrationSceneCastWithExitHits(InWorld, InOnComplete, InSweepStart, InSweepEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, MoveTemp(IsHitImpenetrable), bOptimizeBackwardsSceneCastLength, InFurthestPossibleExitMethod);
 }
 //  END Custom query
 
@@ -223,57 +625,419 @@ ECollisionResponse UGCBlueprintFunctionLibrary_CollisionQueries::GetCollisionRes
 }
 
 //  BEGIN private functions
-void UGCBlueprintFunctionLibrary_CollisionQueries::ChangeHitsResponseData(TArray<FHitResult>& InOutHits, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams)
+bool UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHitsInternal(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
 {
-	for (int32 i = 0; i < InOutHits.Num(); ++i)
+	GC_QUERY_SCOPE(STAT_GCSceneCastMultiWithExitHits);
+
+	InOutScratch.ResetBuffers();
+	TArray<FHitResult>& EntranceHitResults = InOutScratch.EntranceHitResults;
+
+	// Capture this query if we are recording (see FGCQueryRecorder)
+	FGCQueryRecordScope RecordScope = FGCQueryRecordScope(EGCQueryRecordType::SceneCastMultiWithExitHits, EntranceHitResults, InOutScratch.ExitHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, InExitHitsMethod, InFurthestPossibleExitMethod);
+
+	// FORWARDS SCENE CAST to get our entrance hits
+	bool bHitBlockingHit;
 	{
-		// Emulate the use of a Trace Channel and Collision Response Params by manually assigning FHitResult::bBlockingHit and removing any hits that are ignored
-		if (const UPrimitiveComponent* PrimitiveComponent = InOutHits[i].Component.Get())
-		{
-			if (const FBodyInstance* HitBody = PrimitiveComponent->GetBodyInstance(InOutHits[i].BoneName))
+		GC_QUERY_SCOPE(STAT_GCForwardsSceneCast);
+		bHitBlockingHit = SceneCastMultiByChannel(InWorld, EntranceHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams);
+	}
+	RecordScope.SetBlockingHit(bHitBlockingHit);
+	if (bOptimizeBackwardsSceneCastLength && EntranceHitResults.Num() <= 0)
+	{
+		return bHitBlockingHit; // no entrance hits for our optimization to work with. Also this will always return false here
+	}
+
+
+	// BACKWARDS SCENE CAST to get our exit hits
+	FindExitHits(InOutScratch, InWorld, (bHitBlockingHit ? &EntranceHitResults.Last() : nullptr), InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, false, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
+	RecordScope.SetBackwardsStart(InOutScratch.BackwardsStart);
+
+	return bHitBlockingHit;
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::PrepareProgressiveChunkHits(TArray<FHitResult>& InOutChunkHitResults, const TArray<FHitResult>& InPreviousHits, const FVector& InStart, const FVector& InEnd, const float InChunkStartDistance, const float InChunkCastStartDistance, const bool bInFirstChunk)
+{
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	if (!bInFirstChunk)
+	{
+		InOutChunkHitResults.RemoveAll([&](const FHitResult& ChunkHit)
 			{
-				const ECollisionResponse ResponseForHit = GetCollisionResponseForQueryOnBodyInstance(*HitBody, InTraceChannel, InCollisionResponseParams);
-				if (ResponseForHit == ECollisionResponse::ECR_Block)
+				if (ChunkHit.bStartPenetrating)
 				{
-					// This hit component blocks our InTraceChannel (or our trace's collision response params block the component)
-					InOutHits[i].bBlockingHit = true;
+					return true; // we were already inside of this geometry in the previous chunk
+				}
 
-					if (InCollisionQueryParams.bIgnoreBlocks)
-					{
-						// Ignore block
-						InOutHits.RemoveAt(i);
-						--i;
-						continue;
-					}
+				// Remove the ones that the previous chunk already found where the two chunks overlap
+				const float HitDistance = FVector::DotProduct(ForwardsDir, (ChunkHit.Location - InStart));
+				if (HitDistance > (InChunkStartDistance + SceneCastStartWallAvoidancePadding))
+				{
+					return false;
 				}
-				else if (ResponseForHit == ECollisionResponse::ECR_Overlap)
+				for (int32 i = InPreviousHits.Num() - 1; i >= 0 && InPreviousHits[i].Distance >= (InChunkCastStartDistance - SceneCastStartWallAvoidancePadding); --i)
 				{
-					// This hit component overlaps our InTraceChannel (or our trace's collision response params overlap the component)
-					InOutHits[i].bBlockingHit = false;
-
-					if (InCollisionQueryParams.bIgnoreTouches)
+					if (InPreviousHits[i].Component == ChunkHit.Component && InPreviousHits[i].BoneName == ChunkHit.BoneName && FMath::IsNearlyEqual(InPreviousHits[i].Distance, HitDistance, SceneCastStartWallAvoidancePadding * 2))
 					{
-						// Ignore touch
-						InOutHits.RemoveAt(i);
-						--i;
-						continue;
+						return true;
 					}
 				}
-				else if (ResponseForHit == ECollisionResponse::ECR_Ignore)
-				{
-					// This hit component is ignored by our InTraceChannel (or our trace's collision response params ignore the component)
+				return false;
+			});
+	}
+
+	// Make the hits relative to the whole scene cast before the caller's IsHitImpenetrable sees them
+	for (FHitResult& ChunkHit : InOutChunkHitResults)
+	{
+		if (ChunkHit.bStartPenetrating)
+		{
+			ChunkHit.TraceEnd = InEnd; // initial overlaps keep their distance of 0
+			continue;
+		}
+
+		MakeHitDataRelativeToForwardsSceneCast(ChunkHit, InStart, InEnd);
+	}
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::MakePenetrationSceneCastParams(FCollisionQueryParams& OutCollisionQueryParams, FCollisionResponseParams& OutCollisionResponseParams, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams)
+{
+	// Use ECR_Overlap to have this scene cast overlap through blocking hits. Our CollisionResponseParams overrides blocking responses to overlap.
+	OutCollisionResponseParams = InCollisionResponseParams;
+	OutCollisionResponseParams.CollisionResponse.ReplaceChannels(ECollisionResponse::ECR_Block, ECollisionResponse::ECR_Overlap);
+
+	// Ensure our collision query params do NOT ignore overlaps because we are scene casting as an ECR_Overlap (otherwise, we wouldn't get any Hit Results)
+	OutCollisionQueryParams = InCollisionQueryParams;
+	OutCollisionQueryParams.bIgnoreTouches = false;
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::ChangeHitsResponseData(TArray<FHitResult>& InOutHits, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, FHitsResponseCache* InOutResponseCache)
+{
+	GC_QUERY_SCOPE(STAT_GCChangeHitsResponseData);
+
+	// Penetration scene casts often hit the same body several times (entrance and exit, multiple shapes of a body, etc.). Remember each body's response so we only resolve it once.
+	// The trace channel and response params are the same for all of these hits, so the body is enough of a key. They can change between calls though, so start empty (Reset() keeps the memory).
+	FHitsResponseCache TemporaryResponseCache;
+	FHitsResponseCache& ResponseCache = (InOutResponseCache ? *InOutResponseCache : TemporaryResponseCache);
+	ResponseCache.Reset();
+
+	// Kept hits get moved down over the removed ones (stable, and only one pass through the array)
+	int32 NumKeptHits = 0;
+	for (int32 i = 0; i < InOutHits.Num(); ++i)
+	{
+		FHitResult& HitResult = InOutHits[i];
+		bool bKeepHit = true;
+
+		// Emulate the use of a Trace Channel and Collision Response Params by manually assigning FHitResult::bBlockingHit and removing any hits that are ignored
+		if (const UPrimitiveComponent* PrimitiveComponent = HitResult.Component.Get())
+		{
+			const TPair<const UPrimitiveComponent*, FName> BodyKey = TPair<const UPrimitiveComponent*, FName>(PrimitiveComponent, HitResult.BoneName);
+
+			ECollisionResponse ResponseForHit;
+			if (const ECollisionResponse* CachedResponse = ResponseCache.Find(BodyKey))
+			{
+				ResponseForHit = *CachedResponse;
+			}
+			else
+			{
+				const FBodyInstance* HitBody = PrimitiveComponent->GetBodyInstance(HitResult.BoneName);
+				ResponseForHit = (HitBody ? GetCollisionResponseForQueryOnBodyInstance(*HitBody, InTraceChannel, InCollisionResponseParams) : ECollisionResponse::ECR_MAX); // ECR_MAX for no body means leave the hit alone
+				ResponseCache.Add(BodyKey, ResponseForHit);
+			}
+
+			if (ResponseForHit == ECollisionResponse::ECR_Block)
+			{
+				// This hit component blocks our InTraceChannel (or our trace's collision response params block the component)
+				HitResult.bBlockingHit = true;
+
+				// Ignore block
+				bKeepHit = !InCollisionQueryParams.bIgnoreBlocks;
+			}
+			else if (ResponseForHit == ECollisionResponse::ECR_Overlap)
+			{
+				// This hit component overlaps our InTraceChannel (or our trace's collision response params overlap the component)
+				HitResult.bBlockingHit = false;
+
+				// Ignore touch
+				bKeepHit = !InCollisionQueryParams.bIgnoreTouches;
+			}
+			else if (ResponseForHit == ECollisionResponse::ECR_Ignore)
+			{
+				// This hit component is ignored by our InTraceChannel (or our trace's collision response params ignore the component)
+
+				// Ignore this hit
+				bKeepHit = false;
+			}
+		}
+
+		if (bKeepHit)
+		{
+			if (NumKeptHits != i)
+			{
+				InOutHits[NumKeptHits] = MoveTemp(HitResult);
+			}
+			++NumKeptHits;
+		}
+	}
+
+	InOutHits.SetNum(NumKeptHits, false); // don't shrink so that reused arrays keep their memory
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::FindExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FHitResult* InHitStoppedAt, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bInPenetrate, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	GC_QUERY_SCOPE(STAT_GCFindExitHits);
+
+	const TArray<FHitResult>& EntranceHitResults = InOutScratch.EntranceHitResults;
+	TArray<FHitResult>& ExitHitResults = InOutScratch.ExitHitResults;
+	TArray<FHitResult>& SimpleBodyExitHitResults = InOutScratch.SimpleBodyExitHitResults;
+
+	const FVector BackwardsStart = DetermineBackwardsSceneCastStart(EntranceHitResults, InStart, InEnd, InHitStoppedAt, bOptimizeBackwardsSceneCastLength, UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(InCollisionShape), InFurthestPossibleExitMethod, &InOutScratch.FurthestPossibleExitWorkingMemory);
+	InOutScratch.BackwardsStart = BackwardsStart;
+#if ENABLE_DRAW_DEBUG
+	if (bDrawDebugForBackwardsStart)
+	{
+		const FVector BackwardsDir = (InStart - BackwardsStart).GetSafeNormal();
+		DrawDebugForBackwardsStart(InWorld, InCollisionShape, InRotation, BackwardsStart, BackwardsDir);
+	}
+#endif // ENABLE_DRAW_DEBUG
+
 
-					// Ignore this hit
-					InOutHits.RemoveAt(i);
-					--i;
-					continue;
+	// Exits found by querying bodies directly. Identified by their component and bone so that a backwards scene cast doesn't find them a second time.
+	TArray<TPair<const UPrimitiveComponent*, FName>, TInlineAllocator<16>>& BodiesWithExitsFound = InOutScratch.BodiesWithExitsFound;
+	bool bNeedsBackwardsSceneCast = true;
+
+	if (InExitHitsMethod == EExitHitsMethod::SimpleBodyQueries)
+	{
+		bNeedsBackwardsSceneCast = false;
+
+		const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+		const float ForwardsLength = FVector::Distance(InStart, InEnd);
+		const float BackwardsStartDistance = FVector::DotProduct(ForwardsDir, (BackwardsStart - InStart)); // a backwards scene cast would not have found any exits past this
+
+		SimpleBodyExitHitResults.Reserve(EntranceHitResults.Num());
+		for (const FHitResult& EntranceHit : EntranceHitResults)
+		{
+			const UPrimitiveComponent* HitComponent = EntranceHit.Component.Get();
+			const FBodyInstance* HitBody = (HitComponent ? HitComponent->GetBodyInstance(EntranceHit.BoneName) : nullptr);
+			const TPair<const UPrimitiveComponent*, FName> BodyKey = TPair<const UPrimitiveComponent*, FName>(HitComponent, EntranceHit.BoneName);
+
+			if (!HitBody || !CanFindExitHitBySimpleBodyQuery(*HitBody, InCollisionQueryParams.bTraceComplex) || BodiesWithExitsFound.Contains(BodyKey))
+			{
+				// This one is up to the backwards scene cast
+				bNeedsBackwardsSceneCast = true;
+				continue;
+			}
+
+			FHitResult ExitHit;
+			if (FindExitHitBySimpleBodyQuery(ExitHit, *HitBody, EntranceHit, InStart, ForwardsDir, ForwardsLength, InRotation, InCollisionShape))
+			{
+				if (ExitHit.Distance < BackwardsStartDistance)
+				{
+					SimpleBodyExitHitResults.Add(ExitHit);
 				}
 			}
+			BodiesWithExitsFound.Add(BodyKey);
+		}
+
+		if (bNeedsBackwardsSceneCast)
+		{
+			// Only the unsupported bodies are left for the backwards scene cast. Stop it from finding the ones we already have.
+			BodiesWithExitsFound.Reset();
+			for (const FHitResult& ExitHit : SimpleBodyExitHitResults)
+			{
+				BodiesWithExitsFound.Emplace(ExitHit.Component.Get(), ExitHit.BoneName);
+			}
+		}
+	}
+
+
+	if (InExitHitsMethod == EExitHitsMethod::BoundedBackwardsSceneCasts)
+	{
+		FindExitHitsByBoundedBackwardsSceneCasts(InOutScratch, InWorld, BackwardsStart, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionResponseParams, bInPenetrate, InFurthestPossibleExitMethod);
+	}
+	else if (bNeedsBackwardsSceneCast)
+	{
+		ExitHitResults.Reserve(EntranceHitResults.Num());
+		if (bInPenetrate)
+		{
+			PenetrationSceneCastWithPenetrationParams(InWorld, ExitHitResults, BackwardsStart, InStart, InRotation, InTraceChannel, InCollisionShape, InOutScratch.PenetrationBackwardsCollisionQueryParams, InOutScratch.PenetrationCollisionResponseParams, InOutScratch.BackwardsCollisionQueryParams, InCollisionResponseParams, NeverImpenetrable, &InOutScratch.ResponseCache);
+		}
+		else
+		{
+			SceneCastMultiByChannel(InWorld, ExitHitResults, BackwardsStart, InStart, InRotation, InTraceChannel, InCollisionShape, InOutScratch.BackwardsCollisionQueryParams, InCollisionResponseParams);
+		}
+
+		MakeBackwardsHitsDataRelativeToForwadsSceneCast(ExitHitResults, EntranceHitResults);
+
+		if (SimpleBodyExitHitResults.Num() > 0)
+		{
+			ExitHitResults.RemoveAll([&BodiesWithExitsFound](const FHitResult& ExitHit)
+				{
+					return BodiesWithExitsFound.Contains(TPair<const UPrimitiveComponent*, FName>(ExitHit.Component.Get(), ExitHit.BoneName));
+				});
+		}
+	}
+
+	if (SimpleBodyExitHitResults.Num() > 0)
+	{
+		// Put our exits in the same order as a backwards scene cast would have found them
+		ExitHitResults.Append(SimpleBodyExitHitResults);
+		ExitHitResults.StableSort([](const FHitResult& A, const FHitResult& B)
+			{
+				return A.Distance > B.Distance;
+			});
+	}
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::FindExitHitsByBoundedBackwardsSceneCasts(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FVector& InBackwardsStart, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionResponseParams& InCollisionResponseParams, const bool bInPenetrate, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod)
+{
+	const TArray<FHitResult>& EntranceHitResults = InOutScratch.EntranceHitResults;
+	TArray<FHitResult>& ExitHitResults = InOutScratch.ExitHitResults;
+	TArray<FHitResult>& SpanExitHitResults = InOutScratch.SpanExitHitResults;
+
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	const float ShapeBoundingSphereRadius = UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(InCollisionShape);
+	const float BackwardsStartDistance = FVector::DotProduct(ForwardsDir, (InBackwardsStart - InStart)); // a backwards scene cast would not have found any exits past this
+
+	TArray<float, TInlineAllocator<32>>& FurthestPossibleExitDistances = InOutScratch.FurthestPossibleExitWorkingMemory.FurthestPossibleExitDistances;
+	FurthestPossibleExitDistances.SetNumUninitialized(EntranceHitResults.Num(), false);
+	CalculateFurthestPossibleExitDistances(FurthestPossibleExitDistances, EntranceHitResults, InStart, ForwardsDir, ShapeBoundingSphereRadius, InFurthestPossibleExitMethod, InOutScratch.FurthestPossibleExitWorkingMemory);
+
+	// Each entrance's geometry spans from its entrance to its furthest possible exit. Group the spans that overlap so that each group gets a single backwards scene cast.
+	// The entrances are in forwards order so each span starts at or after the previous one.
+	TArray<TPair<float, float>, TInlineAllocator<16>>& Spans = InOutScratch.Spans; // start and end distances along the forwards scene cast
+	for (int32 i = 0; i < EntranceHitResults.Num(); ++i)
+	{
+		const float EntranceDistance = FVector::DotProduct(ForwardsDir, (EntranceHitResults[i].Location - InStart));
+		const float SpanStart = FMath::Max(EntranceDistance - SceneCastStartWallAvoidancePadding, 0.f); // end the backwards scene cast a little before the entrance so that exits on top of it (very thin geometry) are found
+		const float SpanEnd = FMath::Min(FurthestPossibleExitDistances[i] + ShapeBoundingSphereRadius + SceneCastStartWallAvoidancePadding, BackwardsStartDistance);
+		if (SpanEnd <= SpanStart)
+		{
+			// Nothing to find (e.g. the hit that stopped us)
+			continue;
 		}
+
+		if (Spans.Num() > 0 && SpanStart <= Spans.Last().Value)
+		{
+			// Overlaps the previous span, so extend it
+			Spans.Last().Value = FMath::Max(Spans.Last().Value, SpanEnd);
+			continue;
+		}
+
+		Spans.Emplace(SpanStart, SpanEnd);
+	}
+
+	// Cast the furthest span first so that the exits come out in the same order as a single backwards scene cast would have found them
+	ExitHitResults.Reserve(EntranceHitResults.Num());
+	for (int32 SpanIndex = Spans.Num() - 1; SpanIndex >= 0; --SpanIndex)
+	{
+		const FVector SpanBackwardsStart = InStart + (ForwardsDir * Spans[SpanIndex].Value);
+		const FVector SpanBackwardsEnd = InStart + (ForwardsDir * Spans[SpanIndex].Key);
+
+		SpanExitHitResults.Reset();
+		if (bInPenetrate)
+		{
+			PenetrationSceneCastWithPenetrationParams(InWorld, SpanExitHitResults, SpanBackwardsStart, SpanBackwardsEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.PenetrationBackwardsCollisionQueryParams, InOutScratch.PenetrationCollisionResponseParams, InOutScratch.BackwardsCollisionQueryParams, InCollisionResponseParams, NeverImpenetrable, &InOutScratch.ResponseCache);
+		}
+		else
+		{
+			SceneCastMultiByChannel(InWorld, SpanExitHitResults, SpanBackwardsStart, SpanBackwardsEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.BackwardsCollisionQueryParams, InCollisionResponseParams);
+		}
+
+		for (FHitResult& ExitHit : SpanExitHitResults)
+		{
+			MakeHitDataRelativeToForwardsSceneCast(ExitHit, InStart, InEnd);
+			ExitHitResults.Add(MoveTemp(ExitHit));
+		}
+	}
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::MakeHitDataRelativeToForwardsSceneCast(FHitResult& InOutHitResult, const FVector& InStart, const FVector& InEnd)
+{
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	const float ForwardsLength = FVector::Distance(InStart, InEnd);
+
+	InOutHitResult.TraceStart = InStart;
+	InOutHitResult.TraceEnd = InEnd;
+	InOutHitResult.Distance = FVector::DotProduct(ForwardsDir, (InOutHitResult.Location - InStart));
+	InOutHitResult.Time = (ForwardsLength > 0.f ? (InOutHitResult.Distance / ForwardsLength) : 0.f);
+}
+
+bool UGCBlueprintFunctionLibrary_CollisionQueries::CanFindExitHitBySimpleBodyQuery(const FBodyInstance& InBodyInstance, const bool bInTraceComplex)
+{
+	if (InBodyInstance.WeldParent)
+	{
+		// Welded bodies have their shapes on the parent's physics actor
+		return false;
+	}
+
+	const UBodySetup* BodySetup = InBodyInstance.GetBodySetup();
+	if (!BodySetup)
+	{
+		// E.g. landscape
+		return false;
+	}
+
+	const ECollisionTraceFlag CollisionTraceFlag = BodySetup->GetCollisionTraceFlag();
+	if (CollisionTraceFlag == ECollisionTraceFlag::CTF_UseComplexAsSimple)
+	{
+		return false;
+	}
+	if (bInTraceComplex && CollisionTraceFlag != ECollisionTraceFlag::CTF_UseSimpleAsComplex)
+	{
+		// The scene cast would be testing against complex collision
+		return false;
+	}
+
+	// Only a single convex element is guaranteed to have exactly one exit for our entrance. Multiple elements can have several entrances and exits along the way.
+	const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+	const int32 NumSupportedElements = AggGeom.SphereElems.Num() + AggGeom.BoxElems.Num() + AggGeom.SphylElems.Num() + AggGeom.ConvexElems.Num();
+	return (NumSupportedElements == 1 && AggGeom.GetElementCount() == 1);
+}
+
+bool UGCBlueprintFunctionLibrary_CollisionQueries::FindExitHitBySimpleBodyQuery(FHitResult& OutExitHit, const FBodyInstance& InBodyInstance, const FHitResult& InEntranceHit, const FVector& InStart, const FVector& InForwardsDir, const float InForwardsLength, const FQuat& InRotation, const FCollisionShape& InCollisionShape)
+{
+	// Start past the furthest possible exit of this body and come back to the entrance
+	const FBox BodyBounds = InBodyInstance.GetBodyBounds();
+	const float BodyBoundingDiameter = (BodyBounds.GetExtent().Size() * 2);
+	const float ShapeBoundingSphereRadius = UGCBlueprintFunctionLibrary_MathHelpers::GetCollisionShapeBoundingSphereRadius(InCollisionShape);
+
+	const FVector QueryEnd = (InEntranceHit.bStartPenetrating ? InStart : InEntranceHit.Location);
+	const FVector QueryStart = QueryEnd + (InForwardsDir * (BodyBoundingDiameter + ShapeBoundingSphereRadius + SceneCastStartWallAvoidancePadding));
+
+	INC_DWORD_STAT(STAT_GCBodyQueriesIssued);
+	FGCQueryHeatmap::CountSceneCast();
+
+	FHitResult BodyHit;
+	bool bHit;
+	if (InCollisionShape.IsLine())
+	{
+		bHit = InBodyInstance.LineTrace(BodyHit, QueryStart, QueryEnd, false);
+	}
+	else
+	{
+		bHit = InBodyInstance.Sweep(BodyHit, QueryStart, QueryEnd, InRotation, InCollisionShape, false);
+	}
+
+	if (!bHit || BodyHit.bStartPenetrating)
+	{
+		return false;
 	}
+
+	// Our exit hit is the same body as the entrance, so start from it
+	OutExitHit = InEntranceHit;
+	OutExitHit.bStartPenetrating = false;
+	OutExitHit.PenetrationDepth = 0.f;
+	OutExitHit.Location = BodyHit.Location;
+	OutExitHit.ImpactPoint = BodyHit.ImpactPoint;
+	OutExitHit.Normal = BodyHit.Normal;
+	OutExitHit.ImpactNormal = BodyHit.ImpactNormal;
+	OutExitHit.FaceIndex = BodyHit.FaceIndex;
+
+	// Make the data relative to the forwards scene cast
+	OutExitHit.Distance = FVector::DotProduct(InForwardsDir, (OutExitHit.Location - InStart));
+	OutExitHit.Time = (InForwardsLength > 0.f ? (OutExitHit.Distance / InForwardsLength) : 0.f);
+	return true;
 }
 
-FVector UGCBlueprintFunctionLibrary_CollisionQueries::DetermineBackwardsSceneCastStart(const TArray<FHitResult>& InForwardsHitResults, const FVector& InForwardsStart, const FVector& InForwardsEnd, const FHitResult* InHitStoppedAt, const bool bOptimizeBackwardsSceneCastLength, const float InSweepShapeBoundingSphereRadius)
+FVector UGCBlueprintFunctionLibrary_CollisionQueries::DetermineBackwardsSceneCastStart(const TArray<FHitResult>& InForwardsHitResults, const FVector& InForwardsStart, const FVector& InForwardsEnd, const FHitResult* InHitStoppedAt, const bool bOptimizeBackwardsSceneCastLength, const float InSweepShapeBoundingSphereRadius, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, FFurthestPossibleExitWorkingMemory* InOutWorkingMemory)
 {
 	const FVector ForwardDir = (InForwardsEnd - InForwardsStart).GetSafeNormal();
 	
@@ -299,25 +1063,20 @@ FVector UGCBlueprintFunctionLibrary_CollisionQueries::DetermineBackwardsSceneCas
 	// the last exit location but of course we don't have our exit locations yet. But we CAN calculate the furthest possible exit location for each of our entrance points and choose the largest among them.
 
 	// Find the furthest exit location that could possibly happen for each entrance hit and choose the furthest among them
-	FVector TheFurthestPossibleExitLocation = InForwardsStart;
-	for (const FHitResult& HitResult : InForwardsHitResults)
-	{
-		if (const UPrimitiveComponent* HitComponent = HitResult.Component.Get())
-		{
-			const float MyBoundingDiameter = (HitComponent->Bounds.SphereRadius * 2);
-			const FVector MyFurthestPossibleExitLocation = HitResult.Location + (ForwardDir * MyBoundingDiameter);
+	FFurthestPossibleExitWorkingMemory TemporaryWorkingMemory;
+	FFurthestPossibleExitWorkingMemory& WorkingMemory = (InOutWorkingMemory ? *InOutWorkingMemory : TemporaryWorkingMemory);
+	TArray<float, TInlineAllocator<32>>& FurthestPossibleExitDistances = WorkingMemory.FurthestPossibleExitDistances;
+	FurthestPossibleExitDistances.SetNumUninitialized(InForwardsHitResults.Num(), false);
+	CalculateFurthestPossibleExitDistances(FurthestPossibleExitDistances, InForwardsHitResults, InForwardsStart, ForwardDir, InSweepShapeBoundingSphereRadius, InFurthestPossibleExitMethod, WorkingMemory);
 
-			// If my point is after the currently believed furthest point
-			const bool bMyPointIsFurther = FVector::DotProduct(ForwardDir, (MyFurthestPossibleExitLocation - TheFurthestPossibleExitLocation)) > 0;
-			if (bMyPointIsFurther)
-			{
-				TheFurthestPossibleExitLocation = MyFurthestPossibleExitLocation;
-			}
-		}
+	float TheFurthestPossibleExitDistance = 0.f;
+	for (const float FurthestPossibleExitDistance : FurthestPossibleExitDistances)
+	{
+		TheFurthestPossibleExitDistance = FMath::Max(TheFurthestPossibleExitDistance, FurthestPossibleExitDistance);
 	}
 
 	// The optimal backwards start gives a minimal scene cast distance that can still cover the furthest possible exit location
-	FVector OptimizedBackwardsSceneCastStart = TheFurthestPossibleExitLocation;
+	FVector OptimizedBackwardsSceneCastStart = InForwardsStart + (ForwardDir * TheFurthestPossibleExitDistance);
 	// Bump us forwards to ensure a potential exit at the furthest possible exit location can get hit properly
 	OptimizedBackwardsSceneCastStart += (ForwardDir * InSweepShapeBoundingSphereRadius); // bump us forwards by any sweep shapes' bounding sphere radius so that the sweep geometry starts past TheFurthestPossibleExitLocation
 	OptimizedBackwardsSceneCastStart += (ForwardDir * SceneCastStartWallAvoidancePadding); // bump us forwards by the SceneCastStartWallAvoidancePadding so that backwards scene cast does not start on top of TheFurthestPossibleExitLocation
@@ -333,6 +1092,108 @@ FVector UGCBlueprintFunctionLibrary_CollisionQueries::DetermineBackwardsSceneCas
 	return OptimizedBackwardsSceneCastStart;
 }
 
+void UGCBlueprintFunctionLibrary_CollisionQueries::CalculateFurthestPossibleExitDistances(TArrayView<float> OutFurthestPossibleExitDistances, const TArray<FHitResult>& InForwardsHitResults, const FVector& InForwardsStart, const FVector& InForwardsDir, const float InSweepShapeBoundingSphereRadius, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, FFurthestPossibleExitWorkingMemory& InOutWorkingMemory)
+{
+	check(OutFurthestPossibleExitDistances.Num() == InForwardsHitResults.Num());
+	const int32 NumHits = InForwardsHitResults.Num();
+
+	if (InFurthestPossibleExitMethod == EFurthestPossibleExitMethod::BoundingSphere)
+	{
+		for (int32 i = 0; i < NumHits; ++i)
+		{
+			const FHitResult& HitResult = InForwardsHitResults[i];
+			const float EntranceDistance = FVector::DotProduct(InForwardsDir, (HitResult.Location - InForwardsStart));
+
+			const UPrimitiveComponent* HitComponent = HitResult.Component.Get();
+			const float MyBoundingDiameter = (HitComponent ? (HitComponent->Bounds.SphereRadius * 2) : 0.f);
+			OutFurthestPossibleExitDistances[i] = EntranceDistance + MyBoundingDiameter;
+		}
+		return;
+	}
+
+
+	// Each hit's box is described by its 3 slabs (an axis, the entrance's offset from the box center along that axis, and the box extent along that axis).
+	// These are gathered into flat arrays so that the ray-box intersections below are a single branchless loop over floats, which the compiler can vectorize for many entrance hits.
+	TArray<float, TInlineAllocator<32>>& EntranceDistances = InOutWorkingMemory.EntranceDistances;
+	TArray<float, TInlineAllocator<32>>& FallbackDistances = InOutWorkingMemory.FallbackDistances;
+	TArray<float, TInlineAllocator<32>>* SlabOffsets = InOutWorkingMemory.SlabOffsets;
+	TArray<float, TInlineAllocator<32>>* SlabDirs = InOutWorkingMemory.SlabDirs;
+	TArray<float, TInlineAllocator<32>>* SlabExtents = InOutWorkingMemory.SlabExtents;
+	// Don't shrink so that reused lists keep their memory
+	EntranceDistances.SetNumUninitialized(NumHits, false);
+	FallbackDistances.SetNumUninitialized(NumHits, false);
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		SlabOffsets[Axis].SetNumUninitialized(NumHits, false);
+		SlabDirs[Axis].SetNumUninitialized(NumHits, false);
+		SlabExtents[Axis].SetNumUninitialized(NumHits, false);
+	}
+
+	for (int32 i = 0; i < NumHits; ++i)
+	{
+		const FHitResult& HitResult = InForwardsHitResults[i];
+		EntranceDistances[i] = FVector::DotProduct(InForwardsDir, (HitResult.Location - InForwardsStart));
+
+		FVector BoxCenter = HitResult.Location;
+		FVector BoxAxes[3] = { FVector::XAxisVector, FVector::YAxisVector, FVector::ZAxisVector };
+		FVector BoxExtent = FVector::ZeroVector; // a hit without a component is a box of nothing, so it can't be exited past itself
+		FallbackDistances[i] = 0.f;
+
+		if (const UPrimitiveComponent* HitComponent = HitResult.Component.Get())
+		{
+			FallbackDistances[i] = (HitComponent->Bounds.SphereRadius * 2);
+
+			const FBodyInstance* HitBody = (HitResult.BoneName != NAME_None ? HitComponent->GetBodyInstance(HitResult.BoneName) : nullptr);
+			if (HitBody)
+			{
+				// Per-body bounds (world aligned) are much tighter than the whole component's, e.g. for skeletal meshes
+				const FBox BodyBounds = HitBody->GetBodyBounds();
+				BoxCenter = BodyBounds.GetCenter();
+				BoxExtent = BodyBounds.GetExtent();
+			}
+			else
+			{
+				const FTransform& ComponentTransform = HitComponent->GetComponentTransform();
+				const FBoxSphereBounds LocalBounds = HitComponent->CalcLocalBounds();
+
+				BoxCenter = ComponentTransform.TransformPosition(LocalBounds.Origin);
+				BoxAxes[0] = ComponentTransform.GetUnitAxis(EAxis::X);
+				BoxAxes[1] = ComponentTransform.GetUnitAxis(EAxis::Y);
+				BoxAxes[2] = ComponentTransform.GetUnitAxis(EAxis::Z);
+				BoxExtent = LocalBounds.BoxExtent * ComponentTransform.GetScale3D().GetAbs();
+			}
+
+			// A sweep's location is the center of its shape, which can be outside of the geometry by the size of the shape
+			BoxExtent += FVector(InSweepShapeBoundingSphereRadius + SceneCastStartWallAvoidancePadding);
+		}
+
+		const FVector EntranceOffset = (HitResult.Location - BoxCenter);
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			SlabOffsets[Axis][i] = FVector::DotProduct(BoxAxes[Axis], EntranceOffset);
+			SlabDirs[Axis][i] = FVector::DotProduct(BoxAxes[Axis], InForwardsDir);
+			SlabExtents[Axis][i] = BoxExtent[Axis];
+		}
+	}
+
+	// Ray-box intersection using the slab method. We start inside of the box (at the entrance) so we only care about where we leave it (the nearest of the slabs' far sides).
+	for (int32 i = 0; i < NumHits; ++i)
+	{
+		float ExitTime = BIG_NUMBER;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const float Dir = SlabDirs[Axis][i];
+			const float SafeDir = (Dir >= 0.f ? FMath::Max(Dir, KINDA_SMALL_NUMBER) : FMath::Min(Dir, -KINDA_SMALL_NUMBER)); // parallel to the slab means we never leave it
+			const float TimeA = (-SlabExtents[Axis][i] - SlabOffsets[Axis][i]) / SafeDir;
+			const float TimeB = (SlabExtents[Axis][i] - SlabOffsets[Axis][i]) / SafeDir;
+			ExitTime = FMath::Min(ExitTime, FMath::Max(TimeA, TimeB));
+		}
+
+		// A negative exit time means the entrance wasn't actually in the box (the bounds don't fully contain the collision). Don't trust it and fall back to the bounding sphere.
+		OutFurthestPossibleExitDistances[i] = EntranceDistances[i] + (ExitTime >= 0.f ? ExitTime : FallbackDistances[i]);
+	}
+}
+
 void UGCBlueprintFunctionLibrary_CollisionQueries::MakeBackwardsHitsDataRelativeToForwadsSceneCast(TArray<FHitResult>& InOutBackwardsHitResults, const TArray<FHitResult>& InForwardsHitResults)
 {
 	if (InOutBackwardsHitResults.Num() > 0)
@@ -361,8 +1222,30 @@ void UGCBlueprintFunctionLibrary_CollisionQueries::MakeBackwardsHitsDataRelative
 
 void UGCBlueprintFunctionLibrary_CollisionQueries::OrderHitResultsInForwardsDirection(TArray<FExitAwareHitResult>& OutOrderedHitResults, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InForwardsDirection)
 {
-	OutOrderedHitResults.Reserve(InEntranceHitResults.Num() + InExitHitResults.Num());
+	GC_QUERY_SCOPE(STAT_GCOrderHitsInForwardsDirection);
+
+	OutOrderedHitResults.Reserve(OutOrderedHitResults.Num() + InEntranceHitResults.Num() + InExitHitResults.Num());
+
+	ForEachHitInForwardsDirection(InEntranceHitResults, InExitHitResults, InForwardsDirection, [&OutOrderedHitResults](const FHitResult& InHitResult, const bool bInIsExitHit)
+		{
+			FExitAwareHitResult& HitResult = OutOrderedHitResults.Emplace_GetRef(InHitResult);
+			HitResult.bIsExitHit = bInIsExitHit;
+		});
+}
+void UGCBlueprintFunctionLibrary_CollisionQueries::OrderHitResultsInForwardsDirection(TArray<FCompactHitRecord>& OutOrderedHitRecords, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InForwardsDirection)
+{
+	GC_QUERY_SCOPE(STAT_GCOrderHitsInForwardsDirection);
 
+	OutOrderedHitRecords.Reserve(OutOrderedHitRecords.Num() + InEntranceHitResults.Num() + InExitHitResults.Num());
+
+	ForEachHitInForwardsDirection(InEntranceHitResults, InExitHitResults, InForwardsDirection, [&OutOrderedHitRecords](const FHitResult& InHitResult, const bool bInIsExitHit)
+		{
+			OutOrderedHitRecords.Emplace(InHitResult, bInIsExitHit);
+		});
+}
+
+void UGCBlueprintFunctionLibrary_CollisionQueries::ForEachHitInForwardsDirection(const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InForwardsDirection, const TFunctionRef<void(const FHitResult&, const bool)>& InFunction)
+{
 	int32 EntranceIndex = 0;
 	int32 ExitIndex = InExitHitResults.Num() - 1;
 	while (EntranceIndex < InEntranceHitResults.Num() || ExitIndex >= 0) // build our return value
@@ -384,18 +1267,14 @@ void UGCBlueprintFunctionLibrary_CollisionQueries::OrderHitResultsInForwardsDire
 		if (bEntranceIsNext)
 		{
 			// Add this entrance hit
-			FExitAwareHitResult HitResult = InEntranceHitResults[EntranceIndex];
-			HitResult.bIsExitHit = false;
-			OutOrderedHitResults.Add(HitResult);
+			InFunction(InEntranceHitResults[EntranceIndex], false);
 			++EntranceIndex; // don't consider this entrance anymore because we added it to return value
 			continue;
 		}
 		else
 		{
 			// Add this exit hit
-			FExitAwareHitResult HitResult = InExitHitResults[ExitIndex];
-			HitResult.bIsExitHit = true;
-			OutOrderedHitResults.Add(HitResult);
+			InFunction(InExitHitResults[ExitIndex], true);
 			--ExitIndex; // don't consider this exit anymore because we added it to return value
 			continue;
 		}
@@ -4,7 +4,15 @@
 #include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_StrengthCollisionQueries.h"
 
 #include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_CollisionQueries.h"
-#include "BlueprintFunctionLibraries/GCBlueprintFunctionLibrary_HitResultHelpers.h"
+#include "DataAssets/GCBallisticsMaterialProfile.h"
+#include "Types/GCRangeFalloffTable.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/SoftObjectPath.h"
 
 
 
@@ -12,272 +20,507 @@ const TFunctionRef<float(const FHitResult&)>& UGCBlueprintFunctionLibrary_Streng
 const TFunctionRef<float(const FHitResult&)>& UGCBlueprintFunctionLibrary_StrengthCollisionQueries::DefaultGetRicochetNerf = [](const FHitResult&) { return 0.f; };
 const TFunctionRef<bool(const FHitResult&)>& UGCBlueprintFunctionLibrary_StrengthCollisionQueries::DefaultIsHitRicochetable = [](const FHitResult&) { return false; };
 
+/**
+ * Policies that call the caller's TFunctionRefs, so that the callback versions of the queries share the policy implementation
+ */
+struct FGCFunctionRefPenetrationNerfPolicy
+{
+	static constexpr bool bHasPenetrationNerf = true;
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerfFunction;
+	float GetPerCmPenetrationNerf(const FHitResult& InHit) const { return GetPerCmPenetrationNerfFunction(InHit); }
+};
+struct FGCFunctionRefImpenetrablePolicy
+{
+	static constexpr bool bCanBeImpenetrable = true;
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrableFunction;
+	bool IsHitImpenetrable(const FHitResult& InHit) const { return IsHitImpenetrableFunction(InHit); }
+};
+struct FGCFunctionRefRicochetPolicy
+{
+	static constexpr bool bCanRicochet = true;
+	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerfFunction;
+	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetableFunction;
+	float GetRicochetNerf(const FHitResult& InHit) const { return GetRicochetNerfFunction(InHit); }
+	bool IsHitRicochetable(const FHitResult& InHit) const { return IsHitRicochetableFunction(InHit); }
+};
+
+static FAutoConsoleCommandWithWorldAndArgs GCStrengthQueriesCursorSplitCheckCommand(
+	TEXT("GC.StrengthQueries.CursorSplitCheck"),
+	TEXT("Checks that ricocheting strength queries in this world give the same results when split into two advances. Args: [NumQueries=100] [Distance=10000] [Radius=5000 (around the origin)] [Seed=1]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor::RunSplitCheck));
+
 //  BEGIN Custom query
-FStrengthHitResult* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, TArray<float>& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+FStrengthHitResult* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
 	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable)
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
 {
-	OutResult.StrengthSceneCastInfo.CollisionShapeCasted = InCollisionShape;
-	OutResult.StrengthSceneCastInfo.CollisionShapeCastedRotation = InRotation;
-	OutResult.StrengthSceneCastInfo.StartLocation = InStart;
-	OutResult.StrengthSceneCastInfo.StartStrength = InInitialStrength;
-	OutResult.StrengthSceneCastInfo.CastDirection = (InEnd - InStart).GetSafeNormal();
+	return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefImpenetrablePolicy{ IsHitImpenetrable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+FStrengthHitResult* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FPenetrationNerfStack PerCmStrengthNerfStack = FPenetrationNerfStack(InRangeFalloffNerf);
+	return PenetrationSceneCastWithExitHitsUsingStrength(InInitialStrength, PerCmStrengthNerfStack, InWorld, OutResult, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, GetPerCmPenetrationNerf, IsHitImpenetrable, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+FCompactHitRecord* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	OutResult.SceneCastEnd = InEnd;
+	return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitRecords, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefImpenetrablePolicy{ IsHitImpenetrable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+FStrengthHitResult* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InOutScratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.GetCollisionQueryParams(), InOutScratch.GetCollisionResponseParams(), FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefImpenetrablePolicy{ IsHitImpenetrable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+FCompactHitRecord* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	OutResult.SceneCastEnd = InEnd;
+	return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InOutScratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitRecords, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.GetCollisionQueryParams(), InOutScratch.GetCollisionResponseParams(), FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefImpenetrablePolicy{ IsHitImpenetrable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+FStrengthHitResult* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FCollisionQueryParams CollisionQueryParamsCopy;
+	const FCollisionQueryParams& CollisionQueryParams = GetQueryParamsReturningPhysicalMaterial(InCollisionQueryParams, CollisionQueryParamsCopy);
+	const FGCBallisticsMaterialProfilePolicy MaterialProfilePolicy = FGCBallisticsMaterialProfilePolicy(InMaterialProfile);
 
-	TArray<FExitAwareHitResult> HitResults;
-	FExitAwareHitResult* ImpenetrableHit = UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHits(InWorld, HitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, true);
+	return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, InCollisionResponseParams, MaterialProfilePolicy, MaterialProfilePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+FCompactHitRecord* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FCollisionQueryParams CollisionQueryParamsCopy;
+	const FCollisionQueryParams& CollisionQueryParams = GetQueryParamsReturningPhysicalMaterial(InCollisionQueryParams, CollisionQueryParamsCopy);
+	const FGCBallisticsMaterialProfilePolicy MaterialProfilePolicy = FGCBallisticsMaterialProfilePolicy(InMaterialProfile);
 
+	OutResult.SceneCastEnd = InEnd;
+	return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitRecords, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, InCollisionResponseParams, MaterialProfilePolicy, MaterialProfilePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+//  END Custom query
 
-	const FVector SceneCastDirection = (InEnd - InStart).GetSafeNormal();
-	const float SceneCastDistance = HitResults.Num() > 0 ? UGCBlueprintFunctionLibrary_HitResultHelpers::CheapCalculateTraceLength(HitResults.Last()) : FVector::Distance(InStart, InEnd);
+//  BEGIN Custom query
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmStrengthNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmStrengthNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefRicochetPolicy{ GetRicochetNerf, IsHitRicochetable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FPenetrationNerfStack PerCmStrengthNerfStack = FPenetrationNerfStack(InRangeFalloffNerf);
+	return RicochetingPenetrationSceneCastWithExitHitsUsingStrength(InInitialStrength, PerCmStrengthNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, GetPerCmPenetrationNerf, GetRicochetNerf, IsHitRicochetable, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FCollisionQueryParams CollisionQueryParamsCopy;
+	const FCollisionQueryParams& CollisionQueryParams = GetQueryParamsReturningPhysicalMaterial(InCollisionQueryParams, CollisionQueryParamsCopy);
+	const FGCBallisticsMaterialProfilePolicy MaterialProfilePolicy = FGCBallisticsMaterialProfilePolicy(InMaterialProfile);
 
-	float CurrentStrength = InInitialStrength;
+	RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, InCollisionResponseParams, InRicochetCap, MaterialProfilePolicy, MaterialProfilePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
 
-	// For this segment (from TraceStart to the first hit), apply strength nerfs and see if we ran out
-	{
-		// Calculate this segment's distance
-		float SegmentDistance;
-		if (HitResults.IsValidIndex(0))
-		{
-			SegmentDistance = HitResults[0].Distance;
-		}
-		else
-		{
-			// We casted into thin air - so use the distance of the whole scene cast
-			SegmentDistance = SceneCastDistance;
-		}
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmStrengthNerfStack, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	OutResult.Reset();
+	RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmStrengthNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefRicochetPolicy{ GetRicochetNerf, IsHitRicochetable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
+	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf,
+	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FPenetrationNerfStack PerCmStrengthNerfStack = FPenetrationNerfStack(InRangeFalloffNerf);
+	return RicochetingPenetrationSceneCastWithExitHitsUsingStrength(InInitialStrength, PerCmStrengthNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, GetPerCmPenetrationNerf, GetRicochetNerf, IsHitRicochetable, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FCollisionQueryParams CollisionQueryParamsCopy;
+	const FCollisionQueryParams& CollisionQueryParams = GetQueryParamsReturningPhysicalMaterial(InCollisionQueryParams, CollisionQueryParamsCopy);
+	const FGCBallisticsMaterialProfilePolicy MaterialProfilePolicy = FGCBallisticsMaterialProfilePolicy(InMaterialProfile);
 
-		// Calculate how much strength per cm we should be taking away for this segment
-		// Accumulate all of the strength nerfs from the InOutPerCmNerfStack
-		float StrengthToTakeAwayPerCm = 0.f;
-		for (const float& StrengthNerf : InOutPerCmNerfStack)
-		{
-			StrengthToTakeAwayPerCm += StrengthNerf;
-		}
+	OutResult.Reset();
+	RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, InCollisionResponseParams, InRicochetCap, MaterialProfilePolicy, MaterialProfilePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+//  END Custom query
 
-		// If we ran out of strength in this segment, stop adding further hits and return the stop location
-		const float TraveledThroughDistance = NerfStrengthPerCm(CurrentStrength, SegmentDistance, StrengthToTakeAwayPerCm);
-		if (CurrentStrength < 0.f)
-		{
-			OutResult.StrengthSceneCastInfo.StopLocation = InStart + (SceneCastDirection * TraveledThroughDistance);
-			OutResult.StrengthSceneCastInfo.TimeAtStop = TraveledThroughDistance / SceneCastDistance;
-			OutResult.StrengthSceneCastInfo.DistanceToStop = TraveledThroughDistance;
-			OutResult.StrengthSceneCastInfo.StopStrength = 0.f;
-			return nullptr;
-		}
-	}
+//  BEGIN Custom query
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(FRicochetingStrengthBatchContext& InOutContext, const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, const UGCBallisticsMaterialProfile& InMaterialProfile, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel)
+{
+	const FGCBallisticsMaterialProfilePolicy MaterialProfilePolicy = FGCBallisticsMaterialProfilePolicy(InMaterialProfile);
 
-	if (CurrentStrength > 0.f)
+	// The profile needs the hits' physical materials
+	const bool bAllQueriesReturnPhysicalMaterial = !InQueries.ContainsByPredicate([](const FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery& Query) { return !Query.CollisionQueryParams.bReturnPhysicalMaterial; });
+	if (bAllQueriesReturnPhysicalMaterial)
 	{
-		// Add found hit results to the OutStrengthHits
-		OutResult.HitResults.Reserve(HitResults.Num()); // assume that we will add all of the hits. But, there may end up being reserved space that goes unused if we run out of strength
-		for (int32 i = 0; i < HitResults.Num(); ++i) // loop through all hits, comparing each hit with the next so we can treat them as semgents
-		{
-			// Add this hit to our Strength hits
-			FStrengthHitResult& AddedStrengthHit = OutResult.HitResults.Add_GetRef(HitResults[i]);
-			AddedStrengthHit.Strength = CurrentStrength;
-
-			if (HitResults[i].bStartPenetrating)
-			{
-				// Initial overlaps would mess up our PerCmStrengthNerfStack so skip it
-				// Btw this is only a thing for simple collision queries
-				UE_LOG(LogGCStrengthCollisionQueries, Verbose, TEXT("%s() Penetration strength query started inside of something. Make sure to not start this query inside of geometry. We will not consider this hit for the penetration strength nerf stack but it will still be included in the outputed hits. Hit Actor: [%s]."), ANSI_TO_TCHAR(__FUNCTION__), GetData(HitResults[i].GetActor()->GetName()));
-				continue;
-			}
-
-			if (ImpenetrableHit && &HitResults[i] == ImpenetrableHit)
-			{
-				// Stop - don't calculate penetration nerfing on impenetrable hit
-				OutResult.StrengthSceneCastInfo.StopLocation = AddedStrengthHit.Location;
-				OutResult.StrengthSceneCastInfo.TimeAtStop = AddedStrengthHit.Time;
-				OutResult.StrengthSceneCastInfo.DistanceToStop = AddedStrengthHit.Distance;
-				OutResult.StrengthSceneCastInfo.StopStrength = FMath::Max(CurrentStrength, 0.f);
-				return &AddedStrengthHit;
-			}
-
-			// Update the InOutPerCmNerfStack with this hit
-			if (AddedStrengthHit.bIsExitHit == false)		// Add new nerf if we are entering something
-			{
-				InOutPerCmNerfStack.Push(GetPerCmPenetrationNerf(AddedStrengthHit));
-			}
-			else										// Remove most recent nerf if we are exiting something
-			{
-				const int32 IndexOfNerfThatWeAreExiting = InOutPerCmNerfStack.FindLast(GetPerCmPenetrationNerf(AddedStrengthHit));
-
-				if (IndexOfNerfThatWeAreExiting != INDEX_NONE)
-				{
-					InOutPerCmNerfStack.RemoveAt(IndexOfNerfThatWeAreExiting);
-				}
-				else
-				{
-					UE_LOG(LogGCStrengthCollisionQueries, Error, TEXT("%s() Exited a penetration nerf that was never entered. This must be the callers fault by his GetPenetrationStrengthNerf() not having consistent strength nerfs for entrances and exits. Hit Actor: [%s]."), ANSI_TO_TCHAR(__FUNCTION__), GetData(AddedStrengthHit.GetActor()->GetName()));
-				}
-			}
-
-			// For this segment (from this hit to the next hit), apply strength nerfs and see if we ran out
-			{
-				// Calculate this segment's distance
-				float SegmentDistance;
-				if (HitResults.IsValidIndex(i + 1))
-				{
-					// Get distance from this hit to the next hit
-					SegmentDistance = (HitResults[i + 1].Distance - AddedStrengthHit.Distance); // distance from [i] to [i + 1]
-				}
-				else
-				{
-					// Get distance from this hit to trace end
-					SegmentDistance = (SceneCastDistance - AddedStrengthHit.Distance);
-				}
-
-				// Calculate how much strength per cm we should be taking away for this segment
-				// Accumulate all of the strength nerfs from the InOutPerCmNerfStack
-				float StrengthToTakeAwayPerCm = 0.f;
-				for (const float& StrengthNerf : InOutPerCmNerfStack)
-				{
-					StrengthToTakeAwayPerCm += StrengthNerf;
-				}
-
-				// If we ran out of strength in this segment, stop adding further hits and return the stop location
-				const float TraveledThroughDistance = NerfStrengthPerCm(CurrentStrength, SegmentDistance, StrengthToTakeAwayPerCm);
-				if (CurrentStrength < 0.f)
-				{
-					OutResult.StrengthSceneCastInfo.StopLocation = AddedStrengthHit.Location + (SceneCastDirection * TraveledThroughDistance);
-					OutResult.StrengthSceneCastInfo.TimeAtStop = AddedStrengthHit.Time + (TraveledThroughDistance / SceneCastDistance);
-					OutResult.StrengthSceneCastInfo.DistanceToStop = AddedStrengthHit.Distance + TraveledThroughDistance;
-					OutResult.StrengthSceneCastInfo.StopStrength = 0.f;
-					return nullptr;
-				}
-			}
-		}
+		PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(InOutContext, InWorld, InQueries, OutResults, bInParallel, MaterialProfilePolicy, MaterialProfilePolicy);
+		return;
 	}
 
-	// CurrentStrength made it past every nerf
-	OutResult.StrengthSceneCastInfo.StopLocation = InEnd;
-	OutResult.StrengthSceneCastInfo.TimeAtStop = 1.f;
-	OutResult.StrengthSceneCastInfo.DistanceToStop = SceneCastDistance;
-	OutResult.StrengthSceneCastInfo.StopStrength = CurrentStrength;
-	return nullptr;
+	TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery> QueriesCopy = InQueries;
+	for (FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery& Query : QueriesCopy)
+	{
+		Query.CollisionQueryParams.bReturnPhysicalMaterial = true;
+	}
+	PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(InOutContext, InWorld, QueriesCopy, OutResults, bInParallel, MaterialProfilePolicy, MaterialProfilePolicy);
 }
-FStrengthHitResult* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
-	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable)
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, const UGCBallisticsMaterialProfile& InMaterialProfile, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel)
 {
-	TArray<float> PerCmStrengthNerfStack;
-	PerCmStrengthNerfStack.Push(InRangeFalloffNerf);
-	return PenetrationSceneCastWithExitHitsUsingStrength(InInitialStrength, PerCmStrengthNerfStack, InWorld, OutResult, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, GetPerCmPenetrationNerf, IsHitImpenetrable);
+	FRicochetingStrengthBatchContext Context;
+	RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(Context, InWorld, InQueries, InMaterialProfile, OutResults, bInParallel);
 }
 //  END Custom query
 
 //  BEGIN Custom query
-void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, TArray<float>& InOutPerCmStrengthNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+float UGCBlueprintFunctionLibrary_StrengthCollisionQueries::AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor& InOutCursor, const float InDistance, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InOutResult, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
 	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
 	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable)
+	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
 {
-	if (InDistanceCap <= 0.f)
-	{
-		check(0);
-		return;
-	}
+	return PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(InOutCursor, InDistance, InWorld, InOutResult, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, FGCFunctionRefPenetrationNerfPolicy{ GetPerCmPenetrationNerf }, FGCFunctionRefRicochetPolicy{ GetRicochetNerf, IsHitRicochetable }, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+float UGCBlueprintFunctionLibrary_StrengthCollisionQueries::AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor& InOutCursor, const float InDistance, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InOutResult, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	FCollisionQueryParams CollisionQueryParamsCopy;
+	const FCollisionQueryParams& CollisionQueryParams = GetQueryParamsReturningPhysicalMaterial(InCollisionQueryParams, CollisionQueryParamsCopy);
+	const FGCBallisticsMaterialProfilePolicy MaterialProfilePolicy = FGCBallisticsMaterialProfilePolicy(InMaterialProfile);
+
+	return PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(InOutCursor, InDistance, InWorld, InOutResult, InRotation, InTraceChannel, InCollisionShape, CollisionQueryParams, InCollisionResponseParams, MaterialProfilePolicy, MaterialProfilePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+}
+//  END Custom query
+
+FRicochetingStrengthSceneCastState UGCBlueprintFunctionLibrary_StrengthCollisionQueries::BeginRicochetingPenetrationSceneCast(FStrengthSceneCastInfo& OutStrengthSceneCastInfo, const float InInitialStrength, const FVector& InStart, const FVector& InDirection, const FQuat& InRotation, const FCollisionShape& InCollisionShape)
+{
+	OutStrengthSceneCastInfo.CollisionShapeCasted = InCollisionShape;
+	OutStrengthSceneCastInfo.CollisionShapeCastedRotation = InRotation;
+	OutStrengthSceneCastInfo.StartLocation = InStart;
+	OutStrengthSceneCastInfo.StartStrength = InInitialStrength;
+	OutStrengthSceneCastInfo.CastDirection = InDirection;
 
-	OutResult.StrengthSceneCastInfo.CollisionShapeCasted = InCollisionShape;
-	OutResult.StrengthSceneCastInfo.CollisionShapeCastedRotation = InRotation;
-	OutResult.StrengthSceneCastInfo.StartLocation = InStart;
-	OutResult.StrengthSceneCastInfo.StartStrength = InInitialStrength;
-	OutResult.StrengthSceneCastInfo.CastDirection = InDirection;
+	return FRicochetingStrengthSceneCastState(InStart, InDirection, InInitialStrength);
+}
 
-	FVector CurrentSceneCastStart = InStart;
-	FVector CurrentSceneCastDirection = InDirection;
-	float DistanceTraveled = 0.f;
-	float CurrentStrength = InInitialStrength;
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::FinishRicochetingPenetrationSceneCast(const FRicochetingStrengthSceneCastState& InState, FStrengthSceneCastInfo& OutStrengthSceneCastInfo, const float InDistanceCap)
+{
+	OutStrengthSceneCastInfo.StopStrength = InState.Strength;
+	OutStrengthSceneCastInfo.DistanceToStop = InState.DistanceTraveled;
+	OutStrengthSceneCastInfo.TimeAtStop = (InDistanceCap > 0.f) ? (InState.DistanceTraveled / InDistanceCap) : 0.f;
 
-	// The first iteration of this loop is the initial scene cast and the rest of the iterations are ricochet scene casts
-	for (int32 RicochetNumber = 0; (RicochetNumber <= InRicochetCap || InRicochetCap == -1); ++RicochetNumber)
-	{
-		const FVector SceneCastEnd = CurrentSceneCastStart + (CurrentSceneCastDirection * (InDistanceCap - DistanceTraveled));
+	OutStrengthSceneCastInfo.StopLocation = InState.LastSceneCastStopLocation;
+}
+
+bool FStrengthHitResult::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	FExitAwareHitResult::NetSerialize(Ar, Map, bOutSuccess);
 
-		FPenetrationSceneCastWithExitHitsUsingStrengthResult& PenetrationSceneCastWithExitHitsUsingStrengthResult = OutResult.PenetrationSceneCastWithExitHitsUsingStrengthResults.AddDefaulted_GetRef();
-		FStrengthHitResult* RicochetableHit = PenetrationSceneCastWithExitHitsUsingStrength(CurrentStrength, InOutPerCmStrengthNerfStack, InWorld, PenetrationSceneCastWithExitHitsUsingStrengthResult, CurrentSceneCastStart, SceneCastEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, GetPerCmPenetrationNerf, IsHitRicochetable);
+	uint8 bRicochet = bIsRicochet;
+	Ar.SerializeBits(&bRicochet, 1);
+	bIsRicochet = bRicochet;
 
-		DistanceTraveled += PenetrationSceneCastWithExitHitsUsingStrengthResult.StrengthSceneCastInfo.DistanceToStop;
-		CurrentStrength = PenetrationSceneCastWithExitHitsUsingStrengthResult.StrengthSceneCastInfo.StopStrength;
+	uint32 PackedRicochetNumber = FMath::Max(RicochetNumber, 0);
+	Ar.SerializeIntPacked(PackedRicochetNumber);
+	RicochetNumber = PackedRicochetNumber;
+
+	Ar << TraveledDistanceBeforeThisTrace;
+	Ar << Strength;
+
+	return true;
+}
 
-		// Set more strength hit result data
+FPenetrationNerfStack::FPenetrationNerfStack()
+	: BaseNerf(0.f)
+	, TotalNerf(0.f)
+	, RangeFalloff(nullptr)
+	, RangeFalloffDistance(0.f)
+{
+}
+FPenetrationNerfStack::FPenetrationNerfStack(const float InBaseNerf)
+	: BaseNerf(InBaseNerf)
+	, TotalNerf(InBaseNerf)
+	, RangeFalloff(nullptr)
+	, RangeFalloffDistance(0.f)
+{
+}
+
+void FPenetrationNerfStack::Push(const FHitResult& InEntranceHit, const float InNerf)
+{
+	Nerfs.Add({ InEntranceHit.Component, InEntranceHit.BoneName, InNerf });
+	TotalNerf += InNerf;
+}
+
+bool FPenetrationNerfStack::Pop(const FHitResult& InExitHit)
+{
+	// Search from the top since the body we are exiting is almost always the most recent one we entered
+	for (int32 i = Nerfs.Num() - 1; i >= 0; --i)
+	{
+		if (Nerfs[i].Component == InExitHit.Component && Nerfs[i].BoneName == InExitHit.BoneName)
 		{
-			// Give data to our strength hits for this scene cast
-			for (FStrengthHitResult& StrengthHit : PenetrationSceneCastWithExitHitsUsingStrengthResult.HitResults)
-			{
-				StrengthHit.RicochetNumber = RicochetNumber;
-				StrengthHit.TraveledDistanceBeforeThisTrace = (DistanceTraveled - PenetrationSceneCastWithExitHitsUsingStrengthResult.StrengthSceneCastInfo.DistanceToStop); // distance up until this scene cast
-			}
+			TotalNerf -= Nerfs[i].Nerf;
+			Nerfs.RemoveAt(i, 1, false);
 
-			// Give data to the ricochet hit
-			if (RicochetableHit)
+			if (Nerfs.Num() <= 0)
 			{
-				RicochetableHit->bIsRicochet = true;
+				TotalNerf = BaseNerf; // get rid of any floating point error that the running total built up
 			}
+			return true;
 		}
+	}
+
+	return false;
+}
+
+void FPenetrationNerfStack::Reset()
+{
+	Nerfs.Reset();
+	TotalNerf = BaseNerf;
+}
+
+void FPenetrationNerfStack::SetRangeFalloff(const FGCRangeFalloffTable* InRangeFalloff, const float InDistanceTraveled)
+{
+	RangeFalloff = (InRangeFalloff && !InRangeFalloff->IsEmpty()) ? InRangeFalloff : nullptr;
+	RangeFalloffDistance = InDistanceTraveled;
+}
+
+void FPenetrationNerfStack::Serialize(FArchive& InOutArchive)
+{
+	int32 NumNerfs = Nerfs.Num();
+	InOutArchive << NumNerfs;
+	if (InOutArchive.IsLoading())
+	{
+		Nerfs.SetNum(FMath::Max(NumNerfs, 0));
+	}
 
-		// Apply ricochet strength nerf
-		if (RicochetableHit)
+	for (FBodyNerf& BodyNerf : Nerfs)
+	{
+		// Weak pointers only survive archives that know about objects, so go through the component's path
+		FSoftObjectPath ComponentPath = FSoftObjectPath(BodyNerf.Component.Get());
+		InOutArchive << ComponentPath;
+		if (InOutArchive.IsLoading())
 		{
-			CurrentStrength -= GetRicochetNerf(*RicochetableHit);
+			BodyNerf.Component = Cast<UPrimitiveComponent>(ComponentPath.ResolveObject());
 		}
 
-		// Check if we should end here
-		{
-			// Stop if not enough strength for next cast
-			if (CurrentStrength <= 0.f)
-			{
-				CurrentStrength = 0.f;
-				break;
-			}
+		InOutArchive << BodyNerf.BoneName;
+		InOutArchive << BodyNerf.Nerf;
+	}
 
-			// Stop if there was nothing to ricochet off of
-			if (!RicochetableHit)
-			{
-				PenetrationSceneCastWithExitHitsUsingStrengthResult.StrengthSceneCastInfo.StopLocation = SceneCastEnd;
-				break;
-			}
-			// We have a ricochet hit
+	InOutArchive << BaseNerf;
+	InOutArchive << TotalNerf;
+	InOutArchive << RangeFalloffDistance; // the table needs to be given again with SetRangeFalloff()
+}
 
-			if (DistanceTraveled == InDistanceCap)
-			{
-				// Edge case: we should end the whole thing if we ran out of distance exactly when we hit a ricochet
-				PenetrationSceneCastWithExitHitsUsingStrengthResult.StrengthSceneCastInfo.StopLocation = RicochetableHit->Location;
-				break;
-			}
-		}
+FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor::FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor()
+	: FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor(0.f, 0.f, FVector::ZeroVector, FVector::ForwardVector, 0.f)
+{
+	bFinished = true; // nothing to do
+}
+FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor::FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor(const float InInitialStrength, const float InRangeFalloffNerf, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const int32 InRicochetCap)
+	: StartLocation(InStart)
+	, StartDirection(InDirection)
+	, StartStrength(InInitialStrength)
+	, DistanceCap(InDistanceCap)
+	, RicochetCap(InRicochetCap)
+	, State(InStart, InDirection, InInitialStrength)
+	, PerCmNerfStack(InRangeFalloffNerf)
+	, bFinished(InDistanceCap <= 0.f || InInitialStrength <= 0.f)
+{
+}
 
+bool FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor::Serialize(FArchive& InOutArchive)
+{
+	InOutArchive << StartLocation;
+	InOutArchive << StartDirection;
+	InOutArchive << StartStrength;
+	InOutArchive << DistanceCap;
+	InOutArchive << RicochetCap;
+
+	InOutArchive << State.SceneCastStart;
+	InOutArchive << State.SceneCastDirection;
+	InOutArchive << State.DistanceTraveled;
+	InOutArchive << State.Strength;
+	InOutArchive << State.RicochetNumber;
+	InOutArchive << State.LastSceneCastStopLocation;
+
+	InOutArchive << PerCmNerfStack;
+	InOutArchive << bFinished;
+	return true;
+}
 
-		// SETUP FOR OUR NEXT SCENE CAST
-		// Next ricochet cast needs a new direction and start location
-		CurrentSceneCastDirection = CurrentSceneCastDirection.MirrorByVector(RicochetableHit->ImpactNormal);
-		CurrentSceneCastStart = RicochetableHit->Location + (CurrentSceneCastDirection * UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastStartWallAvoidancePadding);
+/**
+ * Policy for the split check. Nerfs and ricochets enough for the queries to stop somewhere inside of most worlds.
+ */
+struct FGCCursorSplitCheckPolicy
+{
+	static constexpr bool bHasPenetrationNerf = true;
+	static constexpr bool bCanRicochet = true;
+	float GetPerCmPenetrationNerf(const FHitResult& InHit) const { return 1.f; }
+	float GetRicochetNerf(const FHitResult& InHit) const { return 50.f; }
+	bool IsHitRicochetable(const FHitResult& InHit) const
+	{
+		const FVector Direction = (InHit.TraceEnd - InHit.TraceStart).GetSafeNormal();
+		return FMath::Abs(FVector::DotProduct(InHit.ImpactNormal, Direction)) < .2f;
 	}
+};
 
-	OutResult.StrengthSceneCastInfo.StopStrength = CurrentStrength;
-	OutResult.StrengthSceneCastInfo.DistanceToStop = DistanceTraveled;
-	OutResult.StrengthSceneCastInfo.TimeAtStop = DistanceTraveled / InDistanceCap;
+/** The hits that a cursor query should give no matter how it is split. A resumed scene cast may start inside of a body and report it as an initial overlap, which isn't a hit of the whole query. */
+static void GetCursorSplitCheckHits(const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, TArray<const FStrengthHitResult*>& OutHits)
+{
+	OutHits.Reset();
+	for (const FStrengthHitResult& Hit : InResult.HitResults)
+	{
+		if (!Hit.bStartPenetrating)
+		{
+			OutHits.Add(&Hit);
+		}
+	}
+}
+
+void FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor::RunSplitCheck(const TArray<FString>& InArgs, UWorld* InWorld)
+{
+	using FStrengthCollisionQueries = UGCBlueprintFunctionLibrary_StrengthCollisionQueries;
 
-	if (OutResult.PenetrationSceneCastWithExitHitsUsingStrengthResults.Num() > 0)
+	if (!IsValid(InWorld))
 	{
-		OutResult.StrengthSceneCastInfo.StopLocation = OutResult.PenetrationSceneCastWithExitHitsUsingStrengthResults.Last().StrengthSceneCastInfo.StopLocation;
+		UE_LOG(LogGCStrengthCollisionQueries, Error, TEXT("%s() No world to query."), ANSI_TO_TCHAR(__FUNCTION__));
+		return;
 	}
-	else
+
+	const int32 NumQueries = InArgs.IsValidIndex(0) ? FCString::Atoi(*InArgs[0]) : 100;
+	const float Distance = InArgs.IsValidIndex(1) ? FCString::Atof(*InArgs[1]) : 10000.f;
+	const float Radius = InArgs.IsValidIndex(2) ? FCString::Atof(*InArgs[2]) : 5000.f;
+	const int32 Seed = InArgs.IsValidIndex(3) ? FCString::Atoi(*InArgs[3]) : 1;
+
+	// How far apart the hits and strengths of the split query can be from the whole query's
+	const float LocationTolerance = .1f;
+	const float StrengthTolerance = .01f;
+
+	const float InitialStrength = 2000.f;
+	const float RangeFalloffNerf = .01f;
+	const ECollisionChannel TraceChannel = ECollisionChannel::ECC_Visibility;
+	const FCollisionShape LineShape = FCollisionShape::LineShape;
+	const FCollisionQueryParams& QueryParams = FCollisionQueryParams::DefaultQueryParam;
+	const FCollisionResponseParams& ResponseParams = FCollisionResponseParams::DefaultResponseParam;
+	const FGCCursorSplitCheckPolicy Policy;
+
+	FRandomStream RandomStream = FRandomStream(Seed);
+	FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult WholeResult;
+	FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult SplitResult;
+	TArray<const FStrengthHitResult*> WholeHits;
+	TArray<const FStrengthHitResult*> SplitHits;
+	TArray<uint8> SavedCursor;
+
+	int32 NumMismatches = 0;
+	for (int32 QueryIndex = 0; QueryIndex < NumQueries; ++QueryIndex)
 	{
-		OutResult.StrengthSceneCastInfo.StopLocation = OutResult.StrengthSceneCastInfo.StartLocation;
+		const FVector Start = RandomStream.GetUnitVector() * RandomStream.FRandRange(0.f, Radius);
+		const FVector Direction = RandomStream.GetUnitVector();
+
+		FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor WholeCursor = FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor(InitialStrength, RangeFalloffNerf, Start, Direction, Distance);
+		WholeResult.Reset();
+		FStrengthCollisionQueries::PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(WholeCursor, Distance, InWorld, WholeResult, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, Policy, Policy);
+
+		FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor SplitCursor = FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor(InitialStrength, RangeFalloffNerf, Start, Direction, Distance);
+		SplitResult.Reset();
+		FStrengthCollisionQueries::PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(SplitCursor, Distance / 2.f, InWorld, SplitResult, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, Policy, Policy);
+		{
+			SavedCursor.Reset();
+			FMemoryWriter Writer = FMemoryWriter(SavedCursor);
+			SplitCursor.Serialize(Writer);
+
+			SplitCursor = FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor();
+			FMemoryReader Reader = FMemoryReader(SavedCursor);
+			SplitCursor.Serialize(Reader);
+		}
+		FStrengthCollisionQueries::PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(SplitCursor, Distance, InWorld, SplitResult, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, Policy, Policy);
+
+		GetCursorSplitCheckHits(WholeResult, WholeHits);
+		GetCursorSplitCheckHits(SplitResult, SplitHits);
+
+		bool bMatches = (WholeHits.Num() == SplitHits.Num()) && FMath::IsNearlyEqual(WholeCursor.State.Strength, SplitCursor.State.Strength, StrengthTolerance);
+		for (int32 HitIndex = 0; bMatches && HitIndex < WholeHits.Num(); ++HitIndex)
+		{
+			const FStrengthHitResult& WholeHit = *WholeHits[HitIndex];
+			const FStrengthHitResult& SplitHit = *SplitHits[HitIndex];
+			bMatches = (WholeHit.bIsExitHit == SplitHit.bIsExitHit)
+				&& (WholeHit.Component == SplitHit.Component)
+				&& WholeHit.Location.Equals(SplitHit.Location, LocationTolerance)
+				&& FMath::IsNearlyEqual(WholeHit.Strength, SplitHit.Strength, StrengthTolerance);
+		}
+
+		if (!bMatches)
+		{
+			UE_LOG(LogGCStrengthCollisionQueries, Error, TEXT("%s() Query %d: split advances gave %d hit(s) and %.3f strength, the whole advance gave %d hit(s) and %.3f strength."), ANSI_TO_TCHAR(__FUNCTION__), QueryIndex, SplitHits.Num(), SplitCursor.State.Strength, WholeHits.Num(), WholeCursor.State.Strength);
+			++NumMismatches;
+		}
 	}
+
+	UE_LOG(LogGCStrengthCollisionQueries, Display, TEXT("%s() %d of %d queries gave different results when split into advances."), ANSI_TO_TCHAR(__FUNCTION__), NumMismatches, NumQueries);
 }
-void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
-	const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf,
-	const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf,
-	const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable)
+
+FStrengthHitResult FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult::ExpandHitRecord(const int32 InIndex) const
 {
-	TArray<float> PerCmStrengthNerfStack;
-	PerCmStrengthNerfStack.Push(InRangeFalloffNerf);
-	return RicochetingPenetrationSceneCastWithExitHitsUsingStrength(InInitialStrength, PerCmStrengthNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, GetPerCmPenetrationNerf, GetRicochetNerf, IsHitRicochetable);
+	const FCompactHitRecord& HitRecord = HitRecords[InIndex];
+
+	FStrengthHitResult StrengthHit = FStrengthHitResult(HitRecord.ToExitAwareHitResult(StrengthSceneCastInfo.StartLocation, SceneCastEnd));
+	StrengthHit.bIsRicochet = HitRecord.bIsRicochet;
+	StrengthHit.Strength = HitRecord.Strength;
+	return StrengthHit;
 }
-//  END Custom query
 
 float UGCBlueprintFunctionLibrary_StrengthCollisionQueries::NerfStrengthPerCm(float& InOutStrength, const float InCentimetersToTravel, const float InNerfPerCm)
 {
@@ -295,3 +538,48 @@ float UGCBlueprintFunctionLibrary_StrengthCollisionQueries::NerfStrengthPerCm(fl
 	const float TraveledThroughDistance = (TraveledThroughRatio * InCentimetersToTravel);
 	return TraveledThroughDistance;
 }
+
+float UGCBlueprintFunctionLibrary_StrengthCollisionQueries::NerfStrength(float& InOutStrength, const float InCentimetersToTravel, FPenetrationNerfStack& InOutPerCmNerfStack)
+{
+	const FGCRangeFalloffTable* RangeFalloff = InOutPerCmNerfStack.GetRangeFalloff();
+	if (!RangeFalloff)
+	{
+		return NerfStrengthPerCm(InOutStrength, InCentimetersToTravel, InOutPerCmNerfStack.GetTotalNerf());
+	}
+
+	// Our nerfs are constant for this distance but the range falloff isn't, so use its table instead of the linear math
+	const float StartDistance = InOutPerCmNerfStack.GetRangeFalloffDistance();
+	const float StrengthToTakeAway = (InCentimetersToTravel * InOutPerCmNerfStack.GetTotalNerf()) + RangeFalloff->GetStrengthLost(StartDistance, StartDistance + InCentimetersToTravel);
+	const float OldStrength = InOutStrength;
+	InOutStrength -= StrengthToTakeAway;
+
+	float TraveledThroughDistance = InCentimetersToTravel;
+	if (InOutStrength < 0) // we've been stopped midway through the InCentimetersToTravel distance
+	{
+		TraveledThroughDistance = RangeFalloff->GetTravelDistance(StartDistance, OldStrength, InOutPerCmNerfStack.GetTotalNerf(), InCentimetersToTravel);
+	}
+
+	InOutPerCmNerfStack.AddRangeFalloffDistance(TraveledThroughDistance);
+	return TraveledThroughDistance;
+}
+
+const FCollisionQueryParams& UGCBlueprintFunctionLibrary_StrengthCollisionQueries::GetQueryParamsReturningPhysicalMaterial(const FCollisionQueryParams& InCollisionQueryParams, FCollisionQueryParams& OutCopy)
+{
+	if (InCollisionQueryParams.bReturnPhysicalMaterial)
+	{
+		return InCollisionQueryParams;
+	}
+
+	OutCopy = InCollisionQueryParams;
+	OutCopy.bReturnPhysicalMaterial = true;
+	return OutCopy;
+}
+
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::LogStartedInsideOfGeometry(const TCHAR* InFunctionName, const FHitResult& InHit)
+{
+	UE_LOG(LogGCStrengthCollisionQueries, Verbose, TEXT("%s() Penetration strength query started inside of something. Make sure to not start this query inside of geometry. We will not consider this hit for the penetration strength nerf stack but it will still be included in the outputed hits. Hit Actor: [%s]."), InFunctionName, GetData(GetNameSafe(InHit.GetActor())));
+}
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::LogExitedBodyNeverEntered(const TCHAR* InFunctionName, const FHitResult& InHit)
+{
+	UE_LOG(LogGCStrengthCollisionQueries, Error, TEXT("%s() Exited a body that was never entered. Did the query start inside of it? Hit Actor: [%s]."), InFunctionName, GetData(GetNameSafe(InHit.GetActor())));
+}
@@ -4,59 +4,260 @@
 #include "BlueprintFunctionLibraries/Debugging/GCBlueprintFunctionLibrary_DrawDebugHelpers.h"
 
 #include "DrawDebugHelpers.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/Engine.h"
 
 
 
+/** Unit shapes as pairs of line end points, made once per segment count */
+struct FDebugShapeTemplate
+{
+	/** Radius 1, like DrawDebugSphere() */
+	TArray<FVector> SphereLines;
+	/** Radius 1 capsule ends around the origin, like DrawDebugCapsule(). Moved out along Z by the capsule's half axis. */
+	TArray<FVector> CapsuleTopLines;
+	TArray<FVector> CapsuleBottomLines;
+};
+
+static void AddCircleTemplateLines(TArray<FVector>& InOutLines, const FVector& InAxisX, const FVector& InAxisY, const int32 InSegments, const float InArc)
+{
+	const float AngleStep = InArc / InSegments;
+	FVector PreviousVertex = InAxisX;
+	for (int32 i = 1; i <= InSegments; ++i)
+	{
+		const float Angle = AngleStep * i;
+		const FVector Vertex = (InAxisX * FMath::Cos(Angle)) + (InAxisY * FMath::Sin(Angle));
+		InOutLines.Add(PreviousVertex);
+		InOutLines.Add(Vertex);
+		PreviousVertex = Vertex;
+	}
+}
+
+static const FDebugShapeTemplate& GetDebugShapeTemplate(const int32 InSegments)
+{
+	static TMap<int32, FDebugShapeTemplate> DebugShapeTemplates;
+	if (const FDebugShapeTemplate* ExistingTemplate = DebugShapeTemplates.Find(InSegments))
+	{
+		return *ExistingTemplate;
+	}
+
+	FDebugShapeTemplate& NewTemplate = DebugShapeTemplates.Add(InSegments);
+
+	// Sphere: the same latitude and longitude lines as DrawDebugSphere()
+	{
+		const float AngleStep = 2.f * PI / InSegments;
+		NewTemplate.SphereLines.Reserve(InSegments * InSegments * 4);
+
+		float SinY1 = 0.f;
+		float CosY1 = 1.f;
+		for (int32 y = 1; y <= InSegments; ++y)
+		{
+			const float SinY2 = FMath::Sin(AngleStep * y);
+			const float CosY2 = FMath::Cos(AngleStep * y);
+
+			FVector Vertex1 = FVector(SinY1, 0.f, CosY1);
+			FVector Vertex3 = FVector(SinY2, 0.f, CosY2);
+			for (int32 x = 1; x <= InSegments; ++x)
+			{
+				const float SinX = FMath::Sin(AngleStep * x);
+				const float CosX = FMath::Cos(AngleStep * x);
+				const FVector Vertex2 = FVector(CosX * SinY1, SinX * SinY1, CosY1);
+				const FVector Vertex4 = FVector(CosX * SinY2, SinX * SinY2, CosY2);
+
+				NewTemplate.SphereLines.Add(Vertex1);
+				NewTemplate.SphereLines.Add(Vertex2);
+				NewTemplate.SphereLines.Add(Vertex1);
+				NewTemplate.SphereLines.Add(Vertex3);
+
+				Vertex1 = Vertex2;
+				Vertex3 = Vertex4;
+			}
+
+			SinY1 = SinY2;
+			CosY1 = CosY2;
+		}
+	}
+
+	// Capsule: a circle and two half circles at each end, like DrawDebugCapsule()
+	{
+		AddCircleTemplateLines(NewTemplate.CapsuleTopLines, FVector::ForwardVector, FVector::RightVector, InSegments, 2.f * PI);
+		AddCircleTemplateLines(NewTemplate.CapsuleTopLines, FVector::RightVector, FVector::UpVector, InSegments / 2, PI);
+		AddCircleTemplateLines(NewTemplate.CapsuleTopLines, FVector::ForwardVector, FVector::UpVector, InSegments / 2, PI);
+
+		NewTemplate.CapsuleBottomLines.Reserve(NewTemplate.CapsuleTopLines.Num());
+		for (const FVector& TopVertex : NewTemplate.CapsuleTopLines)
+		{
+			NewTemplate.CapsuleBottomLines.Add(FVector(TopVertex.X, TopVertex.Y, -TopVertex.Z));
+		}
+	}
+
+	return NewTemplate;
+}
+
+static void AddTransformedTemplateLines(TArray<FBatchedLine>& InOutLines, const TArray<FVector>& InTemplateLines, const FTransform& InTransform, const FLinearColor& InColor, const float InLineLifeTime, const uint8 InDepthPriority, const float InThickness)
+{
+	for (int32 i = 0; i + 1 < InTemplateLines.Num(); i += 2)
+	{
+		InOutLines.Emplace(InTransform.TransformPosition(InTemplateLines[i]), InTransform.TransformPosition(InTemplateLines[i + 1]), InColor, InLineLifeTime, InThickness, InDepthPriority);
+	}
+}
+
+
 void UGCBlueprintFunctionLibrary_DrawDebugHelpers::DrawDebugCollisionShape(const UWorld* InWorld, const FVector& InCenter, const FCollisionShape& InCollisionShape, const FQuat& InRotation, const FColor& InColor, const int32 InSegments, const bool bInPersistentLines, const float InLifeTime, const uint8 InDepthPriority, const float InThickness)
 {
+#if ENABLE_DRAW_DEBUG
+	if (InCollisionShape.IsLine())
+	{
+		DrawDebugPoint(InWorld, InCenter, InThickness * 10, InColor, bInPersistentLines, InLifeTime, InDepthPriority);
+		return;
+	}
+
+	ULineBatchComponent* LineBatcher = GetDebugLineBatcher(InWorld, bInPersistentLines, InLifeTime, InDepthPriority);
+	if (!LineBatcher)
+	{
+		return;
+	}
+
+	TArray<FBatchedLine> Lines;
+	AddDebugCollisionShapeLines(Lines, InCenter, InCollisionShape, InRotation, FLinearColor(InColor), InSegments, GetDebugLineLifeTime(*LineBatcher, bInPersistentLines, InLifeTime), InDepthPriority, InThickness);
+	LineBatcher->DrawLines(Lines);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void UGCBlueprintFunctionLibrary_DrawDebugHelpers::DrawDebugLineDotted(const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FColor& InColor, const bool bInPersistentLines, const float InLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength)
+{
+#if ENABLE_DRAW_DEBUG
+	ULineBatchComponent* LineBatcher = GetDebugLineBatcher(InWorld, bInPersistentLines, InLifeTime, InDepthPriority);
+	if (!LineBatcher)
+	{
+		return;
+	}
+
+	TArray<FBatchedLine> Lines;
+	AddDebugLineDottedLines(Lines, InStart, InEnd, FLinearColor(InColor), GetDebugLineLifeTime(*LineBatcher, bInPersistentLines, InLifeTime), InDepthPriority, InThickness, InSegmentsLength, InSegmentsSpacingLength);
+	LineBatcher->DrawLines(Lines);
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void UGCBlueprintFunctionLibrary_DrawDebugHelpers::AddDebugCollisionShapeLines(TArray<FBatchedLine>& InOutLines, const FVector& InCenter, const FCollisionShape& InCollisionShape, const FQuat& InRotation, const FLinearColor& InColor, const int32 InSegments, const float InLineLifeTime, const uint8 InDepthPriority, const float InThickness)
+{
 #if ENABLE_DRAW_DEBUG
 	switch (InCollisionShape.ShapeType)
 	{
 		case ECollisionShape::Box:
 		{
-			DrawDebugBox(InWorld, InCenter, InCollisionShape.GetExtent(), InRotation, InColor, bInPersistentLines, InLifeTime, InDepthPriority, InThickness);
+			static const FVector BoxTemplateLines[] =
+			{
+				FVector(1, 1, 1), FVector(1, -1, 1), FVector(1, -1, 1), FVector(-1, -1, 1), FVector(-1, -1, 1), FVector(-1, 1, 1), FVector(-1, 1, 1), FVector(1, 1, 1),
+				FVector(1, 1, -1), FVector(1, -1, -1), FVector(1, -1, -1), FVector(-1, -1, -1), FVector(-1, -1, -1), FVector(-1, 1, -1), FVector(-1, 1, -1), FVector(1, 1, -1),
+				FVector(1, 1, 1), FVector(1, 1, -1), FVector(1, -1, 1), FVector(1, -1, -1), FVector(-1, -1, 1), FVector(-1, -1, -1), FVector(-1, 1, 1), FVector(-1, 1, -1)
+			};
+
+			const int32 NumBoxTemplateVertices = UE_ARRAY_COUNT(BoxTemplateLines);
+
+			const FTransform BoxTransform = FTransform(InRotation, InCenter, InCollisionShape.GetExtent());
+			InOutLines.Reserve(InOutLines.Num() + NumBoxTemplateVertices / 2);
+			for (int32 i = 0; i < NumBoxTemplateVertices; i += 2)
+			{
+				InOutLines.Emplace(BoxTransform.TransformPosition(BoxTemplateLines[i]), BoxTransform.TransformPosition(BoxTemplateLines[i + 1]), InColor, InLineLifeTime, InThickness, InDepthPriority);
+			}
 			break;
 		}
-		case  ECollisionShape::Sphere:
+		case ECollisionShape::Sphere:
 		{
-			DrawDebugSphere(InWorld, InCenter, InCollisionShape.GetSphereRadius(), InSegments, InColor, bInPersistentLines, InLifeTime, InDepthPriority, InThickness);
+			const FDebugShapeTemplate& Template = GetDebugShapeTemplate(FMath::Clamp(InSegments, 4, 64));
+
+			// Like DrawDebugSphere(), the sphere isn't rotated
+			const FTransform SphereTransform = FTransform(FQuat::Identity, InCenter, FVector(InCollisionShape.GetSphereRadius()));
+			InOutLines.Reserve(InOutLines.Num() + Template.SphereLines.Num() / 2);
+			AddTransformedTemplateLines(InOutLines, Template.SphereLines, SphereTransform, InColor, InLineLifeTime, InDepthPriority, InThickness);
 			break;
 		}
 		case ECollisionShape::Capsule:
 		{
-			// NOTE: Segments is not used here because DrawDebugCapsule() hard codes it
-			DrawDebugCapsule(InWorld, InCenter, InCollisionShape.GetCapsuleHalfHeight(), InCollisionShape.GetCapsuleRadius(), InRotation, InColor, bInPersistentLines, InLifeTime, InDepthPriority, InThickness);
+			const FDebugShapeTemplate& Template = GetDebugShapeTemplate(FMath::Clamp(InSegments, 4, 64));
+
+			const float Radius = InCollisionShape.GetCapsuleRadius();
+			const float HalfAxis = FMath::Max(InCollisionShape.GetCapsuleHalfHeight() - Radius, 1.f);
+			const FVector AxisX = InRotation.GetAxisX() * Radius;
+			const FVector AxisY = InRotation.GetAxisY() * Radius;
+			const FVector TopEnd = InCenter + (InRotation.GetAxisZ() * HalfAxis);
+			const FVector BottomEnd = InCenter - (InRotation.GetAxisZ() * HalfAxis);
+
+			InOutLines.Reserve(InOutLines.Num() + Template.CapsuleTopLines.Num() + 4);
+			AddTransformedTemplateLines(InOutLines, Template.CapsuleTopLines, FTransform(InRotation, TopEnd, FVector(Radius)), InColor, InLineLifeTime, InDepthPriority, InThickness);
+			AddTransformedTemplateLines(InOutLines, Template.CapsuleBottomLines, FTransform(InRotation, BottomEnd, FVector(Radius)), InColor, InLineLifeTime, InDepthPriority, InThickness);
+
+			// The sides
+			InOutLines.Emplace(TopEnd + AxisX, BottomEnd + AxisX, InColor, InLineLifeTime, InThickness, InDepthPriority);
+			InOutLines.Emplace(TopEnd - AxisX, BottomEnd - AxisX, InColor, InLineLifeTime, InThickness, InDepthPriority);
+			InOutLines.Emplace(TopEnd + AxisY, BottomEnd + AxisY, InColor, InLineLifeTime, InThickness, InDepthPriority);
+			InOutLines.Emplace(TopEnd - AxisY, BottomEnd - AxisY, InColor, InLineLifeTime, InThickness, InDepthPriority);
 			break;
 		}
 		case ECollisionShape::Line:
 		{
-			DrawDebugPoint(InWorld, InCenter, InThickness * 10, InColor, bInPersistentLines, InLifeTime, InDepthPriority);
+			// Nothing to add. DrawDebugCollisionShape() draws a point for these.
 			break;
 		}
 	}
 #endif // ENABLE_DRAW_DEBUG
 }
 
-void UGCBlueprintFunctionLibrary_DrawDebugHelpers::DrawDebugLineDotted(const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FColor& InColor, const bool bInPersistentLines, const float InLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength)
+void UGCBlueprintFunctionLibrary_DrawDebugHelpers::AddDebugLineDottedLines(TArray<FBatchedLine>& InOutLines, const FVector& InStart, const FVector& InEnd, const FLinearColor& InColor, const float InLineLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength)
 {
 #if ENABLE_DRAW_DEBUG
-	const FVector Direction = (InEnd - InStart).GetSafeNormal();
+	const float SegmentsStride = InSegmentsLength + InSegmentsSpacingLength;
 	const float FullLength = FVector::Distance(InStart, InEnd);
-	const float NumberOfLineSegments = FMath::CeilToInt(FullLength / (InSegmentsLength + InSegmentsSpacingLength));
-	for (int32 i = 0; i < NumberOfLineSegments; ++i)
+	if (FullLength <= 0.f || InSegmentsLength <= 0.f)
 	{
-		float DistanceToLineSegmentStart = (InSegmentsLength + InSegmentsSpacingLength) * i;
-		float DistanceToLineSegmentEnd = DistanceToLineSegmentStart + InSegmentsLength;
+		return;
+	}
 
-		if (DistanceToLineSegmentEnd > FullLength)
-		{
-			DistanceToLineSegmentEnd = FullLength;
-		}
+	const FVector Direction = (InEnd - InStart) / FullLength;
+	const FVector SegmentOffset = Direction * InSegmentsLength;
+	const FVector StrideOffset = Direction * SegmentsStride;
+	const int32 NumberOfLineSegments = FMath::CeilToInt(FullLength / SegmentsStride);
+	InOutLines.Reserve(InOutLines.Num() + NumberOfLineSegments);
+
+	// Every segment but the last is a whole one, so we can just step along
+	FVector LineSegmentStart = InStart;
+	for (int32 i = 0; i < NumberOfLineSegments - 1; ++i)
+	{
+		InOutLines.Emplace(LineSegmentStart, LineSegmentStart + SegmentOffset, InColor, InLineLifeTime, InThickness, InDepthPriority);
+		LineSegmentStart += StrideOffset;
+	}
+
+	// The last one stops at the end
+	const float DistanceToLastLineSegmentStart = SegmentsStride * (NumberOfLineSegments - 1);
+	const float DistanceToLastLineSegmentEnd = FMath::Min(DistanceToLastLineSegmentStart + InSegmentsLength, FullLength);
+	InOutLines.Emplace(InStart + (Direction * DistanceToLastLineSegmentStart), InStart + (Direction * DistanceToLastLineSegmentEnd), InColor, InLineLifeTime, InThickness, InDepthPriority);
+#endif // ENABLE_DRAW_DEBUG
+}
 
-		const FVector LineSegmentStart = InStart + (Direction * DistanceToLineSegmentStart);
-		const FVector LineSegmentEnd = InStart + (Direction * DistanceToLineSegmentEnd);
+ULineBatchComponent* UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineBatcher(const UWorld* InWorld, const bool bInPersistentLines, const float InLifeTime, const uint8 InDepthPriority)
+{
+#if ENABLE_DRAW_DEBUG
+	if (!InWorld || GEngine->GetNetMode(InWorld) == NM_DedicatedServer)
+	{
+		return nullptr;
+	}
 
-		DrawDebugLine(InWorld, LineSegmentStart, LineSegmentEnd, InColor, bInPersistentLines, InLifeTime, InDepthPriority, InThickness);
+	if (InDepthPriority == SDPG_Foreground)
+	{
+		return InWorld->ForegroundLineBatcher;
 	}
+	return (bInPersistentLines || InLifeTime > 0.f) ? InWorld->PersistentLineBatcher : InWorld->LineBatcher;
+#else
+	return nullptr;
 #endif // ENABLE_DRAW_DEBUG
 }
+
+float UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineLifeTime(const ULineBatchComponent& InLineBatcher, const bool bInPersistentLines, const float InLifeTime)
+{
+	if (bInPersistentLines)
+	{
+		return -1.f;
+	}
+	return (InLifeTime > 0.f) ? InLifeTime : InLineBatcher.DefaultLifeTime;
+}
@@ -6,114 +6,23 @@
 #include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_StrengthCollisionQueries.h"
 #include "BlueprintFunctionLibraries/Debugging/GCBlueprintFunctionLibrary_DrawDebugHelpers.h"
 #include "DrawDebugHelpers.h"
+#include "Components/LineBatchComponent.h"
 
 
 
 void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::DrawStrengthDebugLine(const UWorld* InWorld, const FPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const bool bInPersistentLines, const float InLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor)
 {
 #if ENABLE_DRAW_DEBUG
-	const float SceneCastTravelDistance = InResult.StrengthSceneCastInfo.DistanceToStop;
-
-	const float NumberOfLineSegments = FMath::CeilToInt(SceneCastTravelDistance / (InSegmentsLength + InSegmentsSpacingLength));
-	for (int32 i = 0; i < NumberOfLineSegments; ++i)
+	ULineBatchComponent* LineBatcher = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineBatcher(InWorld, bInPersistentLines, InLifeTime, InDepthPriority);
+	if (!LineBatcher)
 	{
-		float DistanceToLineSegmentStart = (InSegmentsLength + InSegmentsSpacingLength) * i;
-		float DistanceToLineSegmentEnd = DistanceToLineSegmentStart + InSegmentsLength;
-		if (DistanceToLineSegmentEnd > SceneCastTravelDistance)
-		{
-			DistanceToLineSegmentEnd = SceneCastTravelDistance;
-		}
-
-		const FVector LineSegmentStart = InResult.StrengthSceneCastInfo.StartLocation + (InResult.StrengthSceneCastInfo.CastDirection * DistanceToLineSegmentStart);
-		const FVector LineSegmentEnd = InResult.StrengthSceneCastInfo.StartLocation + (InResult.StrengthSceneCastInfo.CastDirection * DistanceToLineSegmentEnd);
-
-
-		// Get the strength at the line segment start
-		float StrengthAtLineSegmentStart;
-		{
-			// NOTE: we use the term "Time" as in the ratio from FPenetrationSceneCastWithExitHitsUsingStrengthResult::StartLocation to FPenetrationSceneCastWithExitHitsUsingStrengthResult::StopLocation. This is not the same as FHitResult::Time!
-			float TimeOnOrBeforeLineSegmentStart = 0.f;
-			float StrengthOnOrBeforeLineSegmentStart = InResult.StrengthSceneCastInfo.StartStrength;
-			float TimeOnOrAfterLineSegmentStart = 1.f;
-			float StrengthOnOrAfterLineSegmentStart = InResult.StrengthSceneCastInfo.StopStrength;
-			for (const FStrengthHitResult& Hit : InResult.HitResults)
-			{
-				if (Hit.Distance <= DistanceToLineSegmentStart)
-				{
-					// This hit is directly on or before the line segment start
-					TimeOnOrBeforeLineSegmentStart = Hit.Time / InResult.StrengthSceneCastInfo.TimeAtStop;
-					StrengthOnOrBeforeLineSegmentStart = Hit.Strength;
-					continue;
-				}
-				if (Hit.Distance >= DistanceToLineSegmentStart)
-				{
-					// This hit is directly on or after the line segment start
-					TimeOnOrAfterLineSegmentStart = Hit.Time / InResult.StrengthSceneCastInfo.TimeAtStop;
-					StrengthOnOrAfterLineSegmentStart = Hit.Strength;
-					break;
-				}
-			}
-
-			const float TimeOfLineSegmentStart = DistanceToLineSegmentStart / SceneCastTravelDistance;
-			StrengthAtLineSegmentStart = FMath::Lerp(StrengthOnOrBeforeLineSegmentStart, StrengthOnOrAfterLineSegmentStart, TimeOfLineSegmentStart / TimeOnOrAfterLineSegmentStart);
-		}
-
-		// Find the hits in between the line segment start and end
-		TArray<FStrengthHitResult> HitsWithinLineSegment;
-		for (const FStrengthHitResult& Hit : InResult.HitResults)
-		{
-			if (Hit.Distance <= DistanceToLineSegmentStart)
-			{
-				continue;
-			}
-			if (Hit.Distance >= DistanceToLineSegmentEnd)
-			{
-				break;
-			}
-
-			HitsWithinLineSegment.Add(Hit); // hit in between segment
-		}
-
-
-		// Draw the debug line(s)
-		if (HitsWithinLineSegment.Num() <= 0)
-		{
-			const FColor StrengthDebugColor = GetDebugColorForStrength(StrengthAtLineSegmentStart, InInitialStrength, InFullStrengthColor, InNoStrengthColor).ToFColor(true);
-			DrawDebugLine(InWorld, LineSegmentStart, LineSegmentEnd, StrengthDebugColor, false, InLifeTime, 0, InThickness);
-		}
-		else // there are hits (penetrations) within this segment so we will draw multible lines for this segment to give more accurate colors
-		{
-			// Debug line from the line segment start to the first hit
-			{
-				const FVector DebugLineStart = LineSegmentStart;
-				const FVector DebugLineEnd = HitsWithinLineSegment[0].Location;
-				const FColor StrengthDebugColor = GetDebugColorForStrength(StrengthAtLineSegmentStart, InInitialStrength, InFullStrengthColor, InNoStrengthColor).ToFColor(true);
-				DrawDebugLine(InWorld, DebugLineStart, DebugLineEnd, StrengthDebugColor, false, InLifeTime, 0, InThickness);
-			}
-
-			// Debug lines from hit to hit
-			for (int32 j = 0; j < HitsWithinLineSegment.Num(); ++j)
-			{
-				if (HitsWithinLineSegment.IsValidIndex(j + 1) == false)
-				{
-					break;
-				}
-
-				const FVector DebugLineStart = HitsWithinLineSegment[j].Location;
-				const FVector DebugLineEnd = HitsWithinLineSegment[j + 1].Location;
-				const FColor StrengthDebugColor = GetDebugColorForStrength(HitsWithinLineSegment[j].Strength, InInitialStrength, InFullStrengthColor, InNoStrengthColor).ToFColor(true);
-				DrawDebugLine(InWorld, DebugLineStart, DebugLineEnd, StrengthDebugColor, false, InLifeTime, 0, InThickness);
-			}
-
-			// Debug line from the last hit to the line segment end
-			{
-				const FVector DebugLineStart = HitsWithinLineSegment.Last().Location;
-				const FVector DebugLineEnd = LineSegmentEnd;
-				const FColor StrengthDebugColor = GetDebugColorForStrength(HitsWithinLineSegment.Last().Strength, InInitialStrength, InFullStrengthColor, InNoStrengthColor).ToFColor(true);
-				DrawDebugLine(InWorld, HitsWithinLineSegment.Last().Location, LineSegmentEnd, StrengthDebugColor, false, InLifeTime, 0, InThickness);
-			}
-		}
+		return;
 	}
+
+	TArray<FBatchedLine> Lines;
+	const float LineLifeTime = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineLifeTime(*LineBatcher, bInPersistentLines, InLifeTime);
+	AddStrengthDebugLines(Lines, InResult, InInitialStrength, LineLifeTime, InDepthPriority, InThickness, InSegmentsLength, InSegmentsSpacingLength, InFullStrengthColor, InNoStrengthColor);
+	LineBatcher->DrawLines(Lines);
 #endif // ENABLE_DRAW_DEBUG
 }
 void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::DrawStrengthDebugText(const UWorld* InWorld, const FPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const float InLifeTime, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor)
@@ -153,24 +62,51 @@ void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::DrawC
 	LocationsWithStrengths.Emplace(InResult.StrengthSceneCastInfo.StopLocation, InResult.StrengthSceneCastInfo.StopStrength);
 
 
-	const FVector OffsetDirection = FVector::UpVector;
-	for (const TPair<FVector, float>& LocationWithStrength : LocationsWithStrengths)
+	if (InResult.StrengthSceneCastInfo.CollisionShapeCasted.IsLine())
 	{
-		const FColor StrengthDebugColor = GetDebugColorForStrength(LocationWithStrength.Value, InInitialStrength, InFullStrengthColor, InNoStrengthColor).ToFColor(true);
+		for (const TPair<FVector, float>& LocationWithStrength : LocationsWithStrengths)
+		{
+			const FColor StrengthDebugColor = GetDebugColorForStrength(LocationWithStrength.Value, InInitialStrength, InFullStrengthColor, InNoStrengthColor).ToFColor(true);
+			UGCBlueprintFunctionLibrary_DrawDebugHelpers::DrawDebugCollisionShape(InWorld, LocationWithStrength.Key, InResult.StrengthSceneCastInfo.CollisionShapeCasted, InResult.StrengthSceneCastInfo.CollisionShapeCastedRotation, StrengthDebugColor, 16, bInPersistentLines, InLifeTime, InDepthPriority, InThickness);
+		}
+		return;
+	}
 
-		const FVector ShapeLocation = LocationWithStrength.Key;
-		UGCBlueprintFunctionLibrary_DrawDebugHelpers::DrawDebugCollisionShape(InWorld, ShapeLocation, InResult.StrengthSceneCastInfo.CollisionShapeCasted, InResult.StrengthSceneCastInfo.CollisionShapeCastedRotation, StrengthDebugColor, 16, bInPersistentLines, InLifeTime, InDepthPriority, InThickness);
+	ULineBatchComponent* LineBatcher = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineBatcher(InWorld, bInPersistentLines, InLifeTime, InDepthPriority);
+	if (!LineBatcher)
+	{
+		return;
 	}
+
+	// Every shape's lines go in one batch
+	TArray<FBatchedLine> Lines;
+	const float LineLifeTime = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineLifeTime(*LineBatcher, bInPersistentLines, InLifeTime);
+	for (const TPair<FVector, float>& LocationWithStrength : LocationsWithStrengths)
+	{
+		const FLinearColor StrengthDebugColor = GetDebugColorForStrength(LocationWithStrength.Value, InInitialStrength, InFullStrengthColor, InNoStrengthColor);
+		UGCBlueprintFunctionLibrary_DrawDebugHelpers::AddDebugCollisionShapeLines(Lines, LocationWithStrength.Key, InResult.StrengthSceneCastInfo.CollisionShapeCasted, InResult.StrengthSceneCastInfo.CollisionShapeCastedRotation, StrengthDebugColor, 16, LineLifeTime, InDepthPriority, InThickness);
+	}
+	LineBatcher->DrawLines(Lines);
 #endif // ENABLE_DRAW_DEBUG
 }
 
 void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::DrawStrengthDebugLine(const UWorld* InWorld, const FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const bool bInPersistentLines, const float InLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor)
 {
 #if ENABLE_DRAW_DEBUG
+	ULineBatchComponent* LineBatcher = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineBatcher(InWorld, bInPersistentLines, InLifeTime, InDepthPriority);
+	if (!LineBatcher)
+	{
+		return;
+	}
+
+	// Every scene cast's lines go in one batch
+	TArray<FBatchedLine> Lines;
+	const float LineLifeTime = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineLifeTime(*LineBatcher, bInPersistentLines, InLifeTime);
 	for (const FPenetrationSceneCastWithExitHitsUsingStrengthResult& PenetrationSceneCastWithExitHitsUsingStrengthResult : InResult.PenetrationSceneCastWithExitHitsUsingStrengthResults)
 	{
-		DrawStrengthDebugLine(InWorld, PenetrationSceneCastWithExitHitsUsingStrengthResult, InInitialStrength, bInPersistentLines, InLifeTime, InDepthPriority, InThickness, InSegmentsLength, InSegmentsSpacingLength, InFullStrengthColor, InNoStrengthColor);
+		AddStrengthDebugLines(Lines, PenetrationSceneCastWithExitHitsUsingStrengthResult, InInitialStrength, LineLifeTime, InDepthPriority, InThickness, InSegmentsLength, InSegmentsSpacingLength, InFullStrengthColor, InNoStrengthColor);
 	}
+	LineBatcher->DrawLines(Lines);
 #endif // ENABLE_DRAW_DEBUG
 }
 void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::DrawStrengthDebugText(const UWorld* InWorld, const FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const float InLifeTime, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor)
@@ -273,6 +209,72 @@ void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::DrawC
 }
 
 
+void UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::AddStrengthDebugLines(TArray<FBatchedLine>& InOutLines, const FPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const float InLineLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor)
+{
+#if ENABLE_DRAW_DEBUG
+	const FStrengthSceneCastInfo& StrengthSceneCastInfo = InResult.StrengthSceneCastInfo;
+	const TArray<FStrengthHitResult>& Hits = InResult.HitResults;
+	const float SceneCastTravelDistance = StrengthSceneCastInfo.DistanceToStop;
+	const float SegmentsStride = InSegmentsLength + InSegmentsSpacingLength;
+	if (SceneCastTravelDistance <= 0.f || InSegmentsLength <= 0.f)
+	{
+		return;
+	}
+
+	const int32 NumberOfLineSegments = FMath::CeilToInt(SceneCastTravelDistance / SegmentsStride);
+	InOutLines.Reserve(InOutLines.Num() + NumberOfLineSegments + Hits.Num());
+
+	auto AddLine = [&](const FVector& InStart, const FVector& InEnd, const float InStrength)
+	{
+		InOutLines.Emplace(InStart, InEnd, GetDebugColorForStrength(InStrength, InInitialStrength, InFullStrengthColor, InNoStrengthColor), InLineLifeTime, InThickness, InDepthPriority);
+	};
+
+	// Walk the segments and the hits (ordered by distance) together. The strength along the cast is linear in between the points we know it at (the start, the hits, and the stop).
+	int32 NextHitIndex = 0;
+	float PreviousDistance = 0.f;
+	float PreviousStrength = StrengthSceneCastInfo.StartStrength;
+	for (int32 i = 0; i < NumberOfLineSegments; ++i)
+	{
+		const float DistanceToLineSegmentStart = SegmentsStride * i;
+		const float DistanceToLineSegmentEnd = FMath::Min(DistanceToLineSegmentStart + InSegmentsLength, SceneCastTravelDistance);
+
+		// Pass the hits directly on or before the line segment start
+		while (Hits.IsValidIndex(NextHitIndex) && Hits[NextHitIndex].Distance <= DistanceToLineSegmentStart)
+		{
+			PreviousDistance = Hits[NextHitIndex].Distance;
+			PreviousStrength = Hits[NextHitIndex].Strength;
+			++NextHitIndex;
+		}
+
+		// Get the strength at the line segment start
+		float PieceStrength;
+		{
+			const float NextDistance = Hits.IsValidIndex(NextHitIndex) ? Hits[NextHitIndex].Distance : SceneCastTravelDistance;
+			const float NextStrength = Hits.IsValidIndex(NextHitIndex) ? Hits[NextHitIndex].Strength : StrengthSceneCastInfo.StopStrength;
+			const float Alpha = (NextDistance > PreviousDistance) ? (DistanceToLineSegmentStart - PreviousDistance) / (NextDistance - PreviousDistance) : 0.f;
+			PieceStrength = FMath::Lerp(PreviousStrength, NextStrength, Alpha);
+		}
+
+		// Split the line segment at the hits (penetrations) within it to give more accurate colors
+		FVector PieceStart = StrengthSceneCastInfo.StartLocation + (StrengthSceneCastInfo.CastDirection * DistanceToLineSegmentStart);
+		while (Hits.IsValidIndex(NextHitIndex) && Hits[NextHitIndex].Distance < DistanceToLineSegmentEnd)
+		{
+			const FStrengthHitResult& Hit = Hits[NextHitIndex];
+			AddLine(PieceStart, Hit.Location, PieceStrength);
+
+			PieceStart = Hit.Location;
+			PieceStrength = Hit.Strength;
+			PreviousDistance = Hit.Distance;
+			PreviousStrength = Hit.Strength;
+			++NextHitIndex;
+		}
+
+		const FVector LineSegmentEnd = StrengthSceneCastInfo.StartLocation + (StrengthSceneCastInfo.CastDirection * DistanceToLineSegmentEnd);
+		AddLine(PieceStart, LineSegmentEnd, PieceStrength);
+	}
+#endif // ENABLE_DRAW_DEBUG
+}
+
 FLinearColor UGCBlueprintFunctionLibrary_DrawDebugHelpersStrengthCollisionQueries::GetDebugColorForStrength(const float InStrength, const float InInitialStrength, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor)
 {
 	return FLinearColor::LerpUsingHSV(InFullStrengthColor, InNoStrengthColor, 1 - (InStrength / InInitialStrength));
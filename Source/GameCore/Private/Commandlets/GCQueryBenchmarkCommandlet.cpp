@@ -0,0 +1,1112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/GCQueryBenchmarkCommandlet.h"
+
+#include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_CollisionQueries.h"
+#include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_StrengthCollisionQueries.h"
+#include "DataAssets/GCBallisticsMaterialProfile.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Subsystems/GCBallisticProjectileSubsystem.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SphereComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/MemoryBase.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Templates/Atomic.h"
+
+
+
+/** Version of our JSON results. Bump when the meaning of the numbers changes so that old baselines aren't compared against. */
+static constexpr int32 QueryBenchmarkVersion = 1;
+
+/** The strength queries' parameters. Enough strength to get through most of every scene. */
+static constexpr float BenchmarkInitialStrength = 2000.f;
+static constexpr float BenchmarkRangeFalloffNerf = .01f;
+static constexpr float BenchmarkPerCmPenetrationNerf = 1.f;
+static constexpr float BenchmarkRicochetNerf = 50.f;
+/** Hits this glancing (cosine of the angle between the query direction and the surface normal) ricochet, and stop the penetration queries */
+static constexpr float BenchmarkMaxGlancingCosine = .2f;
+/** Chunk length for the progressive penetration queries */
+static constexpr float BenchmarkProgressiveChunkLength = 500.f;
+/** Number of advances the cursor query is split into */
+static constexpr int32 BenchmarkNumCursorAdvances = 4;
+/** The projectile simulation's tick. Each ray is a projectile fired fast enough to cover the ray in one tick. */
+static constexpr float BenchmarkProjectileDeltaSeconds = 1.f / 60.f;
+static constexpr int32 BenchmarkProjectileRicochetCap = 2;
+/** How many more heap allocations per query than the baseline's a query can make before it counts as a regression */
+static constexpr double AllocationTolerance = .01;
+
+static bool IsGlancingHit(const FHitResult& InHit)
+{
+	const FVector Direction = (InHit.TraceEnd - InHit.TraceStart).GetSafeNormal();
+	return FMath::Abs(FVector::DotProduct(InHit.ImpactNormal, Direction)) < BenchmarkMaxGlancingCosine;
+}
+
+/** The callbacks given to the callback versions of the queries */
+static auto BenchmarkGetPerCmPenetrationNerf = [](const FHitResult& InHit) -> float { return BenchmarkPerCmPenetrationNerf; };
+static auto BenchmarkGetRicochetNerf = [](const FHitResult& InHit) -> float { return BenchmarkRicochetNerf; };
+static auto BenchmarkIsGlancingHit = [](const FHitResult& InHit) -> bool { return IsGlancingHit(InHit); };
+
+/** The same as the callbacks, for the policy versions of the queries */
+struct FGCQueryBenchmarkPolicy
+{
+	static constexpr bool bHasPenetrationNerf = true;
+	static constexpr bool bCanBeImpenetrable = false;
+	static constexpr bool bCanRicochet = true;
+
+	float GetPerCmPenetrationNerf(const FHitResult& InHit) const { return BenchmarkPerCmPenetrationNerf; }
+	bool IsHitImpenetrable(const FHitResult& InHit) const { return false; }
+	float GetRicochetNerf(const FHitResult& InHit) const { return BenchmarkRicochetNerf; }
+	bool IsHitRicochetable(const FHitResult& InHit) const { return IsGlancingHit(InHit); }
+};
+
+
+/** A segment to query along */
+struct FGCQueryBenchmarkRay
+{
+	FGCQueryBenchmarkRay(const FVector& InStart, const FVector& InEnd)
+		: Start(InStart)
+		, End(InEnd)
+		, Direction((InEnd - InStart).GetSafeNormal())
+		, Distance(FVector::Distance(InStart, InEnd))
+	{
+	}
+
+	FVector Start;
+	FVector End;
+	/** For the queries given a direction and distance cap rather than an end */
+	FVector Direction;
+	float Distance;
+};
+
+/** A procedurally generated world to benchmark the queries in */
+struct FGCQueryBenchmarkScene
+{
+	const TCHAR* Name;
+	/** Mobility of the scene's shapes (movable bodies are kept in a different part of the physics scene's acceleration structure) */
+	EComponentMobility::Type Mobility;
+	/** Adds the scene's shapes to the actor and makes the rays to query along */
+	void (*Build)(AActor* InActor, FRandomStream& InOutRandom, const float InScale, const int32 InNumRays, TArray<FGCQueryBenchmarkRay>& OutRays);
+};
+
+/** SceneCastMultiWithExitHitsBatch() split into one slice of the rays per thread, for a thread count of the sweep */
+struct FGCQueryBenchmarkThreadSweep
+{
+	int32 NumThreads;
+	TArray<TArray<FSceneCastWithExitHitsQuery>> SliceQueries;
+	TArray<TArray<FExitAwareHitResult>> SliceHits;
+	TArray<TArray<FSceneCastWithExitHitsBatchResult>> SliceResults;
+};
+
+/** The output buffers that the queries reuse, like a game would. Our queries append to their outputs, so each query resets the one it returns first. */
+struct FGCQueryBenchmarkContext
+{
+	FExitHitsQueryScratch Scratch;
+	TArray<FHitResult> Hits;
+	TArray<FExitAwareHitResult> ExitAwareHits;
+	TArray<FCompactHitRecord> HitRecords;
+	FPenetrationSceneCastWithExitHitsUsingStrengthResult StrengthResult;
+	FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult CompactStrengthResult;
+	FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult FlatRicochetingResult;
+
+	/** The scene's rays as batch queries */
+	TArray<FSceneCastWithExitHitsQuery> BatchQueries;
+	TArray<FSceneCastWithExitHitsBatchResult> BatchResults;
+	TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery> StrengthBatchQueries;
+	TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult> StrengthBatchResults;
+	FRicochetingStrengthBatchContext StrengthBatchContext;
+	/** The scene's rays as projectiles, put back at their rays before every simulated tick */
+	FGCBallisticProjectiles Projectiles;
+	/** One per thread count of the batch's thread sweep (1, 2, 4, ... up to every worker) */
+	TArray<FGCQueryBenchmarkThreadSweep> ThreadSweeps;
+};
+
+/** A query to benchmark. Either done along each ray (and timed per ray), or done along all of the rays at once (and timed per batch). Both give back the number of hits. */
+struct FGCQueryBenchmarkQuery
+{
+	FString Name;
+	TFunction<int32(const FGCQueryBenchmarkRay&)> RunOne;
+	TFunction<int32()> RunAll;
+};
+
+struct FGCQueryBenchmarkResult
+{
+	FString Scene;
+	FString Query;
+	int32 NumQueries;
+	double AverageHits;
+	double QueriesPerSecond;
+	/** Batched queries are timed as a whole, so theirs are of the per query average of each batch */
+	double P50Microseconds;
+	double P90Microseconds;
+	double P99Microseconds;
+	double MaxMicroseconds;
+	/** Heap allocations made per query (on any thread, so batched queries' worker threads are included), once warmed up */
+	double AllocationsPerQuery;
+};
+
+
+/**
+ * Stands in for GMalloc to count the heap allocations made on every thread while counting. Everything is passed on to the real GMalloc, so memory can be freed whether or not it was allocated while counting.
+ * Never deleted, since other threads may still be in it after it has been swapped back out.
+ */
+class FGCQueryBenchmarkCountingMalloc final : public FMalloc
+{
+public:
+	explicit FGCQueryBenchmarkCountingMalloc(FMalloc* InInnerMalloc)
+		: InnerMalloc(InInnerMalloc)
+		, bCounting(false)
+		, NumAllocations(0)
+	{
+	}
+
+	/** Starts counting from zero */
+	void StartCounting()
+	{
+		NumAllocations = 0;
+		bCounting = true;
+	}
+	void StopCounting() { bCounting = false; }
+
+	int64 GetNumAllocations() const { return NumAllocations; }
+
+	//  BEGIN FMalloc interface
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Count > 0)
+		{
+			CountAllocation();
+		}
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+	virtual void Free(void* Original) override { InnerMalloc->Free(Original); }
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return InnerMalloc->QuantizeSize(Count, Alignment); }
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return InnerMalloc->GetAllocationSize(Original, SizeOut); }
+	virtual void Trim(bool bTrimThreadCaches) override { InnerMalloc->Trim(bTrimThreadCaches); }
+	virtual void SetupTLSCachesOnCurrentThread() override { InnerMalloc->SetupTLSCachesOnCurrentThread(); }
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { InnerMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+	virtual bool IsInternallyThreadSafe() const override { return InnerMalloc->IsInternallyThreadSafe(); }
+	virtual bool ValidateHeap() override { return InnerMalloc->ValidateHeap(); }
+	virtual const TCHAR* GetDescriptiveName() override { return TEXT("GCQueryBenchmarkCountingMalloc"); }
+	//  END FMalloc interface
+
+private:
+	void CountAllocation()
+	{
+		if (bCounting)
+		{
+			++NumAllocations;
+		}
+	}
+
+	FMalloc* InnerMalloc;
+	/** Any thread can allocate, e.g. the workers of a batched query */
+	TAtomic<bool> bCounting;
+	TAtomic<int64> NumAllocations;
+};
+
+/**
+ * Runs the function with GMalloc counting the heap allocations made on every thread (so the worker threads of a batched query are included), and gives back how many were made.
+ * A commandlet has next to nothing else running at the same time, so this is close to what the function itself allocated.
+ */
+static int64 CountAllocations(TFunctionRef<void()> InFunction)
+{
+	static FGCQueryBenchmarkCountingMalloc* CountingMalloc = new FGCQueryBenchmarkCountingMalloc(GMalloc);
+
+	FMalloc* RealMalloc = GMalloc;
+	GMalloc = CountingMalloc;
+	CountingMalloc->StartCounting();
+	InFunction();
+	CountingMalloc->StopCounting();
+	GMalloc = RealMalloc;
+
+	return CountingMalloc->GetNumAllocations();
+}
+
+
+/** Adds a query only shape component to the actor's root */
+static void AddShape(AActor* InActor, const FCollisionShape& InShape, const FTransform& InRelativeTransform, const ECollisionChannel InObjectType = ECollisionChannel::ECC_WorldStatic)
+{
+	UShapeComponent* ShapeComponent;
+	switch (InShape.ShapeType)
+	{
+	case ECollisionShape::Box:
+	{
+		UBoxComponent* BoxComponent = NewObject<UBoxComponent>(InActor);
+		BoxComponent->SetBoxExtent(InShape.GetExtent(), false);
+		ShapeComponent = BoxComponent;
+		break;
+	}
+	case ECollisionShape::Capsule:
+	{
+		UCapsuleComponent* CapsuleComponent = NewObject<UCapsuleComponent>(InActor);
+		CapsuleComponent->SetCapsuleSize(InShape.GetCapsuleRadius(), InShape.GetCapsuleHalfHeight(), false);
+		ShapeComponent = CapsuleComponent;
+		break;
+	}
+	default:
+	{
+		USphereComponent* SphereComponent = NewObject<USphereComponent>(InActor);
+		SphereComponent->SetSphereRadius(InShape.GetSphereRadius(), false);
+		ShapeComponent = SphereComponent;
+		break;
+	}
+	}
+
+	ShapeComponent->SetMobility(InActor->GetRootComponent()->Mobility);
+	ShapeComponent->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	ShapeComponent->SetCollisionObjectType(InObjectType);
+	ShapeComponent->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Block);
+	ShapeComponent->SetupAttachment(InActor->GetRootComponent());
+	ShapeComponent->SetRelativeTransform(InRelativeTransform);
+	ShapeComponent->RegisterComponent();
+}
+
+/** Rows of thin walls. Lots of entrances and exits along every ray, with some rays glancing along the walls to ricochet. */
+static void BuildParallelWalls(AActor* InActor, FRandomStream& InOutRandom, const float InScale, const int32 InNumRays, TArray<FGCQueryBenchmarkRay>& OutRays)
+{
+	const int32 NumWalls = FMath::Max(FMath::RoundToInt(64 * InScale), 1);
+	const float WallSpacing = 100.f;
+	const float WallHalfSize = 1000.f;
+	for (int32 WallIndex = 0; WallIndex < NumWalls; ++WallIndex)
+	{
+		AddShape(InActor, FCollisionShape::MakeBox(FVector(5.f, WallHalfSize, WallHalfSize)), FTransform(FVector(WallIndex * WallSpacing, 0.f, 0.f)));
+	}
+
+	const float FarX = NumWalls * WallSpacing;
+	for (int32 RayIndex = 0; RayIndex < InNumRays; ++RayIndex)
+	{
+		const float Y = InOutRandom.FRandRange(-WallHalfSize * .9f, WallHalfSize * .9f);
+		const float Z = InOutRandom.FRandRange(-WallHalfSize * .9f, WallHalfSize * .9f);
+		if (RayIndex % 10 == 0)
+		{
+			// Glancing along a wall
+			const float X = InOutRandom.RandRange(0, NumWalls - 1) * WallSpacing - 5.f - InOutRandom.FRandRange(1.f, 20.f);
+			OutRays.Emplace(FVector(X, -WallHalfSize * 1.1f, Z), FVector(X + WallSpacing, WallHalfSize * 1.1f, Z));
+			continue;
+		}
+
+		const FVector Jitter = FVector(0.f, InOutRandom.FRandRange(-300.f, 300.f), InOutRandom.FRandRange(-300.f, 300.f));
+		OutRays.Emplace(FVector(-WallSpacing, Y, Z), FVector(FarX + WallSpacing, Y, Z) + Jitter);
+	}
+}
+
+/** Boxes and spheres inside of each other. Rays cross all of them, stacking up the per cm nerfs. */
+static void BuildNestedVolumes(AActor* InActor, FRandomStream& InOutRandom, const float InScale, const int32 InNumRays, TArray<FGCQueryBenchmarkRay>& OutRays)
+{
+	const int32 NumVolumes = FMath::Max(FMath::RoundToInt(24 * InScale), 1);
+	const float VolumeSpacing = 40.f;
+	for (int32 VolumeIndex = 0; VolumeIndex < NumVolumes; ++VolumeIndex)
+	{
+		const float Size = 50.f + VolumeIndex * VolumeSpacing;
+		if (VolumeIndex % 2 == 0)
+		{
+			AddShape(InActor, FCollisionShape::MakeSphere(Size), FTransform::Identity);
+		}
+		else
+		{
+			// Small enough to stay inside of the next sphere
+			const float HalfExtent = (Size + VolumeSpacing) / FMath::Sqrt(3.f);
+			AddShape(InActor, FCollisionShape::MakeBox(FVector(HalfExtent)), FTransform(FRotator(0.f, InOutRandom.FRandRange(0.f, 90.f), 0.f), FVector::ZeroVector));
+		}
+	}
+
+	const float OutsideDistance = 50.f + NumVolumes * VolumeSpacing + 100.f;
+	for (int32 RayIndex = 0; RayIndex < InNumRays; ++RayIndex)
+	{
+		const FVector Direction = InOutRandom.GetUnitVector();
+		const FVector Offset = FVector::VectorPlaneProject(InOutRandom.GetUnitVector(), Direction) * InOutRandom.FRandRange(0.f, 40.f);
+		OutRays.Emplace(Offset - Direction * OutsideDistance, Offset + Direction * OutsideDistance);
+	}
+}
+
+/** A foliage style field of randomly placed and heavily overlapping shapes */
+static void BuildOverlapField(AActor* InActor, FRandomStream& InOutRandom, const float InScale, const int32 InNumRays, TArray<FGCQueryBenchmarkRay>& OutRays)
+{
+	const int32 NumInstances = FMath::Max(FMath::RoundToInt(3000 * InScale), 1);
+	const float FieldHalfSize = 2000.f * FMath::Sqrt(InScale);
+	for (int32 InstanceIndex = 0; InstanceIndex < NumInstances; ++InstanceIndex)
+	{
+		const FVector Location = FVector(InOutRandom.FRandRange(-FieldHalfSize, FieldHalfSize), InOutRandom.FRandRange(-FieldHalfSize, FieldHalfSize), 0.f);
+		const FRotator Rotation = FRotator(InOutRandom.FRandRange(-15.f, 15.f), InOutRandom.FRandRange(0.f, 360.f), InOutRandom.FRandRange(-15.f, 15.f));
+		switch (InstanceIndex % 3)
+		{
+		case 0:
+		{
+			// Trunk
+			const float HalfHeight = InOutRandom.FRandRange(80.f, 200.f);
+			AddShape(InActor, FCollisionShape::MakeCapsule(InOutRandom.FRandRange(10.f, 30.f), HalfHeight), FTransform(Rotation, Location + FVector(0.f, 0.f, HalfHeight)));
+			break;
+		}
+		case 1:
+		{
+			// Bush
+			const float Radius = InOutRandom.FRandRange(20.f, 80.f);
+			AddShape(InActor, FCollisionShape::MakeSphere(Radius), FTransform(Location + FVector(0.f, 0.f, Radius * .5f)));
+			break;
+		}
+		default:
+		{
+			// Rock
+			const FVector Extent = FVector(InOutRandom.FRandRange(20.f, 60.f), InOutRandom.FRandRange(20.f, 60.f), InOutRandom.FRandRange(10.f, 40.f));
+			AddShape(InActor, FCollisionShape::MakeBox(Extent), FTransform(Rotation, Location));
+			break;
+		}
+		}
+	}
+
+	for (int32 RayIndex = 0; RayIndex < InNumRays; ++RayIndex)
+	{
+		const FVector Start = FVector(-FieldHalfSize - 100.f, InOutRandom.FRandRange(-FieldHalfSize, FieldHalfSize), InOutRandom.FRandRange(20.f, 250.f));
+		const FVector End = FVector(FieldHalfSize + 100.f, InOutRandom.FRandRange(-FieldHalfSize, FieldHalfSize), InOutRandom.FRandRange(20.f, 250.f));
+		OutRays.Emplace(Start, End);
+	}
+}
+
+/** A crowd of characters, each made of the body shapes that a character's physics asset would have */
+static void BuildCrowd(AActor* InActor, FRandomStream& InOutRandom, const float InScale, const int32 InNumRays, TArray<FGCQueryBenchmarkRay>& OutRays)
+{
+	struct FBodyPart
+	{
+		FCollisionShape Shape;
+		FVector Location;
+	};
+	const FBodyPart BodyParts[] =
+	{
+		{ FCollisionShape::MakeBox(FVector(12.f, 18.f, 12.f)), FVector(0.f, 0.f, 95.f) },   // Pelvis
+		{ FCollisionShape::MakeCapsule(18.f, 32.f), FVector(0.f, 0.f, 135.f) },           // Spine
+		{ FCollisionShape::MakeSphere(11.f), FVector(0.f, 0.f, 180.f) },                  // Head
+		{ FCollisionShape::MakeCapsule(6.f, 16.f), FVector(0.f, -26.f, 140.f) },          // Upper arms
+		{ FCollisionShape::MakeCapsule(6.f, 16.f), FVector(0.f, 26.f, 140.f) },
+		{ FCollisionShape::MakeCapsule(5.f, 14.f), FVector(0.f, -28.f, 105.f) },          // Lower arms
+		{ FCollisionShape::MakeCapsule(5.f, 14.f), FVector(0.f, 28.f, 105.f) },
+		{ FCollisionShape::MakeCapsule(9.f, 22.f), FVector(0.f, -10.f, 65.f) },           // Thighs
+		{ FCollisionShape::MakeCapsule(9.f, 22.f), FVector(0.f, 10.f, 65.f) },
+		{ FCollisionShape::MakeCapsule(7.f, 22.f), FVector(0.f, -10.f, 22.f) },           // Calves
+		{ FCollisionShape::MakeCapsule(7.f, 22.f), FVector(0.f, 10.f, 22.f) }
+	};
+
+	const int32 NumCharacters = FMath::Max(FMath::RoundToInt(150 * InScale), 1);
+	const int32 NumCharactersPerRow = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)));
+	const float CharacterSpacing = 120.f;
+	for (int32 CharacterIndex = 0; CharacterIndex < NumCharacters; ++CharacterIndex)
+	{
+		const FVector Location = FVector((CharacterIndex % NumCharactersPerRow) * CharacterSpacing, (CharacterIndex / NumCharactersPerRow) * CharacterSpacing, 0.f) + FVector(InOutRandom.FRandRange(-40.f, 40.f), InOutRandom.FRandRange(-40.f, 40.f), 0.f);
+		const FTransform CharacterTransform = FTransform(FRotator(0.f, InOutRandom.FRandRange(0.f, 360.f), 0.f), Location);
+		for (const FBodyPart& BodyPart : BodyParts)
+		{
+			AddShape(InActor, BodyPart.Shape, FTransform(BodyPart.Location) * CharacterTransform, ECollisionChannel::ECC_Pawn);
+		}
+	}
+
+	const float CrowdSize = NumCharactersPerRow * CharacterSpacing;
+	for (int32 RayIndex = 0; RayIndex < InNumRays; ++RayIndex)
+	{
+		const FVector Start = FVector(-200.f, InOutRandom.FRandRange(0.f, CrowdSize), InOutRandom.FRandRange(10.f, 190.f));
+		const FVector End = FVector(CrowdSize + 200.f, InOutRandom.FRandRange(0.f, CrowdSize), InOutRandom.FRandRange(10.f, 190.f));
+		OutRays.Emplace(Start, End);
+	}
+}
+
+static const FGCQueryBenchmarkScene BenchmarkScenes[] =
+{
+	{ TEXT("ParallelWalls"), EComponentMobility::Static, &BuildParallelWalls },
+	{ TEXT("NestedVolumes"), EComponentMobility::Static, &BuildNestedVolumes },
+	{ TEXT("OverlapField"), EComponentMobility::Static, &BuildOverlapField },
+	{ TEXT("Crowd"), EComponentMobility::Movable, &BuildCrowd }
+};
+
+
+/** Puts each projectile back at the start of its ray, without reallocating any of the projectiles' memory */
+static void ResetBenchmarkProjectiles(const TArray<FGCQueryBenchmarkRay>& InRays, FGCBallisticProjectiles& InOutProjectiles)
+{
+	for (int32 i = 0; i < InOutProjectiles.Num(); ++i)
+	{
+		const FGCQueryBenchmarkRay& Ray = InRays[i];
+		InOutProjectiles.Locations[i] = Ray.Start;
+		InOutProjectiles.Velocities[i] = Ray.Direction * (Ray.Distance / BenchmarkProjectileDeltaSeconds);
+		InOutProjectiles.RemainingRicochets[i] = BenchmarkProjectileRicochetCap;
+		InOutProjectiles.RemainingLifetimes[i] = 1.f;
+		InOutProjectiles.PerCmNerfStacks[i] = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+		InOutProjectiles.Finished[i] = false;
+	}
+}
+
+/** Makes every query of both libraries (except the async ones, which finish on the world's tick), and the projectile subsystem's simulation */
+static void MakeQueries(UWorld* InWorld, UGCBallisticsMaterialProfile& InMaterialProfile, const TArray<FGCQueryBenchmarkRay>& InRays, FGCQueryBenchmarkContext& InOutContext, TArray<FGCQueryBenchmarkQuery>& OutQueries)
+{
+	using FCollisionQueries = UGCBlueprintFunctionLibrary_CollisionQueries;
+	using FStrengthCollisionQueries = UGCBlueprintFunctionLibrary_StrengthCollisionQueries;
+
+	const ECollisionChannel TraceChannel = ECollisionChannel::ECC_Visibility;
+	const FCollisionShape LineShape = FCollisionShape::LineShape;
+	const FCollisionShape SphereShape = FCollisionShape::MakeSphere(5.f);
+	const FCollisionQueryParams& QueryParams = FCollisionQueryParams::DefaultQueryParam;
+	const FCollisionResponseParams& ResponseParams = FCollisionResponseParams::DefaultResponseParam;
+
+	InOutContext.Scratch.SetCollisionParams(QueryParams, ResponseParams);
+	for (const FGCQueryBenchmarkRay& Ray : InRays)
+	{
+		FSceneCastWithExitHitsQuery& BatchQuery = InOutContext.BatchQueries.AddDefaulted_GetRef();
+		BatchQuery.Start = Ray.Start;
+		BatchQuery.End = Ray.End;
+		BatchQuery.TraceChannel = TraceChannel;
+
+		FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery& StrengthBatchQuery = InOutContext.StrengthBatchQueries.AddDefaulted_GetRef();
+		StrengthBatchQuery.InitialStrength = BenchmarkInitialStrength;
+		StrengthBatchQuery.RangeFalloffNerf = BenchmarkRangeFalloffNerf;
+		StrengthBatchQuery.Start = Ray.Start;
+		StrengthBatchQuery.Direction = Ray.Direction;
+		StrengthBatchQuery.DistanceCap = Ray.Distance;
+		StrengthBatchQuery.TraceChannel = TraceChannel;
+
+		FGCBallisticProjectileParams ProjectileParams;
+		ProjectileParams.Location = Ray.Start;
+		ProjectileParams.Velocity = Ray.Direction * (Ray.Distance / BenchmarkProjectileDeltaSeconds);
+		ProjectileParams.Strength = BenchmarkInitialStrength;
+		ProjectileParams.GravityScale = 0.f; // stay on the ray
+		ProjectileParams.RangeFalloffNerf = BenchmarkRangeFalloffNerf;
+		ProjectileParams.RicochetCap = BenchmarkProjectileRicochetCap;
+		InOutContext.Projectiles.Add(ProjectileParams);
+	}
+
+	auto AddQuery = [&OutQueries](const FString& InName, TFunction<int32(const FGCQueryBenchmarkRay&)>&& InRunOne)
+	{
+		FGCQueryBenchmarkQuery& Query = OutQueries.AddDefaulted_GetRef();
+		Query.Name = InName;
+		Query.RunOne = MoveTemp(InRunOne);
+	};
+	auto AddBatchQuery = [&OutQueries](const FString& InName, TFunction<int32()>&& InRunAll)
+	{
+		FGCQueryBenchmarkQuery& Query = OutQueries.AddDefaulted_GetRef();
+		Query.Name = InName;
+		Query.RunAll = MoveTemp(InRunAll);
+	};
+
+
+	//  BEGIN Collision queries
+	AddQuery(TEXT("SceneCastMultiByChannel"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			FCollisionQueries::SceneCastMultiByChannel(InWorld, InOutContext.Hits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams);
+			return InOutContext.Hits.Num();
+		});
+	AddQuery(TEXT("SceneCastMultiWithExitHits"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::SceneCastMultiWithExitHits(InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("SceneCastMultiWithExitHits (sphere sweep)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::SceneCastMultiWithExitHits(InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, SphereShape, QueryParams, ResponseParams);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("SceneCastMultiWithExitHits (scratch)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::SceneCastMultiWithExitHits(InOutContext.Scratch, InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("SceneCastMultiWithExitHits (scratch, compact)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.HitRecords.Reset();
+			FCollisionQueries::SceneCastMultiWithExitHits(InOutContext.Scratch, InWorld, InOutContext.HitRecords, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape);
+			return InOutContext.HitRecords.Num();
+		});
+	AddQuery(TEXT("SceneCastMultiWithExitHits (scratch, simple body queries)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::SceneCastMultiWithExitHits(InOutContext.Scratch, InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, false, false, EExitHitsMethod::SimpleBodyQueries);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("SceneCastMultiWithExitHits (scratch, bounded backwards scene casts)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::SceneCastMultiWithExitHits(InOutContext.Scratch, InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, false, false, EExitHitsMethod::BoundedBackwardsSceneCasts, EFurthestPossibleExitMethod::OrientedBounds);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddBatchQuery(TEXT("SceneCastMultiWithExitHitsBatch"), [=, &InOutContext]() -> int32
+		{
+			FCollisionQueries::SceneCastMultiWithExitHitsBatch(InWorld, InOutContext.BatchQueries, InOutContext.ExitAwareHits, InOutContext.BatchResults, false);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddBatchQuery(TEXT("SceneCastMultiWithExitHitsBatch (parallel)"), [=, &InOutContext]() -> int32
+		{
+			FCollisionQueries::SceneCastMultiWithExitHitsBatch(InWorld, InOutContext.BatchQueries, InOutContext.ExitAwareHits, InOutContext.BatchResults, true);
+			return InOutContext.ExitAwareHits.Num();
+		});
+
+	// Thread sweep of the batch. Each thread does its slice of the rays as a batch of its own, so the thread count is exactly how many workers scene cast at once, which shows how the batch scales.
+	const int32 MaxNumThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1; // the calling thread works too
+	TArray<int32> SweepNumThreads;
+	for (int32 NumThreads = 1; NumThreads < MaxNumThreads; NumThreads *= 2)
+	{
+		SweepNumThreads.Add(NumThreads);
+	}
+	SweepNumThreads.Add(MaxNumThreads);
+
+	for (const int32 NumThreads : SweepNumThreads)
+	{
+		FGCQueryBenchmarkThreadSweep& ThreadSweep = InOutContext.ThreadSweeps.AddDefaulted_GetRef();
+		ThreadSweep.NumThreads = NumThreads;
+		ThreadSweep.SliceQueries.SetNum(NumThreads);
+		ThreadSweep.SliceHits.SetNum(NumThreads);
+		ThreadSweep.SliceResults.SetNum(NumThreads);
+		for (int32 QueryIndex = 0; QueryIndex < InOutContext.BatchQueries.Num(); ++QueryIndex)
+		{
+			ThreadSweep.SliceQueries[(QueryIndex * NumThreads) / InOutContext.BatchQueries.Num()].Add(InOutContext.BatchQueries[QueryIndex]);
+		}
+
+		const int32 ThreadSweepIndex = InOutContext.ThreadSweeps.Num() - 1;
+		AddBatchQuery(FString::Printf(TEXT("SceneCastMultiWithExitHitsBatch (%d threads)"), NumThreads), [=, &InOutContext]() -> int32
+			{
+				FGCQueryBenchmarkThreadSweep& Sweep = InOutContext.ThreadSweeps[ThreadSweepIndex];
+				ParallelFor(Sweep.NumThreads, [&Sweep, InWorld](int32 SliceIndex)
+					{
+						FCollisionQueries::SceneCastMultiWithExitHitsBatch(InWorld, Sweep.SliceQueries[SliceIndex], Sweep.SliceHits[SliceIndex], Sweep.SliceResults[SliceIndex], false);
+					},
+					EParallelForFlags::Unbalanced);
+
+				int32 NumHits = 0;
+				for (const TArray<FExitAwareHitResult>& SliceHits : Sweep.SliceHits)
+				{
+					NumHits += SliceHits.Num();
+				}
+				return NumHits;
+			});
+	}
+	AddQuery(TEXT("PenetrationSceneCast"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			FCollisionQueries::PenetrationSceneCast(InWorld, InOutContext.Hits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, BenchmarkIsGlancingHit);
+			return InOutContext.Hits.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCast (progressive)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			FCollisionQueries::PenetrationSceneCast(InWorld, InOutContext.Hits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, BenchmarkIsGlancingHit, BenchmarkProgressiveChunkLength);
+			return InOutContext.Hits.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHits"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::PenetrationSceneCastWithExitHits(InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, BenchmarkIsGlancingHit);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHits (sphere sweep)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::PenetrationSceneCastWithExitHits(InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, SphereShape, QueryParams, ResponseParams, BenchmarkIsGlancingHit);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHits (scratch)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::PenetrationSceneCastWithExitHits(InOutContext.Scratch, InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, BenchmarkIsGlancingHit);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHits (scratch, compact)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.HitRecords.Reset();
+			FCollisionQueries::PenetrationSceneCastWithExitHits(InOutContext.Scratch, InWorld, InOutContext.HitRecords, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, BenchmarkIsGlancingHit);
+			return InOutContext.HitRecords.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHits (scratch, progressive)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.ExitAwareHits.Reset();
+			FCollisionQueries::PenetrationSceneCastWithExitHits(InOutContext.Scratch, InWorld, InOutContext.ExitAwareHits, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, BenchmarkIsGlancingHit, false, false, EExitHitsMethod::BackwardsSceneCast, EFurthestPossibleExitMethod::BoundingSphere, BenchmarkProgressiveChunkLength);
+			return InOutContext.ExitAwareHits.Num();
+		});
+	//  END Collision queries
+
+
+	//  BEGIN Strength collision queries
+	AddQuery(TEXT("PenetrationSceneCastWithExitHitsUsingStrength"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.StrengthResult.HitResults.Reset();
+			FStrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, BenchmarkRangeFalloffNerf, InWorld, InOutContext.StrengthResult, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, BenchmarkGetPerCmPenetrationNerf, BenchmarkIsGlancingHit);
+			return InOutContext.StrengthResult.HitResults.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHitsUsingStrength (compact)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.CompactStrengthResult.HitRecords.Reset();
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.CompactStrengthResult, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, BenchmarkGetPerCmPenetrationNerf, BenchmarkIsGlancingHit);
+			return InOutContext.CompactStrengthResult.HitRecords.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHitsUsingStrength (compact, scratch)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.CompactStrengthResult.HitRecords.Reset();
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(InOutContext.Scratch, BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.CompactStrengthResult, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, BenchmarkGetPerCmPenetrationNerf, BenchmarkIsGlancingHit);
+			return InOutContext.CompactStrengthResult.HitRecords.Num();
+		});
+	AddQuery(TEXT("PenetrationSceneCastWithExitHitsUsingStrength (material profile)"), [=, &InOutContext, &InMaterialProfile](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.StrengthResult.HitResults.Reset();
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.StrengthResult, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, InMaterialProfile, QueryParams, ResponseParams);
+			return InOutContext.StrengthResult.HitResults.Num();
+		});
+	AddQuery(TEXT("PolicyPenetrationSceneCastWithExitHitsUsingStrength"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.StrengthResult.HitResults.Reset();
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::PolicyPenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.StrengthResult, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, FGCQueryBenchmarkPolicy(), FGCNeverImpenetrablePolicy());
+			return InOutContext.StrengthResult.HitResults.Num();
+		});
+	AddQuery(TEXT("PolicyPenetrationSceneCastWithExitHitsUsingStrength (compact, scratch)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			InOutContext.CompactStrengthResult.HitRecords.Reset();
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::PolicyPenetrationSceneCastWithExitHitsUsingStrength(InOutContext.Scratch, BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.CompactStrengthResult, InRay.Start, InRay.End, FQuat::Identity, TraceChannel, LineShape, FGCQueryBenchmarkPolicy(), FGCNeverImpenetrablePolicy());
+			return InOutContext.CompactStrengthResult.HitRecords.Num();
+		});
+	AddQuery(TEXT("RicochetingPenetrationSceneCastWithExitHitsUsingStrength"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			// The nested result isn't reset by the query, so a new one is made each time like callers do
+			FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult Result;
+			FStrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, BenchmarkRangeFalloffNerf, InWorld, Result, InRay.Start, InRay.Direction, InRay.Distance, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, -1, BenchmarkGetPerCmPenetrationNerf, BenchmarkGetRicochetNerf, BenchmarkIsGlancingHit);
+
+			int32 NumHits = 0;
+			for (const FPenetrationSceneCastWithExitHitsUsingStrengthResult& SceneCastResult : Result.PenetrationSceneCastWithExitHitsUsingStrengthResults)
+			{
+				NumHits += SceneCastResult.HitResults.Num();
+			}
+			return NumHits;
+		});
+	AddQuery(TEXT("RicochetingPenetrationSceneCastWithExitHitsUsingStrength (flat)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			FStrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, BenchmarkRangeFalloffNerf, InWorld, InOutContext.FlatRicochetingResult, InRay.Start, InRay.Direction, InRay.Distance, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, -1, BenchmarkGetPerCmPenetrationNerf, BenchmarkGetRicochetNerf, BenchmarkIsGlancingHit);
+			return InOutContext.FlatRicochetingResult.HitResults.Num();
+		});
+	AddQuery(TEXT("RicochetingPenetrationSceneCastWithExitHitsUsingStrength (flat, material profile)"), [=, &InOutContext, &InMaterialProfile](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.FlatRicochetingResult, InRay.Start, InRay.Direction, InRay.Distance, FQuat::Identity, TraceChannel, LineShape, InMaterialProfile, QueryParams, ResponseParams);
+			return InOutContext.FlatRicochetingResult.HitResults.Num();
+		});
+	AddQuery(TEXT("PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength (flat)"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			FPenetrationNerfStack PerCmNerfStack = FPenetrationNerfStack(BenchmarkRangeFalloffNerf);
+			FStrengthCollisionQueries::PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength(BenchmarkInitialStrength, PerCmNerfStack, InWorld, InOutContext.FlatRicochetingResult, InRay.Start, InRay.Direction, InRay.Distance, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, -1, FGCQueryBenchmarkPolicy(), FGCQueryBenchmarkPolicy());
+			return InOutContext.FlatRicochetingResult.HitResults.Num();
+		});
+	AddBatchQuery(TEXT("PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch"), [=, &InOutContext]() -> int32
+		{
+			FStrengthCollisionQueries::PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(InOutContext.StrengthBatchContext, InWorld, InOutContext.StrengthBatchQueries, InOutContext.StrengthBatchResults, false, FGCQueryBenchmarkPolicy(), FGCQueryBenchmarkPolicy());
+
+			int32 NumHits = 0;
+			for (const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& Result : InOutContext.StrengthBatchResults)
+			{
+				NumHits += Result.HitResults.Num();
+			}
+			return NumHits;
+		});
+	AddBatchQuery(TEXT("PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch (parallel)"), [=, &InOutContext]() -> int32
+		{
+			FStrengthCollisionQueries::PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(InOutContext.StrengthBatchContext, InWorld, InOutContext.StrengthBatchQueries, InOutContext.StrengthBatchResults, true, FGCQueryBenchmarkPolicy(), FGCQueryBenchmarkPolicy());
+
+			int32 NumHits = 0;
+			for (const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& Result : InOutContext.StrengthBatchResults)
+			{
+				NumHits += Result.HitResults.Num();
+			}
+			return NumHits;
+		});
+	AddBatchQuery(TEXT("RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch (material profile, parallel)"), [=, &InOutContext, &InMaterialProfile]() -> int32
+		{
+			FStrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(InOutContext.StrengthBatchContext, InWorld, InOutContext.StrengthBatchQueries, InMaterialProfile, InOutContext.StrengthBatchResults, true);
+
+			int32 NumHits = 0;
+			for (const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& Result : InOutContext.StrengthBatchResults)
+			{
+				NumHits += Result.HitResults.Num();
+			}
+			return NumHits;
+		});
+	AddQuery(TEXT("AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength"), [=, &InOutContext](const FGCQueryBenchmarkRay& InRay) -> int32
+		{
+			// The whole distance over a few advances, like a projectile would over a few frames
+			FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor Cursor = FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor(BenchmarkInitialStrength, BenchmarkRangeFalloffNerf, InRay.Start, InRay.Direction, InRay.Distance);
+			InOutContext.FlatRicochetingResult.Reset();
+			for (int32 AdvanceIndex = 0; AdvanceIndex < BenchmarkNumCursorAdvances && !Cursor.bFinished; ++AdvanceIndex)
+			{
+				FStrengthCollisionQueries::AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(Cursor, InRay.Distance / BenchmarkNumCursorAdvances, InWorld, InOutContext.FlatRicochetingResult, FQuat::Identity, TraceChannel, LineShape, QueryParams, ResponseParams, BenchmarkGetPerCmPenetrationNerf, BenchmarkGetRicochetNerf, BenchmarkIsGlancingHit);
+			}
+			return InOutContext.FlatRicochetingResult.HitResults.Num();
+		});
+	//  END Strength collision queries
+
+
+	//  BEGIN Ballistic projectiles
+	UGCBallisticProjectileSubsystem* ProjectileSubsystem = InWorld->GetSubsystem<UGCBallisticProjectileSubsystem>();
+	if (ProjectileSubsystem)
+	{
+		ProjectileSubsystem->TraceChannel = TraceChannel;
+		ProjectileSubsystem->SetMaterialProfile(&InMaterialProfile);
+
+		AddBatchQuery(TEXT("UGCBallisticProjectileSubsystem::SimulateProjectiles (one tick)"), [&InRays, &InOutContext, ProjectileSubsystem]() -> int32
+			{
+				ResetBenchmarkProjectiles(InRays, InOutContext.Projectiles);
+				ProjectileSubsystem->SimulateProjectiles(InOutContext.Projectiles, BenchmarkProjectileDeltaSeconds);
+
+				int32 NumHits = 0;
+				for (const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& TickResult : InOutContext.Projectiles.TickResults)
+				{
+					NumHits += TickResult.HitResults.Num();
+				}
+				return NumHits;
+			});
+	}
+	//  END Ballistic projectiles
+}
+
+/** Gets the value at a percentile (0 to 100) of sorted values */
+static double GetPercentile(const TArray<double>& InSortedValues, const double InPercentile)
+{
+	if (InSortedValues.Num() <= 0)
+	{
+		return 0.0;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt((InPercentile / 100.0) * InSortedValues.Num()) - 1, 0, InSortedValues.Num() - 1);
+	return InSortedValues[Index];
+}
+
+static FGCQueryBenchmarkResult RunQuery(const FGCQueryBenchmarkQuery& InQuery, const TArray<FGCQueryBenchmarkRay>& InRays, const int32 InNumIterations)
+{
+	// Warm up the output buffers and caches so that the first iteration doesn't pay for them
+	if (InQuery.RunOne)
+	{
+		for (int32 RayIndex = 0; RayIndex < FMath::Min(InRays.Num(), 32); ++RayIndex)
+		{
+			InQuery.RunOne(InRays[RayIndex]);
+		}
+	}
+	else
+	{
+		InQuery.RunAll();
+	}
+
+	TArray<double> Microseconds;
+	Microseconds.Reserve(InQuery.RunOne ? InRays.Num() * InNumIterations : InNumIterations);
+	double TotalSeconds = 0.0;
+	int64 NumHits = 0;
+
+	for (int32 Iteration = 0; Iteration < InNumIterations; ++Iteration)
+	{
+		if (InQuery.RunOne)
+		{
+			for (const FGCQueryBenchmarkRay& Ray : InRays)
+			{
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				NumHits += InQuery.RunOne(Ray);
+				const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+				TotalSeconds += Seconds;
+				Microseconds.Add(Seconds * 1000000.0);
+			}
+		}
+		else
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			NumHits += InQuery.RunAll();
+			const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+			TotalSeconds += Seconds;
+			Microseconds.Add((Seconds * 1000000.0) / FMath::Max(InRays.Num(), 1));
+		}
+	}
+	Microseconds.Sort();
+
+	// Count the heap allocations of one more pass, now that the output buffers and scratches are warmed up
+	const int64 NumAllocations = CountAllocations([&InQuery, &InRays]()
+		{
+			if (InQuery.RunOne)
+			{
+				for (const FGCQueryBenchmarkRay& Ray : InRays)
+				{
+					InQuery.RunOne(Ray);
+				}
+			}
+			else
+			{
+				InQuery.RunAll();
+			}
+		});
+
+	FGCQueryBenchmarkResult Result;
+	Result.Query = InQuery.Name;
+	Result.NumQueries = InRays.Num() * InNumIterations;
+	Result.AverageHits = (Result.NumQueries > 0 ? static_cast<double>(NumHits) / Result.NumQueries : 0.0);
+	Result.QueriesPerSecond = (TotalSeconds > 0.0 ? Result.NumQueries / TotalSeconds : 0.0);
+	Result.P50Microseconds = GetPercentile(Microseconds, 50.0);
+	Result.P90Microseconds = GetPercentile(Microseconds, 90.0);
+	Result.P99Microseconds = GetPercentile(Microseconds, 99.0);
+	Result.MaxMicroseconds = GetPercentile(Microseconds, 100.0);
+	Result.AllocationsPerQuery = static_cast<double>(NumAllocations) / FMath::Max(InRays.Num(), 1);
+	return Result;
+}
+
+static FString GetResultKey(const FString& InScene, const FString& InQuery)
+{
+	return InScene + TEXT("/") + InQuery;
+}
+
+static bool SaveResults(const FString& InFilename, const TArray<FGCQueryBenchmarkResult>& InResults, const float InScale, const int32 InNumRays, const int32 InNumIterations, const int32 InSeed)
+{
+	TArray<TSharedPtr<FJsonValue>> ResultValues;
+	for (const FGCQueryBenchmarkResult& Result : InResults)
+	{
+		TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+		ResultObject->SetStringField(TEXT("Scene"), Result.Scene);
+		ResultObject->SetStringField(TEXT("Query"), Result.Query);
+		ResultObject->SetNumberField(TEXT("NumQueries"), Result.NumQueries);
+		ResultObject->SetNumberField(TEXT("AverageHits"), Result.AverageHits);
+		ResultObject->SetNumberField(TEXT("QueriesPerSecond"), Result.QueriesPerSecond);
+		ResultObject->SetNumberField(TEXT("P50Microseconds"), Result.P50Microseconds);
+		ResultObject->SetNumberField(TEXT("P90Microseconds"), Result.P90Microseconds);
+		ResultObject->SetNumberField(TEXT("P99Microseconds"), Result.P99Microseconds);
+		ResultObject->SetNumberField(TEXT("MaxMicroseconds"), Result.MaxMicroseconds);
+		ResultObject->SetNumberField(TEXT("AllocationsPerQuery"), Result.AllocationsPerQuery);
+		ResultValues.Add(MakeShared<FJsonValueObject>(ResultObject));
+	}
+
+	TSharedRef<FJsonObject> RootObject = MakeShared<FJsonObject>();
+	RootObject->SetNumberField(TEXT("Version"), QueryBenchmarkVersion);
+	RootObject->SetStringField(TEXT("Platform"), ANSI_TO_TCHAR(FPlatformProperties::PlatformName()));
+	RootObject->SetNumberField(TEXT("Scale"), InScale);
+	RootObject->SetNumberField(TEXT("NumRays"), InNumRays);
+	RootObject->SetNumberField(TEXT("NumIterations"), InNumIterations);
+	RootObject->SetNumberField(TEXT("Seed"), InSeed);
+	RootObject->SetArrayField(TEXT("Results"), ResultValues);
+
+	FString OutputString;
+	TSharedRef<TJsonWriter<>> JsonWriter = TJsonWriterFactory<>::Create(&OutputString);
+	if (!FJsonSerializer::Serialize(RootObject, JsonWriter) || !FFileHelper::SaveStringToFile(OutputString, *InFilename))
+	{
+		UE_LOG(LogGCQueryBenchmark, Error, TEXT("%s() Couldn't write results to \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename);
+		return false;
+	}
+
+	UE_LOG(LogGCQueryBenchmark, Display, TEXT("%s() Wrote results to \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename);
+	return true;
+}
+
+/** Reads the queries per second and allocations per query of a results file made by SaveResults(). Older results files have no allocations per query. */
+static bool LoadBaseline(const FString& InFilename, TMap<FString, double>& OutQueriesPerSecond, TMap<FString, double>& OutAllocationsPerQuery)
+{
+	FString InputString;
+	if (!FFileHelper::LoadFileToString(InputString, *InFilename))
+	{
+		UE_LOG(LogGCQueryBenchmark, Error, TEXT("%s() Couldn't read baseline \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> RootObject;
+	const TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create(InputString);
+	const TArray<TSharedPtr<FJsonValue>>* ResultValues = nullptr;
+	if (!FJsonSerializer::Deserialize(JsonReader, RootObject) || !RootObject.IsValid() || !RootObject->TryGetArrayField(TEXT("Results"), ResultValues))
+	{
+		UE_LOG(LogGCQueryBenchmark, Error, TEXT("%s() Baseline \"%s\" isn't a results file."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename);
+		return false;
+	}
+
+	int32 Version = 0;
+	RootObject->TryGetNumberField(TEXT("Version"), Version);
+	if (Version != QueryBenchmarkVersion)
+	{
+		UE_LOG(LogGCQueryBenchmark, Error, TEXT("%s() Baseline \"%s\" is version %d, but we are version %d. Make a new baseline."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename, Version, QueryBenchmarkVersion);
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& ResultValue : *ResultValues)
+	{
+		const TSharedPtr<FJsonObject>* ResultObject = nullptr;
+		FString Scene;
+		FString Query;
+		double QueriesPerSecond;
+		if (ResultValue->TryGetObject(ResultObject)
+			&& (*ResultObject)->TryGetStringField(TEXT("Scene"), Scene)
+			&& (*ResultObject)->TryGetStringField(TEXT("Query"), Query)
+			&& (*ResultObject)->TryGetNumberField(TEXT("QueriesPerSecond"), QueriesPerSecond))
+		{
+			OutQueriesPerSecond.Add(GetResultKey(Scene, Query), QueriesPerSecond);
+
+			double AllocationsPerQuery;
+			if ((*ResultObject)->TryGetNumberField(TEXT("AllocationsPerQuery"), AllocationsPerQuery))
+			{
+				OutAllocationsPerQuery.Add(GetResultKey(Scene, Query), AllocationsPerQuery);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+UGCQueryBenchmarkCommandlet::UGCQueryBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UGCQueryBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString OutputFilename = FPaths::ProjectSavedDir() / TEXT("GCQueryBenchmark.json");
+	FParse::Value(*Params, TEXT("Output="), OutputFilename);
+	FString BaselineFilename;
+	FParse::Value(*Params, TEXT("Baseline="), BaselineFilename);
+	float TolerancePercent = 10.f;
+	FParse::Value(*Params, TEXT("Tolerance="), TolerancePercent);
+	float Scale = 1.f;
+	FParse::Value(*Params, TEXT("Scale="), Scale);
+	Scale = FMath::Max(Scale, .01f);
+	int32 NumRays = 1000;
+	FParse::Value(*Params, TEXT("Rays="), NumRays);
+	NumRays = FMath::Max(NumRays, 1);
+	int32 NumIterations = 3;
+	FParse::Value(*Params, TEXT("Iterations="), NumIterations);
+	NumIterations = FMath::Max(NumIterations, 1);
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FString SceneFilter;
+	FParse::Value(*Params, TEXT("Scene="), SceneFilter);
+	FString QueryFilter;
+	FParse::Value(*Params, TEXT("Query="), QueryFilter);
+
+	TMap<FString, double> BaselineQueriesPerSecond;
+	TMap<FString, double> BaselineAllocationsPerQuery;
+	if (!BaselineFilename.IsEmpty() && !LoadBaseline(BaselineFilename, BaselineQueriesPerSecond, BaselineAllocationsPerQuery))
+	{
+		return 1;
+	}
+
+	// Every surface gets the profile's default properties. Enough to measure the cost of looking them up.
+	UGCBallisticsMaterialProfile* MaterialProfile = NewObject<UGCBallisticsMaterialProfile>(GetTransientPackage());
+	MaterialProfile->AddToRoot();
+
+
+	// Run every query in every scene
+	TArray<FGCQueryBenchmarkResult> Results;
+	int32 NumScratchAllocationFailures = 0;
+	for (const FGCQueryBenchmarkScene& Scene : BenchmarkScenes)
+	{
+		if (!SceneFilter.IsEmpty() && SceneFilter != Scene.Name)
+		{
+			continue;
+		}
+
+		UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, FName(Scene.Name));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		AActor* SceneActor = World->SpawnActor<AActor>();
+		USceneComponent* RootComponent = NewObject<USceneComponent>(SceneActor);
+		RootComponent->SetMobility(Scene.Mobility);
+		SceneActor->SetRootComponent(RootComponent);
+		RootComponent->RegisterComponent();
+
+		FRandomStream Random = FRandomStream(Seed);
+		TArray<FGCQueryBenchmarkRay> Rays;
+		Rays.Reserve(NumRays);
+		Scene.Build(SceneActor, Random, Scale, NumRays, Rays);
+
+		// Let the physics scene take in the new bodies before querying it
+		World->Tick(ELevelTick::LEVELTICK_All, 1.f / 60.f);
+		World->Tick(ELevelTick::LEVELTICK_All, 1.f / 60.f);
+
+		UE_LOG(LogGCQueryBenchmark, Display, TEXT("%s() Scene %s: %d shapes, %d rays, %d iteration(s)."), ANSI_TO_TCHAR(__FUNCTION__), Scene.Name, SceneActor->GetComponents().Num() - 1, Rays.Num(), NumIterations);
+
+		FGCQueryBenchmarkContext Context;
+		TArray<FGCQueryBenchmarkQuery> Queries;
+		MakeQueries(World, *MaterialProfile, Rays, Context, Queries);
+		for (const FGCQueryBenchmarkQuery& Query : Queries)
+		{
+			if (!QueryFilter.IsEmpty() && !FCString::Stristr(*Query.Name, *QueryFilter))
+			{
+				continue;
+			}
+
+			FGCQueryBenchmarkResult& Result = Results.Add_GetRef(RunQuery(Query, Rays, NumIterations));
+			Result.Scene = Scene.Name;
+			UE_LOG(LogGCQueryBenchmark, Display, TEXT("    %-90s %10.0f queries/s  p50 %8.2f us  p90 %8.2f us  p99 %8.2f us  max %8.2f us  %6.2f allocs  (%.1f hits)"), *Result.Query, Result.QueriesPerSecond, Result.P50Microseconds, Result.P90Microseconds, Result.P99Microseconds, Result.MaxMicroseconds, Result.AllocationsPerQuery, Result.AverageHits);
+			if (Result.AllocationsPerQuery > 0.0 && FCString::Stristr(*Query.Name, TEXT("scratch")))
+			{
+				// A warmed up scratch means no allocations (see FExitHitsQueryScratch)
+				UE_LOG(LogGCQueryBenchmark, Error, TEXT("%s() %s / %s still allocates %.2f times per query with a warmed up scratch."), ANSI_TO_TCHAR(__FUNCTION__), Scene.Name, *Result.Query, Result.AllocationsPerQuery);
+				++NumScratchAllocationFailures;
+			}
+		}
+
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	MaterialProfile->RemoveFromRoot();
+
+	if (!SaveResults(OutputFilename, Results, Scale, NumRays, NumIterations, Seed))
+	{
+		return 1;
+	}
+
+
+	if (NumScratchAllocationFailures > 0)
+	{
+		UE_LOG(LogGCQueryBenchmark, Error, TEXT("%s() %d query(s) allocated with a warmed up scratch."), ANSI_TO_TCHAR(__FUNCTION__), NumScratchAllocationFailures);
+	}
+
+	// Compare with the baseline
+	if (BaselineFilename.IsEmpty())
+	{
+		return (NumScratchAllocationFailures > 0) ? 1 : 0;
+	}
+
+	int32 NumRegressions = 0;
+	for (const FGCQueryBenchmarkResult& Result : Results)
+	{
+		const double* BaselineValue = BaselineQueriesPerSecond.Find(GetResultKey(Result.Scene, Result.Query));
+		if (!BaselineValue || *BaselineValue <= 0.0)
+		{
+			UE_LOG(LogGCQueryBenchmark, Display, TEXT("%s() %s / %s isn't in the baseline."), ANSI_TO_TCHAR(__FUNCTION__), *Result.Scene, *Result.Query);
+			continue;
+		}
+
+		const double ChangePercent = ((Result.QueriesPerSecond - *BaselineValue) / *BaselineValue) * 100.0;
+		if (ChangePercent < -TolerancePercent)
+		{
+			UE_LOG(LogGCQueryBenchmark, Warning, TEXT("%s() %s / %s regressed %.1f%% (%.0f queries/s, baseline %.0f)."), ANSI_TO_TCHAR(__FUNCTION__), *Result.Scene, *Result.Query, -ChangePercent, Result.QueriesPerSecond, *BaselineValue);
+			++NumRegressions;
+		}
+		else if (ChangePercent > TolerancePercent)
+		{
+			UE_LOG(LogGCQueryBenchmark, Display, TEXT("%s() %s / %s improved %.1f%% (%.0f queries/s, baseline %.0f)."), ANSI_TO_TCHAR(__FUNCTION__), *Result.Scene, *Result.Query, ChangePercent, Result.QueriesPerSecond, *BaselineValue);
+		}
+
+		const double* BaselineAllocations = BaselineAllocationsPerQuery.Find(GetResultKey(Result.Scene, Result.Query));
+		if (BaselineAllocations && Result.AllocationsPerQuery > *BaselineAllocations + AllocationTolerance)
+		{
+			UE_LOG(LogGCQueryBenchmark, Warning, TEXT("%s() %s / %s allocates more (%.2f times per query, baseline %.2f)."), ANSI_TO_TCHAR(__FUNCTION__), *Result.Scene, *Result.Query, Result.AllocationsPerQuery, *BaselineAllocations);
+			++NumRegressions;
+		}
+	}
+
+	UE_LOG(LogGCQueryBenchmark, Display, TEXT("%s() %d regression(s) beyond %.1f%% against \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), NumRegressions, TolerancePercent, *BaselineFilename);
+	return (NumRegressions > 0 || NumScratchAllocationFailures > 0) ? 1 : 0;
+}
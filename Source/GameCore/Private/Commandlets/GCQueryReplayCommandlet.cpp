@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/GCQueryReplayCommandlet.h"
+
+#include "Utilities/GCQueryRecorder.h"
+#include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_CollisionQueries.h"
+#include "Engine/World.h"
+#include "UObject/Package.h"
+
+
+
+/** Gets the value at a percentile (0 to 100) of sorted values */
+static double GetPercentile(const TArray<double>& InSortedValues, const double InPercentile)
+{
+	if (InSortedValues.Num() <= 0)
+	{
+		return 0.0;
+	}
+
+	const int32 Index = FMath::Clamp(FMath::CeilToInt((InPercentile / 100.0) * InSortedValues.Num()) - 1, 0, InSortedValues.Num() - 1);
+	return InSortedValues[Index];
+}
+
+static void LogLatencies(const TCHAR* InName, TArray<double>& InOutMicroseconds)
+{
+	InOutMicroseconds.Sort();
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("    %s latency (us): p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f, max %.2f"), InName, GetPercentile(InOutMicroseconds, 50.0), GetPercentile(InOutMicroseconds, 90.0), GetPercentile(InOutMicroseconds, 99.0), GetPercentile(InOutMicroseconds, 99.9), GetPercentile(InOutMicroseconds, 100.0));
+}
+
+
+UGCQueryReplayCommandlet::UGCQueryReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UGCQueryReplayCommandlet::Main(const FString& Params)
+{
+	FString Filename;
+	if (!FParse::Value(*Params, TEXT("File="), Filename))
+	{
+		UE_LOG(LogGCQueryRecorder, Error, TEXT("%s() Give the recording with -File=<Recording.gcqr>."), ANSI_TO_TCHAR(__FUNCTION__));
+		return 1;
+	}
+
+	FString MapName;
+	TArray<FGCQueryRecord> Records;
+	if (!FGCQueryRecorder::LoadRecording(Filename, MapName, Records))
+	{
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("Map="), MapName);
+
+	int32 NumIterations = 1;
+	FParse::Value(*Params, TEXT("Iterations="), NumIterations);
+	NumIterations = FMath::Max(NumIterations, 1);
+	int32 MaxDiffsToLog = 10;
+	FParse::Value(*Params, TEXT("MaxDiffsToLog="), MaxDiffsToLog);
+	const bool bFailOnDiffs = FParse::Param(*Params, TEXT("FailOnDiffs"));
+
+
+	// Load the map with collision but without anything running in it
+	UPackage* MapPackage = LoadPackage(nullptr, *MapName, LOAD_None);
+	UWorld* World = (MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr);
+	if (!World)
+	{
+		UE_LOG(LogGCQueryRecorder, Error, TEXT("%s() Couldn't load map \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *MapName);
+		return 1;
+	}
+
+	World->AddToRoot();
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(true)
+			.SetTransactional(false));
+	}
+	World->UpdateWorldComponents(true, false);
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("%s() Replaying %d queries on \"%s\", %d time(s)."), ANSI_TO_TCHAR(__FUNCTION__), Records.Num(), *MapName, NumIterations);
+
+
+	// Replay
+	FExitHitsQueryScratch Scratch;
+	TArray<FExitAwareHitResult> Hits;
+	FCollisionQueryParams CollisionQueryParams;
+	FCollisionResponseParams CollisionResponseParams;
+	TArray<double> ReplayMicroseconds;
+	ReplayMicroseconds.Reserve(Records.Num() * NumIterations);
+	double TotalReplaySeconds = 0.0;
+	int32 NumDiffs = 0;
+
+	for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		for (int32 RecordIndex = 0; RecordIndex < Records.Num(); ++RecordIndex)
+		{
+			const FGCQueryRecord& Record = Records[RecordIndex];
+			Record.GetCollisionParams(CollisionQueryParams, CollisionResponseParams);
+			Scratch.SetCollisionParams(CollisionQueryParams, CollisionResponseParams);
+
+			// Give back what the game's callback gave back when recording
+			int32 NextImpenetrableOutcome = 0;
+			auto ReplayIsHitImpenetrable = [&Record, &NextImpenetrableOutcome](const FHitResult&) -> bool
+			{
+				const int32 OutcomeIndex = NextImpenetrableOutcome++;
+				return Record.ImpenetrableOutcomes.IsValidIndex(OutcomeIndex) && Record.ImpenetrableOutcomes[OutcomeIndex];
+			};
+
+			// Our queries append to their output
+			Hits.Reset();
+
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			bool bBlockingHit;
+			if (Record.Type == EGCQueryRecordType::PenetrationSceneCastWithExitHits)
+			{
+				bBlockingHit = (UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHits(Scratch, World, Hits, Record.Start, Record.End, Record.Rotation, Record.TraceChannel, Record.CollisionShape, ReplayIsHitImpenetrable, Record.bOptimizeBackwardsSceneCastLength, false, Record.ExitHitsMethod, Record.FurthestPossibleExitMethod, Record.ProgressiveChunkLength) != nullptr);
+			}
+			else
+			{
+				bBlockingHit = UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits(Scratch, World, Hits, Record.Start, Record.End, Record.Rotation, Record.TraceChannel, Record.CollisionShape, Record.bOptimizeBackwardsSceneCastLength, false, Record.ExitHitsMethod, Record.FurthestPossibleExitMethod);
+			}
+			const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+			TotalReplaySeconds += Seconds;
+			ReplayMicroseconds.Add(Seconds * 1000000.0);
+
+			// Compare with the recording once
+			if (Iteration > 0)
+			{
+				continue;
+			}
+
+			FGCQueryRecord Replayed;
+			Replayed.End = Record.End;
+			Replayed.SetResults(bBlockingHit, Hits);
+			if (!Record.HasSameResults(Replayed))
+			{
+				if (NumDiffs < MaxDiffsToLog)
+				{
+					UE_LOG(LogGCQueryRecorder, Warning, TEXT("%s() Query %d differs. Recorded: blocking %d, %d entrances, %d exits, furthest entrance %s. Replayed: blocking %d, %d entrances, %d exits, furthest entrance %s."), ANSI_TO_TCHAR(__FUNCTION__), RecordIndex,
+						Record.bBlockingHit, Record.NumEntranceHits, Record.NumExitHits, *Record.FurthestEntranceLocation.ToString(),
+						Replayed.bBlockingHit, Replayed.NumEntranceHits, Replayed.NumExitHits, *Replayed.FurthestEntranceLocation.ToString());
+				}
+				++NumDiffs;
+			}
+		}
+	}
+
+
+	// Report
+	TArray<double> RecordedMicroseconds;
+	RecordedMicroseconds.Reserve(Records.Num());
+	for (const FGCQueryRecord& Record : Records)
+	{
+		RecordedMicroseconds.Add(Record.Microseconds);
+	}
+
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("%s() Results:"), ANSI_TO_TCHAR(__FUNCTION__));
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("    Throughput: %.0f queries per second (%d queries in %.3f s)"), (TotalReplaySeconds > 0.0 ? ReplayMicroseconds.Num() / TotalReplaySeconds : 0.0), ReplayMicroseconds.Num(), TotalReplaySeconds);
+	LogLatencies(TEXT("Replayed"), ReplayMicroseconds);
+	LogLatencies(TEXT("Recorded"), RecordedMicroseconds);
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("    Diffs: %d of %d queries"), NumDiffs, Records.Num());
+
+	World->CleanupWorld();
+	World->RemoveFromRoot();
+
+	return (bFailOnDiffs && NumDiffs > 0) ? 1 : 0;
+}
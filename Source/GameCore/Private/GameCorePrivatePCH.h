@@ -4,3 +4,4 @@
 
 #include "EngineSharedPCH.h"
 #include "Utilities/GCLogCategories.h"
+#include "Utilities/GCStats.h"
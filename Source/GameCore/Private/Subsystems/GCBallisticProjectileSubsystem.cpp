@@ -0,0 +1,280 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/GCBallisticProjectileSubsystem.h"
+
+#include "DataAssets/GCBallisticsMaterialProfile.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+
+
+/**
+ * Policy for when there is no material profile. Doesn't nerf or ricochet, but still lets us use the ricocheting query.
+ */
+struct FGCBallisticProjectileNoProfilePolicy : public FGCNoPenetrationNerfPolicy, public FGCNoRicochetPolicy
+{
+};
+
+static FAutoConsoleCommandWithWorldAndArgs GCBallisticProjectilesBenchmarkCommand(
+	TEXT("GC.BallisticProjectiles.Benchmark"),
+	TEXT("Simulates ballistic projectiles in this world and logs how long it took. Args: [NumProjectiles=10000] [NumTicks=60]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&UGCBallisticProjectileSubsystem::RunBenchmark));
+
+
+int32 FGCBallisticProjectiles::Add(const FGCBallisticProjectileParams& InParams)
+{
+	const float SpeedSquared = InParams.Velocity.SizeSquared();
+
+	const int32 Id = NextId++;
+	Ids.Add(Id);
+	Locations.Add(InParams.Location);
+	Velocities.Add(InParams.Velocity);
+	StrengthPerSpeedSquared.Add(SpeedSquared > 0.f ? (InParams.Strength / SpeedSquared) : 0.f);
+	DragCoefficients.Add(InParams.DragCoefficient);
+	GravityScales.Add(InParams.GravityScale);
+	RemainingRicochets.Add(InParams.RicochetCap);
+	RemainingLifetimes.Add(InParams.Lifetime);
+	PerCmNerfStacks.Emplace(InParams.RangeFalloffNerf);
+
+	// The profile needs the hits' physical materials
+	FCollisionQueryParams CollisionQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(GCBallisticProjectile));
+	CollisionQueryParams.bReturnPhysicalMaterial = true;
+	if (InParams.IgnoredActor)
+	{
+		CollisionQueryParams.AddIgnoredActor(InParams.IgnoredActor);
+	}
+	Scratches.Emplace(CollisionQueryParams, FCollisionResponseParams::DefaultResponseParam);
+
+	TickResults.AddDefaulted();
+	Finished.Add(SpeedSquared <= 0.f || InParams.Strength <= 0.f);
+	return Id;
+}
+
+void FGCBallisticProjectiles::RemoveFinished()
+{
+	for (int32 i = Num() - 1; i >= 0; --i)
+	{
+		if (!Finished[i])
+		{
+			continue;
+		}
+
+		Ids.RemoveAtSwap(i, 1, false);
+		Locations.RemoveAtSwap(i, 1, false);
+		Velocities.RemoveAtSwap(i, 1, false);
+		StrengthPerSpeedSquared.RemoveAtSwap(i, 1, false);
+		DragCoefficients.RemoveAtSwap(i, 1, false);
+		GravityScales.RemoveAtSwap(i, 1, false);
+		RemainingRicochets.RemoveAtSwap(i, 1, false);
+		RemainingLifetimes.RemoveAtSwap(i, 1, false);
+		PerCmNerfStacks.RemoveAtSwap(i, 1, false);
+		Scratches.RemoveAtSwap(i, 1, false);
+		TickResults.RemoveAtSwap(i, 1, false);
+		Finished.RemoveAtSwap(i, 1, false);
+	}
+}
+
+void FGCBallisticProjectiles::Reset()
+{
+	Ids.Reset();
+	Locations.Reset();
+	Velocities.Reset();
+	StrengthPerSpeedSquared.Reset();
+	DragCoefficients.Reset();
+	GravityScales.Reset();
+	RemainingRicochets.Reset();
+	RemainingLifetimes.Reset();
+	PerCmNerfStacks.Reset();
+	Scratches.Reset();
+	TickResults.Reset();
+	Finished.Reset();
+}
+
+
+UGCBallisticProjectileSubsystem::UGCBallisticProjectileSubsystem()
+	: TraceChannel(ECollisionChannel::ECC_Visibility)
+	, ExitHitsMethod(EExitHitsMethod::BackwardsSceneCast)
+	, FurthestPossibleExitMethod(EFurthestPossibleExitMethod::BoundingSphere)
+	, ProgressiveChunkLength(0.f)
+	, bSimulateInParallel(true)
+{
+}
+
+void UGCBallisticProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Projectiles.Num() <= 0)
+	{
+		return;
+	}
+
+	SimulateProjectiles(Projectiles, DeltaTime);
+
+	if (OnProjectileHits.IsBound())
+	{
+		for (int32 i = 0; i < Projectiles.Num(); ++i)
+		{
+			if (Projectiles.TickResults[i].HitResults.Num() > 0)
+			{
+				OnProjectileHits.Broadcast(Projectiles.Ids[i], Projectiles.TickResults[i]);
+			}
+		}
+	}
+
+	Projectiles.RemoveFinished();
+}
+
+TStatId UGCBallisticProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGCBallisticProjectileSubsystem, STATGROUP_Tickables);
+}
+
+int32 UGCBallisticProjectileSubsystem::FireProjectile(const FGCBallisticProjectileParams& InParams)
+{
+	return Projectiles.Add(InParams);
+}
+
+void UGCBallisticProjectileSubsystem::DestroyAllProjectiles()
+{
+	Projectiles.Reset();
+}
+
+void UGCBallisticProjectileSubsystem::SetMaterialProfile(UGCBallisticsMaterialProfile* InMaterialProfile)
+{
+	MaterialProfile = InMaterialProfile;
+}
+
+void UGCBallisticProjectileSubsystem::SimulateProjectiles(FGCBallisticProjectiles& InOutProjectiles, const float InDeltaSeconds) const
+{
+	GC_QUERY_SCOPE(STAT_GCSimulateBallisticProjectiles);
+	INC_DWORD_STAT_BY(STAT_GCBallisticProjectilesSimulated, InOutProjectiles.Num());
+
+	if (InDeltaSeconds <= 0.f)
+	{
+		return;
+	}
+
+	if (MaterialProfile)
+	{
+		SimulateProjectilesInternal(InOutProjectiles, InDeltaSeconds, FGCBallisticsMaterialProfilePolicy(*MaterialProfile));
+	}
+	else
+	{
+		SimulateProjectilesInternal(InOutProjectiles, InDeltaSeconds, FGCBallisticProjectileNoProfilePolicy());
+	}
+}
+
+template <class TPolicy>
+void UGCBallisticProjectileSubsystem::SimulateProjectilesInternal(FGCBallisticProjectiles& InOutProjectiles, const float InDeltaSeconds, const TPolicy& InPolicy) const
+{
+	const UWorld* World = GetWorld();
+	const FVector Gravity = FVector(0.f, 0.f, World->GetGravityZ());
+	const ECollisionChannel Channel = TraceChannel;
+
+	// Every projectile only touches its own elements of the arrays so they can be simulated side by side
+	ParallelFor(InOutProjectiles.Num(), [&](int32 i)
+		{
+			if (InOutProjectiles.Finished[i])
+			{
+				InOutProjectiles.TickResults[i].Reset();
+				return;
+			}
+
+			InOutProjectiles.RemainingLifetimes[i] -= InDeltaSeconds;
+			if (InOutProjectiles.RemainingLifetimes[i] <= 0.f)
+			{
+				InOutProjectiles.TickResults[i].Reset();
+				InOutProjectiles.Finished[i] = true;
+				return;
+			}
+
+			// Integrate with semi-implicit euler
+			FVector& Velocity = InOutProjectiles.Velocities[i];
+			const FVector Drag = Velocity * (InOutProjectiles.DragCoefficients[i] * Velocity.Size());
+			Velocity += ((Gravity * InOutProjectiles.GravityScales[i]) - Drag) * InDeltaSeconds;
+
+			const FVector Start = InOutProjectiles.Locations[i];
+			const FVector Segment = Velocity * InDeltaSeconds;
+			const float SegmentLength = Segment.Size();
+			const float Strength = InOutProjectiles.StrengthPerSpeedSquared[i] * Velocity.SizeSquared();
+			if (SegmentLength <= KINDA_SMALL_NUMBER || Strength <= 0.f)
+			{
+				InOutProjectiles.TickResults[i].Reset();
+				InOutProjectiles.Finished[i] = true;
+				return;
+			}
+
+			// Scene cast the segment we traveled this tick. It starts where the last tick stopped, so it may start inside of the bodies on our nerf stack, whose exits the query then looks for.
+			FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& Result = InOutProjectiles.TickResults[i];
+			UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength(InOutProjectiles.Scratches[i], Strength, InOutProjectiles.PerCmNerfStacks[i], World, Result, Start, Segment / SegmentLength, SegmentLength, FQuat::Identity, Channel, FCollisionShape::LineShape, InOutProjectiles.RemainingRicochets[i], InPolicy, InPolicy, ExitHitsMethod, FurthestPossibleExitMethod, ProgressiveChunkLength);
+
+			const FStrengthSceneCastInfo& LastSceneCastInfo = Result.SceneCasts.Last().StrengthSceneCastInfo;
+			const TArrayView<const FStrengthHitResult> LastSceneCastHits = Result.GetSceneCastHits(Result.SceneCasts.Num() - 1);
+			const int32 NumRicochets = Result.SceneCasts.Num() - 1;
+
+			if (InOutProjectiles.RemainingRicochets[i] >= 0)
+			{
+				InOutProjectiles.RemainingRicochets[i] = FMath::Max(InOutProjectiles.RemainingRicochets[i] - NumRicochets, 0);
+			}
+
+			// Stop if we ran out of strength, or we were stopped by a ricochetable surface that we have no ricochets left for
+			const float StopStrength = Result.StrengthSceneCastInfo.StopStrength;
+			if (StopStrength <= 0.f || (LastSceneCastHits.Num() > 0 && LastSceneCastHits.Last().bIsRicochet))
+			{
+				InOutProjectiles.Locations[i] = Result.StrengthSceneCastInfo.StopLocation;
+				InOutProjectiles.Finished[i] = true;
+				return;
+			}
+
+			// Strength lost to geometry slows us down
+			InOutProjectiles.Locations[i] = Result.StrengthSceneCastInfo.StopLocation;
+			Velocity = LastSceneCastInfo.CastDirection * FMath::Sqrt(StopStrength / InOutProjectiles.StrengthPerSpeedSquared[i]);
+		},
+		(bSimulateInParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread));
+}
+
+void UGCBallisticProjectileSubsystem::RunBenchmark(const TArray<FString>& InArgs, UWorld* InWorld)
+{
+	const UGCBallisticProjectileSubsystem* Subsystem = InWorld ? InWorld->GetSubsystem<UGCBallisticProjectileSubsystem>() : nullptr;
+	if (!Subsystem)
+	{
+		UE_LOG(LogGCBallisticProjectiles, Error, TEXT("%s() No ballistic projectile subsystem in this world."), ANSI_TO_TCHAR(__FUNCTION__));
+		return;
+	}
+
+	const int32 NumProjectiles = InArgs.IsValidIndex(0) ? FCString::Atoi(*InArgs[0]) : 10000;
+	const int32 NumTicks = InArgs.IsValidIndex(1) ? FCString::Atoi(*InArgs[1]) : 60;
+	const float DeltaSeconds = 1.f / 60.f;
+
+	// Fire in every direction with a fixed seed so that runs are comparable
+	FRandomStream RandomStream = FRandomStream(0);
+	FGCBallisticProjectiles BenchmarkProjectiles;
+	for (int32 i = 0; i < NumProjectiles; ++i)
+	{
+		FGCBallisticProjectileParams Params;
+		Params.Velocity = RandomStream.GetUnitVector() * 90000.f;
+		Params.Strength = 1000.f;
+		Params.DragCoefficient = 0.00001f;
+		Params.RicochetCap = 2;
+		BenchmarkProjectiles.Add(Params);
+	}
+
+	double TotalSeconds = 0.0;
+	double MaxTickSeconds = 0.0;
+	int32 NumTicksSimulated = 0;
+	for (; NumTicksSimulated < NumTicks && BenchmarkProjectiles.Num() > 0; ++NumTicksSimulated)
+	{
+		const double StartSeconds = FPlatformTime::Seconds();
+		Subsystem->SimulateProjectiles(BenchmarkProjectiles, DeltaSeconds);
+		BenchmarkProjectiles.RemoveFinished();
+		const double TickSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+		TotalSeconds += TickSeconds;
+		MaxTickSeconds = FMath::Max(MaxTickSeconds, TickSeconds);
+	}
+
+	UE_LOG(LogGCBallisticProjectiles, Display, TEXT("%s() Simulated %d projectiles for %d ticks. Average tick: %.3f ms. Max tick: %.3f ms. Projectiles left: %d."), ANSI_TO_TCHAR(__FUNCTION__), NumProjectiles, NumTicksSimulated, (NumTicksSimulated > 0 ? (TotalSeconds / NumTicksSimulated) * 1000.0 : 0.0), MaxTickSeconds * 1000.0, BenchmarkProjectiles.Num());
+}
@@ -0,0 +1,448 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Types/GCNetStrengthHits.h"
+
+#include "Utilities/GCNetQuantization.h"
+#include "Engine/NetSerialization.h"
+#include "HAL/IConsoleManager.h"
+
+
+
+static FAutoConsoleCommand GCNetStrengthHitsBenchmarkCommand(
+	TEXT("GC.NetStrengthHits.Benchmark"),
+	TEXT("Logs the size and speed of FGCNetStrengthHits' net serialization compared to FHitResult's and FStrengthHitResult's. Args: [NumPaths=1000] [NumHitsPerPath=8] [NumIterations=20]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FGCNetStrengthHits::RunBenchmark));
+
+/**
+ * What the receiving end has of the previous hit. Offsets are taken from these (quantized) values so that they don't drift as they chain.
+ */
+struct FGCNetStrengthHitsContext
+{
+	FVector PreviousLocation;
+	FVector TraceStart;
+	FVector TraceEnd;
+	float TraveledDistanceBeforeThisTrace;
+	int32 RicochetNumber;
+};
+
+namespace EGCNetStrengthHitFlags
+{
+	enum Type : uint32
+	{
+		BlockingHit                 = 1 << 0,
+		StartPenetrating            = 1 << 1,
+		ExitHit                     = 1 << 2,
+		Ricochet                    = 1 << 3,
+		NewTrace                    = 1 << 4,
+		ImpactPointEqualsLocation   = 1 << 5,
+		ImpactNormalEqualsNormal    = 1 << 6,
+		HasFaceIndex                = 1 << 7,
+		HasBoneName                 = 1 << 8,
+
+		NumBits = 9
+	};
+}
+
+static void SerializeStrengthHit(FArchive& Ar, UPackageMap* Map, FStrengthHitResult& InOutHit, const FStrengthHitResult* InPreviousHit, FGCNetStrengthHitsContext& InOutContext, const float InStartStrength, const int32 InStrengthBits, const int32 InNormalBitsPerComponent, bool& bOutSuccess)
+{
+	uint32 Flags = 0;
+	if (Ar.IsSaving())
+	{
+		const bool bNewTrace = !InPreviousHit
+			|| InOutHit.TraceStart != InPreviousHit->TraceStart
+			|| InOutHit.TraceEnd != InPreviousHit->TraceEnd
+			|| InOutHit.TraveledDistanceBeforeThisTrace != InPreviousHit->TraveledDistanceBeforeThisTrace
+			|| InOutHit.RicochetNumber != InPreviousHit->RicochetNumber;
+
+		Flags |= InOutHit.bBlockingHit ? EGCNetStrengthHitFlags::BlockingHit : 0;
+		Flags |= InOutHit.bStartPenetrating ? EGCNetStrengthHitFlags::StartPenetrating : 0;
+		Flags |= InOutHit.bIsExitHit ? EGCNetStrengthHitFlags::ExitHit : 0;
+		Flags |= InOutHit.bIsRicochet ? EGCNetStrengthHitFlags::Ricochet : 0;
+		Flags |= bNewTrace ? EGCNetStrengthHitFlags::NewTrace : 0;
+		Flags |= (InOutHit.ImpactPoint == InOutHit.Location) ? EGCNetStrengthHitFlags::ImpactPointEqualsLocation : 0;
+		Flags |= (InOutHit.ImpactNormal == InOutHit.Normal) ? EGCNetStrengthHitFlags::ImpactNormalEqualsNormal : 0;
+		Flags |= (InOutHit.FaceIndex != INDEX_NONE) ? EGCNetStrengthHitFlags::HasFaceIndex : 0;
+		Flags |= (InOutHit.BoneName != NAME_None) ? EGCNetStrengthHitFlags::HasBoneName : 0;
+	}
+	Ar.SerializeBits(&Flags, EGCNetStrengthHitFlags::NumBits);
+
+	if (Ar.IsLoading())
+	{
+		InOutHit.bBlockingHit = (Flags & EGCNetStrengthHitFlags::BlockingHit) != 0;
+		InOutHit.bStartPenetrating = (Flags & EGCNetStrengthHitFlags::StartPenetrating) != 0;
+		InOutHit.bIsExitHit = (Flags & EGCNetStrengthHitFlags::ExitHit) != 0;
+		InOutHit.bIsRicochet = (Flags & EGCNetStrengthHitFlags::Ricochet) != 0;
+	}
+
+	// The trace (shared by every hit of a scene cast)
+	if (Flags & EGCNetStrengthHitFlags::NewTrace)
+	{
+		bOutSuccess &= FGCNetQuantization::SerializeRelativeLocation(Ar, InOutHit.TraceStart, InOutContext.PreviousLocation);
+		InOutContext.TraceStart = Ar.IsSaving() ? FGCNetQuantization::QuantizeRelativeLocation(InOutHit.TraceStart, InOutContext.PreviousLocation) : InOutHit.TraceStart;
+
+		bOutSuccess &= FGCNetQuantization::SerializeRelativeLocation(Ar, InOutHit.TraceEnd, InOutContext.TraceStart);
+		InOutContext.TraceEnd = Ar.IsSaving() ? FGCNetQuantization::QuantizeRelativeLocation(InOutHit.TraceEnd, InOutContext.TraceStart) : InOutHit.TraceEnd;
+
+		uint32 TraveledDistanceBeforeThisTrace = FMath::RoundToInt(FMath::Max(InOutHit.TraveledDistanceBeforeThisTrace, 0.f) * 10.f); // in tenths of a cm
+		Ar.SerializeIntPacked(TraveledDistanceBeforeThisTrace);
+		InOutContext.TraveledDistanceBeforeThisTrace = TraveledDistanceBeforeThisTrace / 10.f;
+
+		uint32 RicochetNumber = FMath::Max(InOutHit.RicochetNumber, 0);
+		Ar.SerializeIntPacked(RicochetNumber);
+		InOutContext.RicochetNumber = RicochetNumber;
+	}
+	if (Ar.IsLoading())
+	{
+		InOutHit.TraceStart = InOutContext.TraceStart;
+		InOutHit.TraceEnd = InOutContext.TraceEnd;
+		InOutHit.TraveledDistanceBeforeThisTrace = InOutContext.TraveledDistanceBeforeThisTrace;
+		InOutHit.RicochetNumber = InOutContext.RicochetNumber;
+	}
+
+	// Locations
+	bOutSuccess &= FGCNetQuantization::SerializeRelativeLocation(Ar, InOutHit.Location, InOutContext.PreviousLocation);
+	const FVector ReceivedLocation = Ar.IsSaving() ? FGCNetQuantization::QuantizeRelativeLocation(InOutHit.Location, InOutContext.PreviousLocation) : InOutHit.Location;
+	if (Flags & EGCNetStrengthHitFlags::ImpactPointEqualsLocation)
+	{
+		if (Ar.IsLoading())
+		{
+			InOutHit.ImpactPoint = InOutHit.Location;
+		}
+	}
+	else
+	{
+		bOutSuccess &= FGCNetQuantization::SerializeRelativeLocation(Ar, InOutHit.ImpactPoint, ReceivedLocation);
+	}
+	InOutContext.PreviousLocation = ReceivedLocation;
+
+	// Normals
+	FGCNetQuantization::SerializeOctahedralNormal(Ar, InOutHit.Normal, InNormalBitsPerComponent);
+	if (Flags & EGCNetStrengthHitFlags::ImpactNormalEqualsNormal)
+	{
+		if (Ar.IsLoading())
+		{
+			InOutHit.ImpactNormal = InOutHit.Normal;
+		}
+	}
+	else
+	{
+		FGCNetQuantization::SerializeOctahedralNormal(Ar, InOutHit.ImpactNormal, InNormalBitsPerComponent);
+	}
+
+	// Strength, as a fraction of the start strength since it only goes down from there
+	float StrengthFraction = (InStartStrength > 0.f) ? (InOutHit.Strength / InStartStrength) : 0.f;
+	FGCNetQuantization::SerializeQuantizedUnitFloat(Ar, StrengthFraction, InStrengthBits);
+
+	// What we hit
+	Ar << InOutHit.PhysMaterial;
+	Ar << InOutHit.HitObjectHandle;
+	Ar << InOutHit.Component;
+	if (Flags & EGCNetStrengthHitFlags::HasBoneName)
+	{
+		Ar << InOutHit.BoneName;
+	}
+	if (Flags & EGCNetStrengthHitFlags::HasFaceIndex)
+	{
+		uint32 FaceIndex = FMath::Max(InOutHit.FaceIndex, 0);
+		Ar.SerializeIntPacked(FaceIndex);
+		InOutHit.FaceIndex = FaceIndex;
+	}
+
+	if (Ar.IsLoading())
+	{
+		InOutHit.Strength = StrengthFraction * InStartStrength;
+		if (!(Flags & EGCNetStrengthHitFlags::HasBoneName))
+		{
+			InOutHit.BoneName = NAME_None;
+		}
+		if (!(Flags & EGCNetStrengthHitFlags::HasFaceIndex))
+		{
+			InOutHit.FaceIndex = INDEX_NONE;
+		}
+
+		// Rebuild what we didn't send, the same way the queries make them (distance along the forwards direction, even for exit hits)
+		const FVector TraceVector = InOutHit.TraceEnd - InOutHit.TraceStart;
+		const float TraceLength = TraceVector.Size();
+		InOutHit.Distance = (TraceLength > 0.f ? FVector::DotProduct(TraceVector / TraceLength, (InOutHit.Location - InOutHit.TraceStart)) : 0.f);
+		InOutHit.Time = (TraceLength > 0.f ? (InOutHit.Distance / TraceLength) : 0.f);
+	}
+}
+
+
+void FGCNetStrengthHits::SetFromResult(const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult)
+{
+	StartLocation = InResult.StrengthSceneCastInfo.StartLocation;
+	StartStrength = InResult.StrengthSceneCastInfo.StartStrength;
+	Hits = InResult.HitResults;
+}
+
+bool FGCNetStrengthHits::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	bOutSuccess &= SerializePackedVector<10, 24>(StartLocation, Ar);
+	Ar << StartStrength;
+
+	// Our settings go first so that the receiving end can read the hits with them
+	uint32 StrengthBitsToUse = FMath::Clamp<uint32>(StrengthBits, 1, 24);
+	uint32 NormalBitsPerComponentToUse = FMath::Clamp<uint32>(NormalBitsPerComponent, 1, 16);
+	Ar.SerializeBits(&StrengthBitsToUse, 5);
+	Ar.SerializeBits(&NormalBitsPerComponentToUse, 5);
+	if (Ar.IsLoading())
+	{
+		StrengthBits = FMath::Clamp<uint32>(StrengthBitsToUse, 1, 24);
+		NormalBitsPerComponent = FMath::Clamp<uint32>(NormalBitsPerComponentToUse, 1, 16);
+	}
+
+	uint32 NumHits = Hits.Num();
+	Ar.SerializeIntPacked(NumHits);
+	if (Ar.IsLoading())
+	{
+		if (NumHits > MaxNumHits)
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return true;
+		}
+
+		Hits.Reset(NumHits);
+		Hits.AddDefaulted(NumHits);
+	}
+
+	FGCNetStrengthHitsContext Context;
+	Context.PreviousLocation = Ar.IsSaving() ? FGCNetQuantization::QuantizeRelativeLocation(StartLocation, FVector::ZeroVector) : StartLocation;
+	Context.TraceStart = Context.PreviousLocation;
+	Context.TraceEnd = Context.PreviousLocation;
+	Context.TraveledDistanceBeforeThisTrace = 0.f;
+	Context.RicochetNumber = 0;
+
+	for (int32 i = 0; i < Hits.Num(); ++i)
+	{
+		const FStrengthHitResult* PreviousHit = (i > 0) ? &Hits[i - 1] : nullptr;
+		SerializeStrengthHit(Ar, Map, Hits[i], PreviousHit, Context, StartStrength, StrengthBits, NormalBitsPerComponent, bOutSuccess);
+	}
+
+	return true;
+}
+
+void FGCNetStrengthHits::RunBenchmark(const TArray<FString>& InArgs)
+{
+	const int32 NumPaths = InArgs.IsValidIndex(0) ? FCString::Atoi(*InArgs[0]) : 1000;
+	const int32 NumHitsPerPath = InArgs.IsValidIndex(1) ? FMath::Clamp(FCString::Atoi(*InArgs[1]), 1, MaxNumHits) : 8;
+	const int32 NumIterations = InArgs.IsValidIndex(2) ? FMath::Max(FCString::Atoi(*InArgs[2]), 1) : 20;
+	if (NumPaths <= 0)
+	{
+		return;
+	}
+
+	// Make paths that look like a ricocheting query's, with a fixed seed so that runs are comparable
+	FRandomStream RandomStream = FRandomStream(0);
+	TArray<FGCNetStrengthHits> Paths;
+	Paths.SetNum(NumPaths);
+	for (FGCNetStrengthHits& Path : Paths)
+	{
+		Path.StartLocation = RandomStream.GetUnitVector() * RandomStream.FRandRange(0.f, 100000.f);
+		Path.StartStrength = 1000.f;
+
+		FVector TraceStart = Path.StartLocation;
+		FVector Direction = RandomStream.GetUnitVector();
+		float TraveledDistanceBeforeThisTrace = 0.f;
+		float DistanceOnTrace = 0.f;
+		int32 RicochetNumber = 0;
+		for (int32 i = 0; i < NumHitsPerPath; ++i)
+		{
+			DistanceOnTrace += RandomStream.FRandRange(10.f, 500.f);
+
+			FStrengthHitResult& Hit = Path.Hits.AddDefaulted_GetRef();
+			Hit.bBlockingHit = true;
+			Hit.bIsExitHit = (i % 2) == 1;
+			Hit.TraceStart = TraceStart;
+			Hit.TraceEnd = TraceStart + (Direction * 100000.f);
+			Hit.Location = TraceStart + (Direction * DistanceOnTrace);
+			Hit.ImpactPoint = Hit.Location;
+			Hit.Normal = RandomStream.GetUnitVector();
+			Hit.ImpactNormal = Hit.Normal;
+			Hit.Distance = DistanceOnTrace;
+			Hit.Time = DistanceOnTrace / 100000.f;
+			Hit.FaceIndex = RandomStream.RandRange(0, 5000);
+			Hit.TraveledDistanceBeforeThisTrace = TraveledDistanceBeforeThisTrace;
+			Hit.RicochetNumber = RicochetNumber;
+			Hit.Strength = Path.StartStrength * (1.f - ((i + 1.f) / (NumHitsPerPath + 1.f)));
+
+			// Sometimes ricochet off of entrances
+			if (!Hit.bIsExitHit && RandomStream.FRand() < .2f)
+			{
+				Hit.bIsRicochet = true;
+				TraveledDistanceBeforeThisTrace += DistanceOnTrace;
+				DistanceOnTrace = 0.f;
+				TraceStart = Hit.Location;
+				Direction = FMath::GetReflectionVector(Direction, Hit.Normal);
+				++RicochetNumber;
+			}
+		}
+	}
+
+	const int32 NumHits = NumPaths * NumHitsPerPath;
+	auto LogResult = [NumHits, NumIterations](const TCHAR* InName, const int64 InNumBits, const double InWriteSeconds, const double InReadSeconds)
+	{
+		const double NumMegabytes = (InNumBits / 8.0) / (1024.0 * 1024.0);
+		UE_LOG(LogGCNetSerialization, Display, TEXT("    %s: %.1f bits per hit. Write: %.1f MB/s. Read: %.1f MB/s."), InName, static_cast<double>(InNumBits) / NumHits, (NumMegabytes * NumIterations) / FMath::Max(InWriteSeconds, 1e-9), (NumMegabytes * NumIterations) / FMath::Max(InReadSeconds, 1e-9));
+	};
+
+	UE_LOG(LogGCNetSerialization, Display, TEXT("%s() %d paths of %d hits, %d iterations (object references aren't counted since there is no package map):"), ANSI_TO_TCHAR(__FUNCTION__), NumPaths, NumHitsPerPath, NumIterations);
+
+	// Round trip the normals that random ones are unlikely to land on: the axes (floors, ceilings, and walls) and the diagonals within the axis planes, which lie on the octahedral encoding's folds
+	{
+		TArray<FVector> EdgeCaseNormals;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			for (const float Sign : { 1.f, -1.f })
+			{
+				FVector AxisNormal = FVector::ZeroVector;
+				AxisNormal[Axis] = Sign;
+				EdgeCaseNormals.Add(AxisNormal);
+
+				for (const float OtherSign : { 1.f, -1.f })
+				{
+					FVector PlaneNormal = AxisNormal;
+					PlaneNormal[(Axis + 1) % 3] = OtherSign;
+					EdgeCaseNormals.Add(PlaneNormal.GetSafeNormal());
+				}
+			}
+		}
+
+		const int32 NormalBitsPerComponent = FGCNetStrengthHits().NormalBitsPerComponent;
+		const float MaxAllowedError = 1.f; // degrees. Way more than quantization loses, and way less than a flipped or collapsed normal.
+		float MaxEdgeCaseError = 0.f;
+		for (const FVector& Normal : EdgeCaseNormals)
+		{
+			FBitWriter Writer(0, true);
+			FVector WrittenNormal = Normal;
+			FGCNetQuantization::SerializeOctahedralNormal(Writer, WrittenNormal, NormalBitsPerComponent);
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			FVector ReadNormal = FVector::ZeroVector;
+			FGCNetQuantization::SerializeOctahedralNormal(Reader, ReadNormal, NormalBitsPerComponent);
+
+			const float Error = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(static_cast<float>(FVector::DotProduct(Normal, ReadNormal)), -1.f, 1.f)));
+			MaxEdgeCaseError = FMath::Max(MaxEdgeCaseError, Error);
+			if (Error > MaxAllowedError)
+			{
+				UE_LOG(LogGCNetSerialization, Error, TEXT("%s() Normal %s came back as %s (%.2f degrees off)."), ANSI_TO_TCHAR(__FUNCTION__), *Normal.ToString(), *ReadNormal.ToString(), Error);
+			}
+		}
+		UE_LOG(LogGCNetSerialization, Display, TEXT("    Axis and axis plane normals: %.3f degrees max error over %d normals."), MaxEdgeCaseError, EdgeCaseNormals.Num());
+	}
+
+	// FHitResult, the engine's
+	{
+		FBitWriter Writer(0, true);
+		double WriteSeconds = 0.0;
+		double ReadSeconds = 0.0;
+		FHitResult ReadHit;
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Writer.Reset();
+			double StartSeconds = FPlatformTime::Seconds();
+			for (FGCNetStrengthHits& Path : Paths)
+			{
+				for (FStrengthHitResult& Hit : Path.Hits)
+				{
+					bool bSuccess = true;
+					static_cast<FHitResult&>(Hit).NetSerialize(Writer, nullptr, bSuccess);
+				}
+			}
+			WriteSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			StartSeconds = FPlatformTime::Seconds();
+			for (int32 i = 0; i < NumHits; ++i)
+			{
+				bool bSuccess = true;
+				ReadHit.NetSerialize(Reader, nullptr, bSuccess);
+			}
+			ReadSeconds += FPlatformTime::Seconds() - StartSeconds;
+		}
+		LogResult(TEXT("FHitResult"), Writer.GetNumBits(), WriteSeconds, ReadSeconds);
+	}
+
+	// FStrengthHitResult, each hit on its own
+	{
+		FBitWriter Writer(0, true);
+		double WriteSeconds = 0.0;
+		double ReadSeconds = 0.0;
+		FStrengthHitResult ReadHit;
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Writer.Reset();
+			double StartSeconds = FPlatformTime::Seconds();
+			for (FGCNetStrengthHits& Path : Paths)
+			{
+				for (FStrengthHitResult& Hit : Path.Hits)
+				{
+					bool bSuccess = true;
+					Hit.NetSerialize(Writer, nullptr, bSuccess);
+				}
+			}
+			WriteSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			StartSeconds = FPlatformTime::Seconds();
+			for (int32 i = 0; i < NumHits; ++i)
+			{
+				bool bSuccess = true;
+				ReadHit.NetSerialize(Reader, nullptr, bSuccess);
+			}
+			ReadSeconds += FPlatformTime::Seconds() - StartSeconds;
+		}
+		LogResult(TEXT("FStrengthHitResult"), Writer.GetNumBits(), WriteSeconds, ReadSeconds);
+	}
+
+	// FGCNetStrengthHits, a path at a time
+	{
+		FBitWriter Writer(0, true);
+		double WriteSeconds = 0.0;
+		double ReadSeconds = 0.0;
+		TArray<FGCNetStrengthHits> ReadPaths;
+		ReadPaths.SetNum(NumPaths);
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			Writer.Reset();
+			double StartSeconds = FPlatformTime::Seconds();
+			for (FGCNetStrengthHits& Path : Paths)
+			{
+				bool bSuccess = true;
+				Path.NetSerialize(Writer, nullptr, bSuccess);
+			}
+			WriteSeconds += FPlatformTime::Seconds() - StartSeconds;
+
+			FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+			StartSeconds = FPlatformTime::Seconds();
+			for (FGCNetStrengthHits& ReadPath : ReadPaths)
+			{
+				bool bSuccess = true;
+				ReadPath.NetSerialize(Reader, nullptr, bSuccess);
+			}
+			ReadSeconds += FPlatformTime::Seconds() - StartSeconds;
+		}
+		LogResult(TEXT("FGCNetStrengthHits"), Writer.GetNumBits(), WriteSeconds, ReadSeconds);
+
+		// How much we lost to quantization
+		float MaxLocationError = 0.f;
+		float MaxNormalError = 0.f;
+		float MaxStrengthError = 0.f;
+		for (int32 PathIndex = 0; PathIndex < NumPaths; ++PathIndex)
+		{
+			for (int32 i = 0; i < NumHitsPerPath; ++i)
+			{
+				const FStrengthHitResult& Hit = Paths[PathIndex].Hits[i];
+				const FStrengthHitResult& ReadHit = ReadPaths[PathIndex].Hits[i];
+				MaxLocationError = FMath::Max(MaxLocationError, static_cast<float>(FVector::Distance(Hit.Location, ReadHit.Location)));
+				MaxNormalError = FMath::Max(MaxNormalError, FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(static_cast<float>(FVector::DotProduct(Hit.Normal, ReadHit.Normal)), -1.f, 1.f))));
+				MaxStrengthError = FMath::Max(MaxStrengthError, FMath::Abs(Hit.Strength - ReadHit.Strength));
+			}
+		}
+		UE_LOG(LogGCNetSerialization, Display, TEXT("    FGCNetStrengthHits error: %.3f cm max location error. %.3f degrees max normal error. %.3f max strength error."), MaxLocationError, MaxNormalError, MaxStrengthError);
+	}
+}
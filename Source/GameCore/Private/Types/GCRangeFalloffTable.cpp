@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Types/GCRangeFalloffTable.h"
+
+#include "Curves/RichCurve.h"
+
+
+
+FGCRangeFalloffTable::FGCRangeFalloffTable()
+	: SampleSpacing(0.f)
+	, InvSampleSpacing(0.f)
+	, PerCmNerfPastEnd(0.f)
+{
+}
+
+void FGCRangeFalloffTable::Build(const TFunctionRef<float(float)>& InGetPerCmNerfAtDistance, const float InMaxDistance, const int32 InNumSamples)
+{
+	Integral.Reset();
+	if (InMaxDistance <= 0.f || InNumSamples < 2)
+	{
+		SampleSpacing = 0.f;
+		InvSampleSpacing = 0.f;
+		PerCmNerfPastEnd = 0.f;
+		return;
+	}
+
+	SampleSpacing = InMaxDistance / (InNumSamples - 1);
+	InvSampleSpacing = 1.f / SampleSpacing;
+
+	// Integrate each table cell with Simpson's rule
+	Integral.Reserve(InNumSamples);
+	Integral.Add(0.f);
+	float PreviousNerf = FMath::Max(InGetPerCmNerfAtDistance(0.f), 0.f);
+	for (int32 i = 1; i < InNumSamples; ++i)
+	{
+		const float CellStart = (i - 1) * SampleSpacing;
+		const float MidNerf = FMath::Max(InGetPerCmNerfAtDistance(CellStart + (SampleSpacing * .5f)), 0.f);
+		const float EndNerf = FMath::Max(InGetPerCmNerfAtDistance(CellStart + SampleSpacing), 0.f);
+
+		Integral.Add(Integral.Last() + ((SampleSpacing / 6.f) * (PreviousNerf + (4.f * MidNerf) + EndNerf)));
+		PreviousNerf = EndNerf;
+	}
+
+	PerCmNerfPastEnd = PreviousNerf;
+}
+
+void FGCRangeFalloffTable::BuildFromCurve(const FRichCurve& InPerCmNerfCurve, const float InMaxDistance, const int32 InNumSamples)
+{
+	Build([&InPerCmNerfCurve](float InDistance) { return InPerCmNerfCurve.Eval(InDistance); }, InMaxDistance, InNumSamples);
+}
+
+float FGCRangeFalloffTable::GetIntegral(const float InDistance) const
+{
+	if (IsEmpty() || InDistance <= 0.f)
+	{
+		return 0.f;
+	}
+
+	const float Sample = InDistance * InvSampleSpacing;
+	const int32 Index = FMath::FloorToInt(Sample);
+	if (Index >= Integral.Num() - 1)
+	{
+		// Past the end of the table
+		const float TableDistance = (Integral.Num() - 1) * SampleSpacing;
+		return Integral.Last() + ((InDistance - TableDistance) * PerCmNerfPastEnd);
+	}
+
+	return FMath::Lerp(Integral[Index], Integral[Index + 1], Sample - Index);
+}
+
+float FGCRangeFalloffTable::GetTravelDistance(const float InStartDistance, const float InStrength, const float InConstantPerCmNerf, const float InMaxTravelDistance) const
+{
+	const float StartIntegral = GetIntegral(InStartDistance);
+	const float EndDistance = InStartDistance + InMaxTravelDistance;
+
+	// Strength lost traveling from InStartDistance to a distance. Only ever goes up, and is linear between table entries.
+	auto GetStrengthLostAt = [&](const float InDistance) -> float
+	{
+		return (InConstantPerCmNerf * (InDistance - InStartDistance)) + (GetIntegral(InDistance) - StartIntegral);
+	};
+
+	if (GetStrengthLostAt(EndDistance) <= InStrength)
+	{
+		return InMaxTravelDistance; // we make it all the way
+	}
+	if (IsEmpty())
+	{
+		return (InConstantPerCmNerf > 0.f) ? (InStrength / InConstantPerCmNerf) : InMaxTravelDistance;
+	}
+
+	// Find the first table entry within our travel where we are out of strength
+	const int32 FirstIndex = FMath::CeilToInt(InStartDistance * InvSampleSpacing);
+	const int32 LastIndex = FMath::Min(FMath::FloorToInt(EndDistance * InvSampleSpacing), Integral.Num() - 1);
+	int32 StopIndex = INDEX_NONE;
+	for (int32 Low = FirstIndex, High = LastIndex; Low <= High; )
+	{
+		const int32 Middle = (Low + High) / 2;
+		if (GetStrengthLostAt(Middle * SampleSpacing) >= InStrength)
+		{
+			StopIndex = Middle;
+			High = Middle - 1;
+		}
+		else
+		{
+			Low = Middle + 1;
+		}
+	}
+
+	// Get the linear piece that we run out of strength in
+	float PieceStart;
+	float PieceEnd;
+	if (StopIndex != INDEX_NONE)
+	{
+		PieceStart = FMath::Max(InStartDistance, (StopIndex - 1) * SampleSpacing);
+		PieceEnd = StopIndex * SampleSpacing;
+	}
+	else
+	{
+		PieceStart = (LastIndex >= FirstIndex) ? (LastIndex * SampleSpacing) : InStartDistance;
+		PieceEnd = EndDistance;
+	}
+
+	// Solve for where we run out
+	const float StrengthLostAtPieceStart = GetStrengthLostAt(PieceStart);
+	const float StrengthLostAtPieceEnd = GetStrengthLostAt(PieceEnd);
+	const float Alpha = (StrengthLostAtPieceEnd > StrengthLostAtPieceStart) ? ((InStrength - StrengthLostAtPieceStart) / (StrengthLostAtPieceEnd - StrengthLostAtPieceStart)) : 0.f;
+	return FMath::Lerp(PieceStart, PieceEnd, Alpha) - InStartDistance;
+}
@@ -12,3 +12,9 @@ DEFINE_LOG_CATEGORY(LogGCCollisionQueries)
 DEFINE_LOG_CATEGORY(LogGCHitResultHelpers)
 DEFINE_LOG_CATEGORY(LogGCStrengthCollisionQueries)
 DEFINE_LOG_CATEGORY(LogGCPropertyWrapper)
+DEFINE_LOG_CATEGORY(LogGCBallisticProjectiles)
+DEFINE_LOG_CATEGORY(LogGCNetSerialization)
+DEFINE_LOG_CATEGORY(LogGCQueryRecorder)
+DEFINE_LOG_CATEGORY(LogGCQueryBenchmark)
+DEFINE_LOG_CATEGORY(LogGCQueryVisualizer)
+DEFINE_LOG_CATEGORY(LogGCQueryHeatmap)
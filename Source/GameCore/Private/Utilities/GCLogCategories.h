@@ -13,3 +13,9 @@ DECLARE_LOG_CATEGORY_EXTERN(LogGCCollisionQueries, Log, All)
 DECLARE_LOG_CATEGORY_EXTERN(LogGCHitResultHelpers, Log, All)
 DECLARE_LOG_CATEGORY_EXTERN(LogGCStrengthCollisionQueries, Log, All)
 DECLARE_LOG_CATEGORY_EXTERN(LogGCPropertyWrapper, Log, All)
+DECLARE_LOG_CATEGORY_EXTERN(LogGCBallisticProjectiles, Log, All)
+DECLARE_LOG_CATEGORY_EXTERN(LogGCNetSerialization, Log, All)
+DECLARE_LOG_CATEGORY_EXTERN(LogGCQueryRecorder, Log, All)
+DECLARE_LOG_CATEGORY_EXTERN(LogGCQueryBenchmark, Log, All)
+DECLARE_LOG_CATEGORY_EXTERN(LogGCQueryVisualizer, Log, All)
+DECLARE_LOG_CATEGORY_EXTERN(LogGCQueryHeatmap, Log, All)
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/GCNetQuantization.h"
+
+#include "Engine/NetSerialization.h"
+
+
+
+/** Octahedral encoding needs a sign that is never zero, otherwise normals on the fold (e.g. straight down) are flipped or collapse onto an axis */
+static float SignNotZero(const float InValue)
+{
+	return (InValue >= 0.f) ? 1.f : -1.f;
+}
+
+
+void FGCNetQuantization::SerializeOctahedralNormal(FArchive& InOutArchive, FVector& InOutNormal, const int32 InBitsPerComponent)
+{
+	const uint32 MaxQuantized = (1u << InBitsPerComponent) - 1;
+
+	uint8 bIsZero = InOutArchive.IsSaving() ? InOutNormal.IsNearlyZero() : 0;
+	InOutArchive.SerializeBits(&bIsZero, 1);
+	if (bIsZero)
+	{
+		if (InOutArchive.IsLoading())
+		{
+			InOutNormal = FVector::ZeroVector;
+		}
+		return;
+	}
+
+	uint32 QuantizedX = 0;
+	uint32 QuantizedY = 0;
+	if (InOutArchive.IsSaving())
+	{
+		// Project onto the octahedron and fold its bottom half over the top half
+		const FVector Normal = InOutNormal / (FMath::Abs(InOutNormal.X) + FMath::Abs(InOutNormal.Y) + FMath::Abs(InOutNormal.Z));
+		FVector2D Encoded = FVector2D(Normal.X, Normal.Y);
+		if (Normal.Z < 0)
+		{
+			Encoded = FVector2D((1 - FMath::Abs(Normal.Y)) * SignNotZero(Normal.X), (1 - FMath::Abs(Normal.X)) * SignNotZero(Normal.Y));
+		}
+
+		QuantizedX = FMath::Clamp<uint32>(FMath::RoundToInt(((Encoded.X * .5f) + .5f) * MaxQuantized), 0, MaxQuantized);
+		QuantizedY = FMath::Clamp<uint32>(FMath::RoundToInt(((Encoded.Y * .5f) + .5f) * MaxQuantized), 0, MaxQuantized);
+	}
+
+	InOutArchive.SerializeBits(&QuantizedX, InBitsPerComponent);
+	InOutArchive.SerializeBits(&QuantizedY, InBitsPerComponent);
+
+	if (InOutArchive.IsLoading())
+	{
+		const float X = ((static_cast<float>(QuantizedX) / MaxQuantized) * 2.f) - 1.f;
+		const float Y = ((static_cast<float>(QuantizedY) / MaxQuantized) * 2.f) - 1.f;
+		const float Z = 1.f - FMath::Abs(X) - FMath::Abs(Y);
+
+		// Unfold the bottom half
+		FVector Normal = FVector(X, Y, Z);
+		if (Z < 0)
+		{
+			Normal.X = (1 - FMath::Abs(Y)) * SignNotZero(X);
+			Normal.Y = (1 - FMath::Abs(X)) * SignNotZero(Y);
+		}
+
+		InOutNormal = Normal.GetSafeNormal();
+	}
+}
+
+void FGCNetQuantization::SerializeQuantizedUnitFloat(FArchive& InOutArchive, float& InOutValue, const int32 InNumBits)
+{
+	const uint32 MaxQuantized = (1u << InNumBits) - 1;
+
+	uint32 Quantized = 0;
+	if (InOutArchive.IsSaving())
+	{
+		Quantized = FMath::RoundToInt(FMath::Clamp(InOutValue, 0.f, 1.f) * MaxQuantized);
+	}
+
+	InOutArchive.SerializeBits(&Quantized, InNumBits);
+
+	if (InOutArchive.IsLoading())
+	{
+		InOutValue = static_cast<float>(Quantized) / MaxQuantized;
+	}
+}
+
+bool FGCNetQuantization::SerializeRelativeLocation(FArchive& InOutArchive, FVector& InOutLocation, const FVector& InOrigin)
+{
+	FVector Offset = InOutArchive.IsSaving() ? (InOutLocation - InOrigin) : FVector::ZeroVector;
+	const bool bSuccess = SerializePackedVector<10, 30>(Offset, InOutArchive);
+
+	if (InOutArchive.IsLoading())
+	{
+		InOutLocation = InOrigin + Offset;
+	}
+	return bSuccess;
+}
+
+FVector FGCNetQuantization::QuantizeRelativeLocation(const FVector& InLocation, const FVector& InOrigin)
+{
+	const FVector Offset = InLocation - InOrigin;
+	return InOrigin + (FVector(FMath::RoundToFloat(Offset.X * 10.f), FMath::RoundToFloat(Offset.Y * 10.f), FMath::RoundToFloat(Offset.Z * 10.f)) / 10.f);
+}
@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/GCQueryHeatmap.h"
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "ImageUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+
+
+TAtomic<bool> FGCQueryHeatmap::bRecording(false);
+FCriticalSection FGCQueryHeatmap::CriticalSection;
+TArray<TSharedPtr<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe>> FGCQueryHeatmap::ThreadCells;
+float FGCQueryHeatmap::CellSize = 500.f;
+FString FGCQueryHeatmap::MapName;
+FDelegateHandle FGCQueryHeatmap::OnWorldCleanupHandle;
+
+/** Not a member since thread_local can't be exported from the module */
+static thread_local uint32 GNumSceneCastsOnThisThread = 0;
+static thread_local TSharedPtr<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe> GThreadCells;
+
+static FAutoConsoleCommandWithWorldAndArgs GCQueryHeatmapStartCommand(
+	TEXT("GC.QueryHeatmap.Start"),
+	TEXT("Starts summing the cost of GameCore's queries into a world space grid for this map. Args: [CellSize=500]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld)
+		{
+			float NewCellSize = 500.f;
+			FParse::Value(*FString::Join(InArgs, TEXT(" ")), TEXT("CellSize="), NewCellSize);
+			FGCQueryHeatmap::StartRecording(InWorld, NewCellSize);
+		}));
+
+static FAutoConsoleCommand GCQueryHeatmapStopCommand(
+	TEXT("GC.QueryHeatmap.Stop"),
+	TEXT("Stops summing the cost of GameCore's queries. The grid is kept for GC.QueryHeatmap.Export."),
+	FConsoleCommandDelegate::CreateStatic(&FGCQueryHeatmap::StopRecording));
+
+static FAutoConsoleCommandWithArgs GCQueryHeatmapExportCommand(
+	TEXT("GC.QueryHeatmap.Export"),
+	TEXT("Writes the query cost grid as a CSV and a top down PNG. Args: [Filename=Saved/Profiling/GCQueryHeatmaps/<Map>_<date> (without extension)]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& InArgs)
+		{
+			FGCQueryHeatmap::Export(InArgs.IsValidIndex(0) ? InArgs[0] : FString());
+		}));
+
+
+FGCQueryHeatmapSample::FGCQueryHeatmapSample()
+	: Start(FVector::ZeroVector)
+	, End(FVector::ZeroVector)
+	, Seconds(0.0)
+	, NumSceneCasts(0)
+{
+}
+
+FGCQueryHeatmapCell::FGCQueryHeatmapCell()
+	: NumQueries(0)
+	, Seconds(0.0)
+	, NumSceneCasts(0.0)
+	, BackwardsSceneCastLength(0.0)
+	, NumHits(0)
+{
+}
+
+
+void FGCQueryHeatmap::StartRecording(const UWorld* InWorld, const float InCellSize)
+{
+	StopRecording();
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		// Let go of the cells of threads that have exited (we're the only ones left holding them)
+		ThreadCells.RemoveAllSwap([](const TSharedPtr<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe>& InThreadCells) { return InThreadCells.GetSharedReferenceCount() <= 1; });
+		for (const TSharedPtr<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe>& Entry : ThreadCells)
+		{
+			FScopeLock ThreadLock(&Entry->CriticalSection);
+			Entry->Cells.Reset();
+		}
+		CellSize = FMath::Max(InCellSize, 1.f);
+		MapName = (InWorld ? UWorld::RemovePIEPrefix(InWorld->GetOutermost()->GetName()) : FString());
+	}
+
+	OnWorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddStatic(&FGCQueryHeatmap::OnWorldCleanup);
+	bRecording = true;
+
+	UE_LOG(LogGCQueryHeatmap, Log, TEXT("%s() Summing queries on \"%s\" into %.0f unit cells."), ANSI_TO_TCHAR(__FUNCTION__), *MapName, CellSize);
+}
+
+void FGCQueryHeatmap::StopRecording()
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	bRecording = false;
+	FWorldDelegates::OnWorldCleanup.Remove(OnWorldCleanupHandle);
+	OnWorldCleanupHandle.Reset();
+
+	TMap<FIntVector, FGCQueryHeatmapCell> Cells;
+	GatherCells(Cells);
+	UE_LOG(LogGCQueryHeatmap, Log, TEXT("%s() Stopped with %d cells."), ANSI_TO_TCHAR(__FUNCTION__), Cells.Num());
+}
+
+void FGCQueryHeatmap::AddSample(const FGCQueryHeatmapSample& InSample, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults)
+{
+	const double BackwardsSceneCastLength = (InSample.BackwardsStart.IsSet() ? FVector::Distance(InSample.BackwardsStart.GetValue(), InSample.Start) : 0.0);
+
+	// Work out the cells before taking the lock
+	TArray<FIntVector, TInlineAllocator<64>> SegmentCells;
+	GetSegmentCells(InSample.Start, InSample.End, SegmentCells);
+	TArray<FIntVector, TInlineAllocator<32>> HitCells;
+	HitCells.Reserve(InEntranceHitResults.Num() + InExitHitResults.Num());
+	for (const FHitResult& EntranceHitResult : InEntranceHitResults)
+	{
+		HitCells.Add(GetCellCoordinates(EntranceHitResult.ImpactPoint));
+	}
+	for (const FHitResult& ExitHitResult : InExitHitResults)
+	{
+		HitCells.Add(GetCellCoordinates(ExitHitResult.ImpactPoint));
+	}
+
+	const double Share = 1.0 / SegmentCells.Num();
+
+	FGCQueryHeatmapThreadCells& MyThreadCells = GetThreadCells();
+	FScopeLock Lock(&MyThreadCells.CriticalSection);
+
+	for (const FIntVector& Coordinates : SegmentCells)
+	{
+		FGCQueryHeatmapCell& Cell = MyThreadCells.Cells.FindOrAdd(Coordinates);
+		++Cell.NumQueries;
+		Cell.Seconds += InSample.Seconds * Share;
+		Cell.NumSceneCasts += InSample.NumSceneCasts * Share;
+		Cell.BackwardsSceneCastLength += BackwardsSceneCastLength * Share;
+	}
+	for (const FIntVector& Coordinates : HitCells)
+	{
+		++MyThreadCells.Cells.FindOrAdd(Coordinates).NumHits;
+	}
+}
+
+bool FGCQueryHeatmap::Export(FString InBaseFilename)
+{
+	// Copy everything out first so that queries aren't held up by the file writing
+	TMap<FIntVector, FGCQueryHeatmapCell> Cells;
+	GatherCells(Cells);
+	FString ExportMapName;
+	float ExportCellSize;
+	{
+		FScopeLock Lock(&CriticalSection);
+		ExportMapName = MapName;
+		ExportCellSize = CellSize;
+	}
+
+	if (Cells.Num() <= 0)
+	{
+		UE_LOG(LogGCQueryHeatmap, Warning, TEXT("%s() Nothing to export. Start with GC.QueryHeatmap.Start."), ANSI_TO_TCHAR(__FUNCTION__));
+		return false;
+	}
+
+	if (InBaseFilename.IsEmpty())
+	{
+		InBaseFilename = FPaths::ProfilingDir() / TEXT("GCQueryHeatmaps") / (FPaths::GetBaseFilename(ExportMapName) + TEXT("_") + FDateTime::Now().ToString());
+	}
+
+
+	// CSV of every cell
+	FIntVector MinCell = FIntVector(MAX_int32);
+	FIntVector MaxCell = FIntVector(MIN_int32);
+	{
+		FString Csv = TEXT("CellX,CellY,CellZ,CenterX,CenterY,CenterZ,Queries,Milliseconds,SceneCasts,Hits,HitsPerQuery,BackwardsSceneCastLength\n");
+		for (const TPair<FIntVector, FGCQueryHeatmapCell>& CellPair : Cells)
+		{
+			const FIntVector& Coordinates = CellPair.Key;
+			const FGCQueryHeatmapCell& Cell = CellPair.Value;
+			const FVector Center = (FVector(Coordinates) + FVector(.5f)) * ExportCellSize;
+
+			Csv += FString::Printf(TEXT("%d,%d,%d,%.0f,%.0f,%.0f,%d,%.4f,%.2f,%d,%.2f,%.0f\n"),
+				Coordinates.X, Coordinates.Y, Coordinates.Z, Center.X, Center.Y, Center.Z,
+				Cell.NumQueries, Cell.Seconds * 1000.0, Cell.NumSceneCasts, Cell.NumHits, (Cell.NumQueries > 0 ? static_cast<double>(Cell.NumHits) / Cell.NumQueries : 0.0), Cell.BackwardsSceneCastLength);
+
+			MinCell = FIntVector(FMath::Min(MinCell.X, Coordinates.X), FMath::Min(MinCell.Y, Coordinates.Y), FMath::Min(MinCell.Z, Coordinates.Z));
+			MaxCell = FIntVector(FMath::Max(MaxCell.X, Coordinates.X), FMath::Max(MaxCell.Y, Coordinates.Y), FMath::Max(MaxCell.Z, Coordinates.Z));
+		}
+
+		const FString CsvFilename = InBaseFilename + TEXT(".csv");
+		if (!FFileHelper::SaveStringToFile(Csv, *CsvFilename))
+		{
+			UE_LOG(LogGCQueryHeatmap, Error, TEXT("%s() Couldn't write \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *CsvFilename);
+			return false;
+		}
+		UE_LOG(LogGCQueryHeatmap, Display, TEXT("%s() Wrote %d cells to \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), Cells.Num(), *CsvFilename);
+	}
+
+
+	// Top down PNG of the time spent in each column of cells
+	const int32 ImageWidth = MaxCell.X - MinCell.X + 1;
+	const int32 ImageHeight = MaxCell.Y - MinCell.Y + 1;
+	if (ImageWidth > MaxImageSize || ImageHeight > MaxImageSize)
+	{
+		UE_LOG(LogGCQueryHeatmap, Warning, TEXT("%s() The grid is %dx%d cells which is too big for an image. Use a bigger cell size for one."), ANSI_TO_TCHAR(__FUNCTION__), ImageWidth, ImageHeight);
+		return true;
+	}
+
+	TArray<double> ColumnSeconds;
+	ColumnSeconds.SetNumZeroed(ImageWidth * ImageHeight);
+	double MaxColumnSeconds = 0.0;
+	for (const TPair<FIntVector, FGCQueryHeatmapCell>& CellPair : Cells)
+	{
+		double& Seconds = ColumnSeconds[((CellPair.Key.Y - MinCell.Y) * ImageWidth) + (CellPair.Key.X - MinCell.X)];
+		Seconds += CellPair.Value.Seconds;
+		MaxColumnSeconds = FMath::Max(MaxColumnSeconds, Seconds);
+	}
+
+	TArray<FColor> Pixels;
+	Pixels.Reserve(ColumnSeconds.Num());
+	for (const double Seconds : ColumnSeconds)
+	{
+		if (Seconds <= 0.0 || MaxColumnSeconds <= 0.0)
+		{
+			Pixels.Add(FColor::Black);
+			continue;
+		}
+
+		// Square root so that the cheaper cells don't all end up the same blue next to the hottest one
+		const float Alpha = FMath::Sqrt(static_cast<float>(Seconds / MaxColumnSeconds));
+		Pixels.Add(FLinearColor::LerpUsingHSV(FLinearColor::Blue, FLinearColor::Red, Alpha).ToFColor(true));
+	}
+
+	TArray<uint8> Png;
+	FImageUtils::CompressImageArray(ImageWidth, ImageHeight, Pixels, Png);
+	const FString PngFilename = InBaseFilename + TEXT(".png");
+	if (!FFileHelper::SaveArrayToFile(Png, *PngFilename))
+	{
+		UE_LOG(LogGCQueryHeatmap, Error, TEXT("%s() Couldn't write \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *PngFilename);
+		return false;
+	}
+	UE_LOG(LogGCQueryHeatmap, Display, TEXT("%s() Wrote a %dx%d image to \"%s\". Pixel (0, 0) is the cell at %s."), ANSI_TO_TCHAR(__FUNCTION__), ImageWidth, ImageHeight, *PngFilename, *(FVector(MinCell.X, MinCell.Y, 0) * ExportCellSize).ToString());
+
+	return true;
+}
+
+void FGCQueryHeatmap::CountSceneCast()
+{
+	++GNumSceneCastsOnThisThread;
+}
+uint32 FGCQueryHeatmap::GetNumSceneCastsOnThisThread()
+{
+	return GNumSceneCastsOnThisThread;
+}
+
+void FGCQueryHeatmap::GetSegmentCells(const FVector& InStart, const FVector& InEnd, TArray<FIntVector, TInlineAllocator<64>>& OutSegmentCells)
+{
+	// Step along at half a cell so that we don't skip any, but only so many times for very long queries
+	const float Length = FVector::Distance(InStart, InEnd);
+	const int32 NumSteps = FMath::Clamp(FMath::CeilToInt(Length / (CellSize * .5f)), 1, 256);
+
+	for (int32 i = 0; i <= NumSteps; ++i)
+	{
+		const FIntVector Coordinates = GetCellCoordinates(FMath::Lerp(InStart, InEnd, static_cast<float>(i) / NumSteps));
+
+		// A segment never comes back to a cell it has left (cells are convex), so a repeat can only be of the last one
+		if (OutSegmentCells.Num() <= 0 || OutSegmentCells.Last() != Coordinates)
+		{
+			OutSegmentCells.Add(Coordinates);
+		}
+	}
+}
+
+FIntVector FGCQueryHeatmap::GetCellCoordinates(const FVector& InLocation)
+{
+	return FIntVector(FMath::FloorToInt(InLocation.X / CellSize), FMath::FloorToInt(InLocation.Y / CellSize), FMath::FloorToInt(InLocation.Z / CellSize));
+}
+
+FGCQueryHeatmapThreadCells& FGCQueryHeatmap::GetThreadCells()
+{
+	if (!GThreadCells.IsValid())
+	{
+		GThreadCells = MakeShared<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe>();
+
+		FScopeLock Lock(&CriticalSection);
+		ThreadCells.Add(GThreadCells);
+	}
+
+	return *GThreadCells;
+}
+
+void FGCQueryHeatmap::GatherCells(TMap<FIntVector, FGCQueryHeatmapCell>& OutCells)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	for (const TSharedPtr<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe>& Entry : ThreadCells)
+	{
+		FScopeLock ThreadLock(&Entry->CriticalSection);
+
+		for (const TPair<FIntVector, FGCQueryHeatmapCell>& CellPair : Entry->Cells)
+		{
+			FGCQueryHeatmapCell& Cell = OutCells.FindOrAdd(CellPair.Key);
+			Cell.NumQueries += CellPair.Value.NumQueries;
+			Cell.Seconds += CellPair.Value.Seconds;
+			Cell.NumSceneCasts += CellPair.Value.NumSceneCasts;
+			Cell.BackwardsSceneCastLength += CellPair.Value.BackwardsSceneCastLength;
+			Cell.NumHits += CellPair.Value.NumHits;
+		}
+	}
+}
+
+void FGCQueryHeatmap::OnWorldCleanup(UWorld* InWorld, bool bInSessionEnded, bool bInCleanupResources)
+{
+	if (!InWorld || UWorld::RemovePIEPrefix(InWorld->GetOutermost()->GetName()) != MapName)
+	{
+		return;
+	}
+
+	// The match on our map is over
+	StopRecording();
+	Export();
+}
@@ -0,0 +1,403 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/GCQueryRecorder.h"
+
+#include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_CollisionQueries.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+
+
+TAtomic<bool> FGCQueryRecorder::bRecording(false);
+FCriticalSection FGCQueryRecorder::CriticalSection;
+TUniquePtr<FArchive> FGCQueryRecorder::FileWriter;
+TArray<uint8> FGCQueryRecorder::Buffer;
+int32 FGCQueryRecorder::NumRecords = 0;
+
+static FAutoConsoleCommandWithWorldAndArgs GCQueryRecorderStartCommand(
+	TEXT("GC.QueryRecorder.Start"),
+	TEXT("Starts capturing GameCore's queries into a file for replaying them with the GCQueryReplay commandlet. Args: [Filename=Saved/Profiling/GCQueries/<date>.gcqr]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld)
+		{
+			const FString Filename = InArgs.IsValidIndex(0) ? InArgs[0] : (FPaths::ProfilingDir() / TEXT("GCQueries") / (FDateTime::Now().ToString() + TEXT(".gcqr")));
+			FGCQueryRecorder::StartRecording(Filename, InWorld);
+		}));
+
+static FAutoConsoleCommand GCQueryRecorderStopCommand(
+	TEXT("GC.QueryRecorder.Stop"),
+	TEXT("Stops capturing GameCore's queries and finishes the file"),
+	FConsoleCommandDelegate::CreateStatic(&FGCQueryRecorder::StopRecording));
+
+
+FGCQueryRecord::FGCQueryRecord()
+	: Type(EGCQueryRecordType::SceneCastMultiWithExitHits)
+	, Start(FVector::ZeroVector)
+	, End(FVector::ZeroVector)
+	, Rotation(FQuat::Identity)
+	, TraceChannel(ECollisionChannel::ECC_Visibility)
+	, CollisionShape(FCollisionShape())
+	, bTraceComplex(false)
+	, bFindInitialOverlaps(true)
+	, bReturnPhysicalMaterial(false)
+	, bReturnFaceIndex(false)
+	, bIgnoreTouches(false)
+	, bOptimizeBackwardsSceneCastLength(false)
+	, ExitHitsMethod(EExitHitsMethod::BackwardsSceneCast)
+	, FurthestPossibleExitMethod(EFurthestPossibleExitMethod::BoundingSphere)
+	, ProgressiveChunkLength(0.f)
+	, bBlockingHit(false)
+	, NumEntranceHits(0)
+	, NumExitHits(0)
+	, FurthestEntranceLocation(FVector::ZeroVector)
+	, Microseconds(0.f)
+{
+}
+
+void FGCQueryRecord::GetCollisionParams(FCollisionQueryParams& OutCollisionQueryParams, FCollisionResponseParams& OutCollisionResponseParams) const
+{
+	OutCollisionQueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(GCQueryReplay), bTraceComplex);
+	OutCollisionQueryParams.bFindInitialOverlaps = bFindInitialOverlaps;
+	OutCollisionQueryParams.bReturnPhysicalMaterial = bReturnPhysicalMaterial;
+	OutCollisionQueryParams.bReturnFaceIndex = bReturnFaceIndex;
+	OutCollisionQueryParams.bIgnoreTouches = bIgnoreTouches;
+
+	OutCollisionResponseParams = FCollisionResponseParams(CollisionResponses);
+}
+
+void FGCQueryRecord::SetResults(const bool bInBlockingHit, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults)
+{
+	bBlockingHit = bInBlockingHit;
+	NumEntranceHits = InEntranceHitResults.Num();
+	NumExitHits = InExitHitResults.Num();
+	FurthestEntranceLocation = (InEntranceHitResults.Num() > 0 ? InEntranceHitResults.Last().Location : End);
+}
+void FGCQueryRecord::SetResults(const bool bInBlockingHit, const TArray<FExitAwareHitResult>& InHitResults)
+{
+	bBlockingHit = bInBlockingHit;
+	NumEntranceHits = 0;
+	NumExitHits = 0;
+	FurthestEntranceLocation = End;
+	for (const FExitAwareHitResult& Hit : InHitResults) // in forwards order
+	{
+		if (Hit.bIsExitHit)
+		{
+			++NumExitHits;
+		}
+		else
+		{
+			++NumEntranceHits;
+			FurthestEntranceLocation = Hit.Location;
+		}
+	}
+}
+
+bool FGCQueryRecord::HasSameResults(const FGCQueryRecord& InOther, const float InLocationTolerance) const
+{
+	return bBlockingHit == InOther.bBlockingHit
+		&& NumEntranceHits == InOther.NumEntranceHits
+		&& NumExitHits == InOther.NumExitHits
+		&& FurthestEntranceLocation.Equals(InOther.FurthestEntranceLocation, InLocationTolerance);
+}
+
+FArchive& operator<<(FArchive& InOutArchive, FGCQueryRecord& InOutRecord)
+{
+	uint8 Type = static_cast<uint8>(InOutRecord.Type);
+	InOutArchive << Type;
+	InOutRecord.Type = static_cast<EGCQueryRecordType>(Type);
+
+	InOutArchive << InOutRecord.Start;
+	InOutArchive << InOutRecord.End;
+	InOutArchive << InOutRecord.Rotation;
+	InOutArchive << InOutRecord.TraceChannel;
+
+	// Shape (line traces don't need an extent)
+	uint8 ShapeType = static_cast<uint8>(InOutRecord.CollisionShape.ShapeType);
+	InOutArchive << ShapeType;
+	if (ShapeType != static_cast<uint8>(ECollisionShape::Line))
+	{
+		FVector Extent = InOutRecord.CollisionShape.GetExtent();
+		InOutArchive << Extent;
+		if (InOutArchive.IsLoading())
+		{
+			switch (static_cast<ECollisionShape::Type>(ShapeType))
+			{
+			case ECollisionShape::Box:
+				InOutRecord.CollisionShape = FCollisionShape::MakeBox(Extent);
+				break;
+			case ECollisionShape::Sphere:
+				InOutRecord.CollisionShape = FCollisionShape::MakeSphere(Extent.X);
+				break;
+			case ECollisionShape::Capsule:
+				InOutRecord.CollisionShape = FCollisionShape::MakeCapsule(Extent.X, Extent.Z);
+				break;
+			default:
+				InOutArchive.SetError();
+				break;
+			}
+		}
+	}
+	else if (InOutArchive.IsLoading())
+	{
+		InOutRecord.CollisionShape = FCollisionShape();
+	}
+
+	// Bit packed params
+	uint8 Flags = static_cast<uint8>((InOutRecord.bTraceComplex << 0)
+		| (InOutRecord.bFindInitialOverlaps << 1)
+		| (InOutRecord.bReturnPhysicalMaterial << 2)
+		| (InOutRecord.bReturnFaceIndex << 3)
+		| (InOutRecord.bIgnoreTouches << 4)
+		| (InOutRecord.bOptimizeBackwardsSceneCastLength << 5)
+		| (InOutRecord.bBlockingHit << 6));
+	InOutArchive << Flags;
+	InOutRecord.bTraceComplex = (Flags >> 0) & 1;
+	InOutRecord.bFindInitialOverlaps = (Flags >> 1) & 1;
+	InOutRecord.bReturnPhysicalMaterial = (Flags >> 2) & 1;
+	InOutRecord.bReturnFaceIndex = (Flags >> 3) & 1;
+	InOutRecord.bIgnoreTouches = (Flags >> 4) & 1;
+	InOutRecord.bOptimizeBackwardsSceneCastLength = (Flags >> 5) & 1;
+	InOutRecord.bBlockingHit = (Flags >> 6) & 1;
+
+	uint8 ExitHitsMethod = static_cast<uint8>(InOutRecord.ExitHitsMethod);
+	uint8 FurthestPossibleExitMethod = static_cast<uint8>(InOutRecord.FurthestPossibleExitMethod);
+	InOutArchive << ExitHitsMethod;
+	InOutArchive << FurthestPossibleExitMethod;
+	InOutRecord.ExitHitsMethod = static_cast<EExitHitsMethod>(ExitHitsMethod);
+	InOutRecord.FurthestPossibleExitMethod = static_cast<EFurthestPossibleExitMethod>(FurthestPossibleExitMethod);
+	InOutArchive << InOutRecord.ProgressiveChunkLength;
+
+	for (uint8& Response : InOutRecord.CollisionResponses.EnumArray)
+	{
+		InOutArchive << Response;
+	}
+
+	InOutArchive << InOutRecord.ImpenetrableOutcomes;
+
+	// Results
+	uint32 NumEntranceHits = InOutRecord.NumEntranceHits;
+	uint32 NumExitHits = InOutRecord.NumExitHits;
+	InOutArchive.SerializeIntPacked(NumEntranceHits);
+	InOutArchive.SerializeIntPacked(NumExitHits);
+	InOutRecord.NumEntranceHits = NumEntranceHits;
+	InOutRecord.NumExitHits = NumExitHits;
+	InOutArchive << InOutRecord.FurthestEntranceLocation;
+	InOutArchive << InOutRecord.Microseconds;
+
+	return InOutArchive;
+}
+
+
+bool FGCQueryRecorder::StartRecording(const FString& InFilename, const UWorld* InWorld)
+{
+	StopRecording();
+
+	FScopeLock Lock(&CriticalSection);
+
+	FileWriter = TUniquePtr<FArchive>(IFileManager::Get().CreateFileWriter(*InFilename));
+	if (!FileWriter)
+	{
+		UE_LOG(LogGCQueryRecorder, Error, TEXT("%s() Couldn't create file \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename);
+		return false;
+	}
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	FString MapName = (InWorld ? UWorld::RemovePIEPrefix(InWorld->GetOutermost()->GetName()) : FString());
+	*FileWriter << Magic;
+	*FileWriter << Version;
+	*FileWriter << MapName;
+
+	NumRecords = 0;
+	bRecording = true;
+
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("%s() Recording queries on map \"%s\" to \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *MapName, *InFilename);
+	return true;
+}
+
+void FGCQueryRecorder::StopRecording()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	bRecording = false;
+	if (!FileWriter)
+	{
+		return;
+	}
+
+	FlushBuffer();
+	FileWriter->Close();
+	FileWriter.Reset();
+
+	UE_LOG(LogGCQueryRecorder, Display, TEXT("%s() Recorded %d queries."), ANSI_TO_TCHAR(__FUNCTION__), NumRecords);
+}
+
+void FGCQueryRecorder::AddRecord(FGCQueryRecord& InOutRecord)
+{
+	// Serialize outside of the lock, since queries can be recorded from many threads at once
+	TArray<uint8> RecordBytes;
+	FMemoryWriter RecordWriter(RecordBytes);
+	RecordWriter << InOutRecord;
+
+	FScopeLock Lock(&CriticalSection);
+	if (!FileWriter)
+	{
+		return; // stopped while this query was running
+	}
+
+	Buffer.Append(RecordBytes);
+	++NumRecords;
+
+	if (Buffer.Num() >= 1024 * 1024)
+	{
+		FlushBuffer();
+	}
+}
+
+bool FGCQueryRecorder::LoadRecording(const FString& InFilename, FString& OutMapName, TArray<FGCQueryRecord>& OutRecords)
+{
+	OutRecords.Reset();
+
+	TUniquePtr<FArchive> FileReader = TUniquePtr<FArchive>(IFileManager::Get().CreateFileReader(*InFilename));
+	if (!FileReader)
+	{
+		UE_LOG(LogGCQueryRecorder, Error, TEXT("%s() Couldn't open file \"%s\"."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*FileReader << Magic;
+	*FileReader << Version;
+	if (Magic != FileMagic || Version != FileVersion)
+	{
+		UE_LOG(LogGCQueryRecorder, Error, TEXT("%s() \"%s\" isn't a query recording of version %u."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename, FileVersion);
+		return false;
+	}
+	*FileReader << OutMapName;
+
+	while (!FileReader->AtEnd() && !FileReader->IsError())
+	{
+		*FileReader << OutRecords.AddDefaulted_GetRef();
+	}
+
+	if (FileReader->IsError())
+	{
+		UE_LOG(LogGCQueryRecorder, Error, TEXT("%s() \"%s\" is corrupted after %d queries."), ANSI_TO_TCHAR(__FUNCTION__), *InFilename, OutRecords.Num() - 1);
+		OutRecords.Pop();
+		return false;
+	}
+	return true;
+}
+
+void FGCQueryRecorder::FlushBuffer()
+{
+	if (FileWriter && Buffer.Num() > 0)
+	{
+		FileWriter->Serialize(Buffer.GetData(), Buffer.Num());
+	}
+	Buffer.Reset();
+}
+
+
+FGCQueryRecordScope::FGCQueryRecordScope(const EGCQueryRecordType InType, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bInOptimizeBackwardsSceneCastLength, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, const float InProgressiveChunkLength)
+	: EntranceHitResults(InEntranceHitResults)
+	, ExitHitResults(InExitHitResults)
+	, bBlockingHit(false)
+	, StartCycles(0)
+	, StartNumSceneCasts(0)
+{
+	if (FGCQueryHeatmap::IsRecording())
+	{
+		FGCQueryHeatmapSample& NewHeatmapSample = HeatmapSample.Emplace();
+		NewHeatmapSample.Start = InStart;
+		NewHeatmapSample.End = InEnd;
+
+		StartCycles = FPlatformTime::Cycles64();
+		StartNumSceneCasts = FGCQueryHeatmap::GetNumSceneCastsOnThisThread();
+	}
+
+	if (FGCQueryVisualizer::IsEnabled())
+	{
+		FGCQueryVisualizerEntry& NewVisualizerEntry = VisualizerEntry.Emplace();
+		NewVisualizerEntry.Type = InType;
+		NewVisualizerEntry.Start = InStart;
+		NewVisualizerEntry.End = InEnd;
+		NewVisualizerEntry.Rotation = InRotation;
+		NewVisualizerEntry.TraceChannel = InTraceChannel;
+		NewVisualizerEntry.CollisionShape = InCollisionShape;
+		NewVisualizerEntry.OwnerTag = InCollisionQueryParams.OwnerTag;
+		NewVisualizerEntry.TraceTag = InCollisionQueryParams.TraceTag;
+	}
+
+	if (!FGCQueryRecorder::IsRecording())
+	{
+		return;
+	}
+
+	FGCQueryRecord& NewRecord = Record.Emplace();
+	NewRecord.Type = InType;
+	NewRecord.Start = InStart;
+	NewRecord.End = InEnd;
+	NewRecord.Rotation = InRotation;
+	NewRecord.TraceChannel = InTraceChannel;
+	NewRecord.CollisionShape = InCollisionShape;
+	NewRecord.bTraceComplex = InCollisionQueryParams.bTraceComplex;
+	NewRecord.bFindInitialOverlaps = InCollisionQueryParams.bFindInitialOverlaps;
+	NewRecord.bReturnPhysicalMaterial = InCollisionQueryParams.bReturnPhysicalMaterial;
+	NewRecord.bReturnFaceIndex = InCollisionQueryParams.bReturnFaceIndex;
+	NewRecord.bIgnoreTouches = InCollisionQueryParams.bIgnoreTouches;
+	NewRecord.bOptimizeBackwardsSceneCastLength = bInOptimizeBackwardsSceneCastLength;
+	NewRecord.ExitHitsMethod = InExitHitsMethod;
+	NewRecord.FurthestPossibleExitMethod = InFurthestPossibleExitMethod;
+	NewRecord.ProgressiveChunkLength = InProgressiveChunkLength;
+	NewRecord.CollisionResponses = InCollisionResponseParams.CollisionResponse;
+
+	StartCycles = FPlatformTime::Cycles64();
+}
+
+FGCQueryRecordScope::~FGCQueryRecordScope()
+{
+	if (HeatmapSample.IsSet())
+	{
+		HeatmapSample->Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+		HeatmapSample->NumSceneCasts = FGCQueryHeatmap::GetNumSceneCastsOnThisThread() - StartNumSceneCasts;
+		if (bBlockingHit && EntranceHitResults.Num() > 0)
+		{
+			HeatmapSample->End = EntranceHitResults.Last().Location;
+		}
+		FGCQueryHeatmap::AddSample(HeatmapSample.GetValue(), EntranceHitResults, ExitHitResults);
+	}
+
+	if (VisualizerEntry.IsSet())
+	{
+		VisualizerEntry->Time = FPlatformTime::Seconds();
+		VisualizerEntry->SetResults(bBlockingHit, EntranceHitResults, ExitHitResults);
+		FGCQueryVisualizer::AddEntry(VisualizerEntry.GetValue());
+	}
+
+	if (!Record.IsSet())
+	{
+		return;
+	}
+
+	Record->Microseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1000.0;
+	Record->SetResults(bBlockingHit, EntranceHitResults, ExitHitResults);
+	FGCQueryRecorder::AddRecord(Record.GetValue());
+}
+
+void FGCQueryRecordScope::SetBackwardsStart(const FVector& InBackwardsStart)
+{
+	if (HeatmapSample.IsSet())
+	{
+		HeatmapSample->BackwardsStart = InBackwardsStart;
+	}
+	if (VisualizerEntry.IsSet())
+	{
+		VisualizerEntry->bHasBackwardsStart = true;
+		VisualizerEntry->BackwardsStart = InBackwardsStart;
+	}
+}
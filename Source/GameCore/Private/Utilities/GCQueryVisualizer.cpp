@@ -0,0 +1,333 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/GCQueryVisualizer.h"
+
+#include "Utilities/GCQueryRecorder.h"
+#include "BlueprintFunctionLibraries/Debugging/GCBlueprintFunctionLibrary_DrawDebugHelpers.h"
+#include "Components/LineBatchComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "VisualLogger/VisualLogger.h"
+
+
+
+FCriticalSection FGCQueryVisualizer::CriticalSection;
+TArray<TSharedPtr<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe>> FGCQueryVisualizer::ThreadEntries;
+
+/** Not a member since thread_local can't be exported from the module */
+static thread_local TSharedPtr<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe> GThreadEntries;
+
+static TAutoConsoleVariable<bool> CVarGCQueryVisualizerEnabled(
+	TEXT("GC.QueryVisualizer.Enabled"),
+	false,
+	TEXT("Whether GameCore's queries are kept in the query visualizer's ring buffer for drawing later with GC.QueryVisualizer.Draw"));
+
+static TAutoConsoleVariable<int32> CVarGCQueryVisualizerCapacity(
+	TEXT("GC.QueryVisualizer.Capacity"),
+	2048,
+	TEXT("How many of the most recent queries the query visualizer keeps. Changing it empties the ring buffer."));
+
+static FAutoConsoleCommandWithWorldAndArgs GCQueryVisualizerDrawCommand(
+	TEXT("GC.QueryVisualizer.Draw"),
+	TEXT("Draws the query visualizer's recent queries. Args: [Seconds=<Only the last this many>] [Actor=<Only owner tags containing this>] [Channel=<ECC_ name or number>] [Duration=10]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld)
+		{
+			float Duration = 10.f;
+			FParse::Value(*FString::Join(InArgs, TEXT(" ")), TEXT("Duration="), Duration);
+			FGCQueryVisualizer::DrawEntries(InWorld, FGCQueryVisualizerFilter::FromArgs(InArgs), Duration);
+		}));
+
+static FAutoConsoleCommandWithWorldAndArgs GCQueryVisualizerVisLogCommand(
+	TEXT("GC.QueryVisualizer.VisLog"),
+	TEXT("Sends the query visualizer's recent queries to the visual logger. Args: [Seconds=<Only the last this many>] [Actor=<Only owner tags containing this>] [Channel=<ECC_ name or number>]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& InArgs, UWorld* InWorld)
+		{
+			FGCQueryVisualizer::VisLogEntries(InWorld, FGCQueryVisualizerFilter::FromArgs(InArgs));
+		}));
+
+static FAutoConsoleCommand GCQueryVisualizerClearCommand(
+	TEXT("GC.QueryVisualizer.Clear"),
+	TEXT("Empties the query visualizer's ring buffer"),
+	FConsoleCommandDelegate::CreateStatic(&FGCQueryVisualizer::Clear));
+
+
+FGCQueryVisualizerEntry::FGCQueryVisualizerEntry()
+	: Time(0.0)
+	, Type(EGCQueryRecordType::SceneCastMultiWithExitHits)
+	, Start(FVector::ZeroVector)
+	, End(FVector::ZeroVector)
+	, Rotation(FQuat::Identity)
+	, TraceChannel(ECollisionChannel::ECC_Visibility)
+	, CollisionShape(FCollisionShape())
+	, OwnerTag(NAME_None)
+	, TraceTag(NAME_None)
+	, bBlockingHit(false)
+	, bHasBackwardsStart(false)
+	, StopLocation(FVector::ZeroVector)
+	, BackwardsStart(FVector::ZeroVector)
+	, NumEntranceHits(0)
+	, NumExitHits(0)
+	, NumHitLocations(0)
+	, ExitHitBits(0)
+{
+}
+
+void FGCQueryVisualizerEntry::SetResults(const bool bInBlockingHit, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults)
+{
+	bBlockingHit = bInBlockingHit;
+	NumEntranceHits = InEntranceHitResults.Num();
+	NumExitHits = InExitHitResults.Num();
+	StopLocation = ((bInBlockingHit && InEntranceHitResults.Num() > 0) ? InEntranceHitResults.Last().Location : End);
+
+	NumHitLocations = 0;
+	ExitHitBits = 0;
+	for (const FHitResult& EntranceHitResult : InEntranceHitResults)
+	{
+		if (NumHitLocations >= MaxHitLocations)
+		{
+			break;
+		}
+		HitLocations[NumHitLocations++] = EntranceHitResult.ImpactPoint;
+	}
+	for (const FHitResult& ExitHitResult : InExitHitResults)
+	{
+		if (NumHitLocations >= MaxHitLocations)
+		{
+			break;
+		}
+		ExitHitBits |= (1u << NumHitLocations);
+		HitLocations[NumHitLocations++] = ExitHitResult.ImpactPoint;
+	}
+}
+
+
+FGCQueryVisualizerFilter::FGCQueryVisualizerFilter()
+	: TimeWindow(0.f)
+{
+}
+
+FGCQueryVisualizerFilter FGCQueryVisualizerFilter::FromArgs(const TArray<FString>& InArgs)
+{
+	FGCQueryVisualizerFilter Filter = FGCQueryVisualizerFilter();
+	const FString Args = FString::Join(InArgs, TEXT(" "));
+
+	FParse::Value(*Args, TEXT("Seconds="), Filter.TimeWindow);
+	FParse::Value(*Args, TEXT("Actor="), Filter.Actor);
+
+	FString ChannelString;
+	if (FParse::Value(*Args, TEXT("Channel="), ChannelString))
+	{
+		const int64 ChannelValue = (ChannelString.IsNumeric() ? FCString::Atoi64(*ChannelString) : StaticEnum<ECollisionChannel>()->GetValueByNameString(ChannelString));
+		if (ChannelValue >= 0 && ChannelValue < ECollisionChannel::ECC_MAX)
+		{
+			Filter.TraceChannel = static_cast<ECollisionChannel>(ChannelValue);
+		}
+		else
+		{
+			UE_LOG(LogGCQueryVisualizer, Warning, TEXT("%s() \"%s\" isn't a collision channel. Not filtering by channel."), ANSI_TO_TCHAR(__FUNCTION__), *ChannelString);
+		}
+	}
+
+	return Filter;
+}
+
+bool FGCQueryVisualizerFilter::Matches(const FGCQueryVisualizerEntry& InEntry, const double InNow) const
+{
+	if (TimeWindow > 0.f && InNow - InEntry.Time > TimeWindow)
+	{
+		return false;
+	}
+	if (TraceChannel.IsSet() && InEntry.TraceChannel != TraceChannel.GetValue())
+	{
+		return false;
+	}
+	if (!Actor.IsEmpty() && !InEntry.OwnerTag.ToString().Contains(Actor))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+FGCQueryVisualizerThreadEntries::FGCQueryVisualizerThreadEntries()
+	: Capacity(0)
+	, NextEntryIndex(0)
+{
+}
+
+
+bool FGCQueryVisualizer::IsEnabled()
+{
+	return CVarGCQueryVisualizerEnabled.GetValueOnAnyThread();
+}
+
+void FGCQueryVisualizer::AddEntry(const FGCQueryVisualizerEntry& InEntry)
+{
+	const int32 WantedCapacity = FMath::Max(CVarGCQueryVisualizerCapacity.GetValueOnAnyThread(), 1);
+
+	FGCQueryVisualizerThreadEntries& MyThreadEntries = GetThreadEntries();
+	FScopeLock Lock(&MyThreadEntries.CriticalSection);
+
+	if (MyThreadEntries.Capacity != WantedCapacity)
+	{
+		MyThreadEntries.Capacity = WantedCapacity;
+		MyThreadEntries.Entries.Empty(WantedCapacity);
+		MyThreadEntries.NextEntryIndex = 0;
+	}
+
+	if (MyThreadEntries.Entries.Num() < MyThreadEntries.Capacity)
+	{
+		MyThreadEntries.Entries.Add(InEntry);
+		return;
+	}
+
+	MyThreadEntries.Entries[MyThreadEntries.NextEntryIndex] = InEntry;
+	MyThreadEntries.NextEntryIndex = (MyThreadEntries.NextEntryIndex + 1) % MyThreadEntries.Capacity;
+}
+
+void FGCQueryVisualizer::GetEntries(const FGCQueryVisualizerFilter& InFilter, TArray<FGCQueryVisualizerEntry>& OutEntries)
+{
+	OutEntries.Reset();
+	const double Now = FPlatformTime::Seconds();
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		for (const TSharedPtr<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe>& Entry : ThreadEntries)
+		{
+			FScopeLock ThreadLock(&Entry->CriticalSection);
+			OutEntries.Append(Entry->Entries);
+		}
+	}
+
+	// Merge the threads' rings into one, keeping only as many of the most recent entries as a single ring would have
+	OutEntries.Sort([](const FGCQueryVisualizerEntry& InA, const FGCQueryVisualizerEntry& InB) { return InA.Time < InB.Time; });
+	const int32 Capacity = FMath::Max(CVarGCQueryVisualizerCapacity.GetValueOnAnyThread(), 1);
+	if (OutEntries.Num() > Capacity)
+	{
+		OutEntries.RemoveAt(0, OutEntries.Num() - Capacity, false);
+	}
+
+	OutEntries.RemoveAll([&InFilter, Now](const FGCQueryVisualizerEntry& InEntry) { return !InFilter.Matches(InEntry, Now); });
+}
+
+void FGCQueryVisualizer::Clear()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	// Let go of the rings of threads that have exited (we're the only ones left holding them)
+	ThreadEntries.RemoveAllSwap([](const TSharedPtr<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe>& InThreadEntries) { return InThreadEntries.GetSharedReferenceCount() <= 1; });
+	for (const TSharedPtr<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe>& Entry : ThreadEntries)
+	{
+		FScopeLock ThreadLock(&Entry->CriticalSection);
+		Entry->Entries.Reset();
+		Entry->NextEntryIndex = 0;
+	}
+}
+
+FGCQueryVisualizerThreadEntries& FGCQueryVisualizer::GetThreadEntries()
+{
+	if (!GThreadEntries.IsValid())
+	{
+		GThreadEntries = MakeShared<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe>();
+
+		FScopeLock Lock(&CriticalSection);
+		ThreadEntries.Add(GThreadEntries);
+	}
+
+	return *GThreadEntries;
+}
+
+void FGCQueryVisualizer::DrawEntries(const UWorld* InWorld, const FGCQueryVisualizerFilter& InFilter, const float InLifeTime)
+{
+#if ENABLE_DRAW_DEBUG
+	ULineBatchComponent* LineBatcher = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineBatcher(InWorld, false, InLifeTime);
+	if (!LineBatcher)
+	{
+		UE_LOG(LogGCQueryVisualizer, Warning, TEXT("%s() Nothing to draw with (no world or a dedicated server)."), ANSI_TO_TCHAR(__FUNCTION__));
+		return;
+	}
+	const float LineLifeTime = UGCBlueprintFunctionLibrary_DrawDebugHelpers::GetDebugLineLifeTime(*LineBatcher, false, InLifeTime);
+
+	TArray<FGCQueryVisualizerEntry> FilteredEntries;
+	GetEntries(InFilter, FilteredEntries);
+
+	static const FLinearColor TraceColor = FLinearColor(FColor::Green);
+	static const FLinearColor BlockedTraceColor = FLinearColor(FColor::Red);
+	static const FLinearColor EntranceHitColor = FLinearColor(FColor::Orange);
+	static const FLinearColor ExitHitColor = FLinearColor(FColor::Magenta);
+	static const FLinearColor BackwardsStartColor = FLinearColor(FColor::Cyan);
+	static constexpr float HitCrossSize = 5.f;
+	static constexpr float BackwardsStartLength = 20.f;
+
+	TArray<FBatchedLine> Lines;
+	Lines.Reserve(FilteredEntries.Num() * 4);
+	for (const FGCQueryVisualizerEntry& Entry : FilteredEntries)
+	{
+		// The trace, red past where it was stopped
+		Lines.Emplace(Entry.Start, Entry.StopLocation, TraceColor, LineLifeTime, 0.f, SDPG_World);
+		if (Entry.bBlockingHit)
+		{
+			Lines.Emplace(Entry.StopLocation, Entry.End, BlockedTraceColor, LineLifeTime, 0.f, SDPG_World);
+		}
+
+		// A cross at each hit
+		for (int32 i = 0; i < Entry.NumHitLocations; ++i)
+		{
+			const FVector& HitLocation = Entry.HitLocations[i];
+			const FLinearColor& HitColor = ((Entry.ExitHitBits & (1u << i)) ? ExitHitColor : EntranceHitColor);
+			Lines.Emplace(HitLocation - FVector(HitCrossSize, 0.f, 0.f), HitLocation + FVector(HitCrossSize, 0.f, 0.f), HitColor, LineLifeTime, 0.f, SDPG_World);
+			Lines.Emplace(HitLocation - FVector(0.f, HitCrossSize, 0.f), HitLocation + FVector(0.f, HitCrossSize, 0.f), HitColor, LineLifeTime, 0.f, SDPG_World);
+			Lines.Emplace(HitLocation - FVector(0.f, 0.f, HitCrossSize), HitLocation + FVector(0.f, 0.f, HitCrossSize), HitColor, LineLifeTime, 0.f, SDPG_World);
+		}
+
+		// Where the backwards scene cast started, pointing back towards the start
+		if (Entry.bHasBackwardsStart)
+		{
+			const FVector BackwardsDirection = (Entry.Start - Entry.End).GetSafeNormal();
+			Lines.Emplace(Entry.BackwardsStart, Entry.BackwardsStart + (BackwardsDirection * BackwardsStartLength), BackwardsStartColor, LineLifeTime, 0.f, SDPG_World);
+		}
+
+		// Sweeps' shapes where they started and stopped
+		if (!Entry.CollisionShape.IsLine())
+		{
+			UGCBlueprintFunctionLibrary_DrawDebugHelpers::AddDebugCollisionShapeLines(Lines, Entry.Start, Entry.CollisionShape, Entry.Rotation, TraceColor, 12, LineLifeTime, SDPG_World);
+			UGCBlueprintFunctionLibrary_DrawDebugHelpers::AddDebugCollisionShapeLines(Lines, Entry.StopLocation, Entry.CollisionShape, Entry.Rotation, (Entry.bBlockingHit ? BlockedTraceColor : TraceColor), 12, LineLifeTime, SDPG_World);
+		}
+	}
+	LineBatcher->DrawLines(Lines);
+
+	UE_LOG(LogGCQueryVisualizer, Log, TEXT("%s() Drew %d queries."), ANSI_TO_TCHAR(__FUNCTION__), FilteredEntries.Num());
+#endif // ENABLE_DRAW_DEBUG
+}
+
+void FGCQueryVisualizer::VisLogEntries(const UWorld* InWorld, const FGCQueryVisualizerFilter& InFilter)
+{
+#if ENABLE_VISUAL_LOG
+	if (!FVisualLogger::IsRecording())
+	{
+		UE_LOG(LogGCQueryVisualizer, Warning, TEXT("%s() The visual logger isn't recording (start it with \"VisLog\")."), ANSI_TO_TCHAR(__FUNCTION__));
+		return;
+	}
+
+	TArray<FGCQueryVisualizerEntry> FilteredEntries;
+	GetEntries(InFilter, FilteredEntries);
+
+	for (const FGCQueryVisualizerEntry& Entry : FilteredEntries)
+	{
+		UE_VLOG_SEGMENT(InWorld, LogGCQueryVisualizer, Log, Entry.Start, Entry.StopLocation, (Entry.bBlockingHit ? FColor::Red : FColor::Green), TEXT("%s %s (%d entrances, %d exits)"), *Entry.OwnerTag.ToString(), *Entry.TraceTag.ToString(), Entry.NumEntranceHits, Entry.NumExitHits);
+		for (int32 i = 0; i < Entry.NumHitLocations; ++i)
+		{
+			const bool bExitHit = !!(Entry.ExitHitBits & (1u << i));
+			UE_VLOG_LOCATION(InWorld, LogGCQueryVisualizer, Log, Entry.HitLocations[i], 5.f, (bExitHit ? FColor::Magenta : FColor::Orange), TEXT("%s"), (bExitHit ? TEXT("Exit") : TEXT("Entrance")));
+		}
+		if (Entry.bHasBackwardsStart)
+		{
+			UE_VLOG_LOCATION(InWorld, LogGCQueryVisualizer, Log, Entry.BackwardsStart, 5.f, FColor::Cyan, TEXT("Backwards start"));
+		}
+	}
+
+	UE_LOG(LogGCQueryVisualizer, Log, TEXT("%s() Logged %d queries."), ANSI_TO_TCHAR(__FUNCTION__), FilteredEntries.Num());
+#endif // ENABLE_VISUAL_LOG
+}
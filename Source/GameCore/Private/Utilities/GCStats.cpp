@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/GCStats.h"
+
+
+
+DEFINE_STAT(STAT_GCSceneCastMultiWithExitHits)
+DEFINE_STAT(STAT_GCSceneCastMultiWithExitHitsBatch)
+DEFINE_STAT(STAT_GCPenetrationSceneCast)
+DEFINE_STAT(STAT_GCPenetrationSceneCastWithExitHits)
+DEFINE_STAT(STAT_GCForwardsSceneCast)
+DEFINE_STAT(STAT_GCFindExitHits)
+DEFINE_STAT(STAT_GCChangeHitsResponseData)
+DEFINE_STAT(STAT_GCOrderHitsInForwardsDirection)
+DEFINE_STAT(STAT_GCAsyncSceneCastCompletion)
+
+DEFINE_STAT(STAT_GCPenetrationSceneCastWithExitHitsUsingStrength)
+DEFINE_STAT(STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrength)
+DEFINE_STAT(STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch)
+DEFINE_STAT(STAT_GCEvaluateStrength)
+
+DEFINE_STAT(STAT_GCSimulateBallisticProjectiles)
+
+DEFINE_STAT(STAT_GCSceneCastsIssued)
+DEFINE_STAT(STAT_GCBodyQueriesIssued)
+DEFINE_STAT(STAT_GCHitsProcessed)
+DEFINE_STAT(STAT_GCRicochets)
+DEFINE_STAT(STAT_GCBallisticProjectilesSimulated)
+
+
+UE_TRACE_CHANNEL_DEFINE(GameCoreChannel)
+
+LLM_DEFINE_TAG(GameCore);
@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "WorldCollision.h"
+#include "Utilities/GCStats.h"
+#include "Utilities/GCQueryRecorder.h"
 
 #include "GCBlueprintFunctionLibrary_CollisionQueries.generated.h"
 
@@ -25,10 +28,288 @@ struct GAMECORE_API FExitAwareHitResult : public FHitResult
 		, bIsExitHit(false)
 	{
 	}
+	FExitAwareHitResult(const FHitResult& HitResult, const bool bInIsExitHit)
+		: FHitResult(HitResult)
+		, bIsExitHit(bInIsExitHit)
+	{
+	}
+
+	uint8 bIsExitHit : 1;
+
+	/** FHitResult::NetSerialize() plus our exit flag. Without this, we would be replicated property by property like any other struct. */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FExitAwareHitResult> : public TStructOpsTypeTraitsBase2<FExitAwareHitResult>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Tightly packed version of an exit aware hit (with strength info for the strength queries). A fraction of the size of an FHitResult, for when you are going through lots of hits.
+ * Use ToExitAwareHitResult() to expand it into the full hit result only when you need it.
+ */
+USTRUCT()
+struct GAMECORE_API FCompactHitRecord
+{
+	GENERATED_BODY()
+
+	FCompactHitRecord()
+		: Location(FVector::ZeroVector)
+		, Normal(FVector3f::ZeroVector)
+		, Distance(0.f)
+		, Strength(0.f)
+		, Component(nullptr)
+		, BoneName(NAME_None)
+		, FaceIndex(INDEX_NONE)
+		, bBlockingHit(false)
+		, bStartPenetrating(false)
+		, bIsExitHit(false)
+		, bIsRicochet(false)
+	{
+	}
+	FCompactHitRecord(const FHitResult& InHitResult, const bool bInIsExitHit)
+		: Location(InHitResult.Location)
+		, Normal(FVector3f(InHitResult.Normal))
+		, Distance(InHitResult.Distance)
+		, Strength(0.f)
+		, Component(InHitResult.Component)
+		, BoneName(InHitResult.BoneName)
+		, FaceIndex(InHitResult.FaceIndex)
+		, bBlockingHit(InHitResult.bBlockingHit)
+		, bStartPenetrating(InHitResult.bStartPenetrating)
+		, bIsExitHit(bInIsExitHit)
+		, bIsRicochet(false)
+	{
+	}
+	explicit FCompactHitRecord(const FExitAwareHitResult& InHitResult)
+		: FCompactHitRecord(InHitResult, InHitResult.bIsExitHit)
+	{
+	}
 
+	/** Same as FHitResult::Location */
+	FVector Location;
+	/** Same as FHitResult::Normal */
+	FVector3f Normal;
+	/** Same as FHitResult::Distance */
+	float Distance;
+	/** Strength at the location of the hit (strength queries only) */
+	float Strength;
+	TWeakObjectPtr<UPrimitiveComponent> Component;
+	FName BoneName;
+	int32 FaceIndex;
+	uint8 bBlockingHit : 1;
+	uint8 bStartPenetrating : 1;
 	uint8 bIsExitHit : 1;
+	/** We hit a ricochetable surface (strength queries only) */
+	uint8 bIsRicochet : 1;
+
+	/**
+	 * Expands this record into a full hit result for the scene cast that it came from.
+	 * The impact point and impact normal are not stored, so they are given the Location and Normal (which is exact for line traces).
+	 */
+	FExitAwareHitResult ToExitAwareHitResult(const FVector& InTraceStart, const FVector& InTraceEnd) const;
+};
+
+/**
+ * How exit hit queries find their exit hits
+ */
+UENUM()
+enum class EExitHitsMethod : uint8
+{
+	/** A single backwards scene cast through the world from the backwards start to the query start */
+	BackwardsSceneCast,
+	/**
+	 * Each entrance hit's body is queried directly against its own simple collision (a single sphere, box, capsule, or convex) to find its exit, skipping the world's broadphase.
+	 * Bodies with complex or unsupported collision fall back to BackwardsSceneCast. If every body is supported, no backwards scene cast is done, so (like bOptimizeBackwardsSceneCastLength) exits of geometry that the query started inside of won't be found.
+	 */
+	SimpleBodyQueries,
+	/**
+	 * Short backwards scene casts across only the spans of the penetrated geometry (from each entrance to its furthest possible exit, see EFurthestPossibleExitMethod), with overlapping spans grouped into one cast.
+	 * Skips the empty space between the geometry that a single backwards scene cast would go through. Like bOptimizeBackwardsSceneCastLength, exits of geometry that the query started inside of won't be found.
+	 */
+	BoundedBackwardsSceneCasts
+};
+
+/**
+ * How bOptimizeBackwardsSceneCastLength determines the furthest that each entrance hit's geometry could possibly be exited
+ */
+UENUM()
+enum class EFurthestPossibleExitMethod : uint8
+{
+	/** The hit component can extend its bounding sphere diameter past the entrance. Cheap but loose, especially for long thin geometry (e.g. walls and floors). */
+	BoundingSphere,
+	/**
+	 * Where the cast leaves the hit component's oriented local bounds box (or the hit body's bounds for bone hits).
+	 * Much tighter for long thin geometry, at the cost of calculating each hit component's local bounds.
+	 */
+	OrientedBounds
+};
+
+/**
+ * Describes a single SceneCastMultiWithExitHits() query to be performed by SceneCastMultiWithExitHitsBatch()
+ */
+USTRUCT()
+struct GAMECORE_API FSceneCastWithExitHitsQuery
+{
+	GENERATED_BODY()
+
+	FSceneCastWithExitHitsQuery()
+		: Start(FVector::ZeroVector)
+		, End(FVector::ZeroVector)
+		, Rotation(FQuat::Identity)
+		, TraceChannel(ECollisionChannel::ECC_Visibility)
+		, CollisionShape(FCollisionShape())
+		, CollisionQueryParams(FCollisionQueryParams::DefaultQueryParam)
+		, CollisionResponseParams(FCollisionResponseParams::DefaultResponseParam)
+		, bOptimizeBackwardsSceneCastLength(false)
+		, ExitHitsMethod(EExitHitsMethod::BackwardsSceneCast)
+		, FurthestPossibleExitMethod(EFurthestPossibleExitMethod::BoundingSphere)
+	{
+	}
+
+	/** Start location of the scene cast */
+	FVector Start;
+	/** End location of the scene cast */
+	FVector End;
+	/** Rotation of the collision shape (needed for sweeps) */
+	FQuat Rotation;
+	/** The trace channel for this scene cast */
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+	/** Generic collision shape for sweeps/traces (FCollisionShape::LineShape for a line trace) */
+	FCollisionShape CollisionShape;
+	/** Additional parameters used for the scene cast */
+	FCollisionQueryParams CollisionQueryParams;
+	/** List of this scene cast's responses to certain collision channels */
+	FCollisionResponseParams CollisionResponseParams;
+	/** See SceneCastMultiWithExitHits() */
+	uint8 bOptimizeBackwardsSceneCastLength : 1;
+	/** See SceneCastMultiWithExitHits() */
+	EExitHitsMethod ExitHitsMethod;
+	/** See SceneCastMultiWithExitHits() */
+	EFurthestPossibleExitMethod FurthestPossibleExitMethod;
+};
+
+/**
+ * The output of a single query from SceneCastMultiWithExitHitsBatch(). Describes the range of the batch's hits that belong to this query.
+ */
+USTRUCT()
+struct GAMECORE_API FSceneCastWithExitHitsBatchResult
+{
+	GENERATED_BODY()
+
+	FSceneCastWithExitHitsBatchResult()
+		: FirstHitIndex(0)
+		, NumHits(0)
+		, bHitBlockingHit(false)
+	{
+	}
+
+	/** Index into the batch's hits where this query's hits begin */
+	int32 FirstHitIndex;
+	/** Number of hits this query has in the batch's hits */
+	int32 NumHits;
+	/** The return value of SceneCastMultiWithExitHits() for this query */
+	uint8 bHitBlockingHit : 1;
+
+	/** Gets this query's hits out of the batch's hits */
+	TArrayView<const FExitAwareHitResult> GetHits(const TArray<FExitAwareHitResult>& InBatchHits) const
+	{
+		return TArrayView<const FExitAwareHitResult>(InBatchHits.GetData() + FirstHitIndex, NumHits);
+	}
+};
+
+/** Each hit body's (component and bone) response, so that UGCBlueprintFunctionLibrary_CollisionQueries::ChangeHitsResponseData() only resolves it once */
+typedef TMap<TPair<const UPrimitiveComponent*, FName>, ECollisionResponse, TInlineSetAllocator<16>> FHitsResponseCache;
+
+/** The lists used to find the furthest possible exits of a query's entrance hits (see UGCBlueprintFunctionLibrary_CollisionQueries::CalculateFurthestPossibleExitDistances()) */
+struct FFurthestPossibleExitWorkingMemory
+{
+	TArray<float, TInlineAllocator<32>> FurthestPossibleExitDistances;
+	TArray<float, TInlineAllocator<32>> EntranceDistances;
+	/** Bounding sphere distances for when the box test fails */
+	TArray<float, TInlineAllocator<32>> FallbackDistances;
+	TArray<float, TInlineAllocator<32>> SlabOffsets[3];
+	TArray<float, TInlineAllocator<32>> SlabDirs[3];
+	TArray<float, TInlineAllocator<32>> SlabExtents[3];
+};
+
+/**
+ * Reusable memory for the exit hit queries (SceneCastMultiWithExitHits() and PenetrationSceneCastWithExitHits()).
+ * Normally, each of these queries allocates its own temporary hit arrays and copies your FCollisionQueryParams (ignore lists included) for each scene cast it does. Instead, keep a scratch around (e.g. one per weapon) and give it to every query.
+ * Its buffers (the internal lists and the response cache included) keep their memory between queries and its collision params are only built when you call SetCollisionParams().
+ * Once warmed up, a query does no heap allocations (given that you also reuse your OutHits array). The only exception is the physics scene's own query, which is out of our hands.
+ * The GCQueryBenchmark commandlet fails if a query with a warmed up scratch allocates at all.
+ * Not thread safe. Use one scratch per thread.
+ */
+struct GAMECORE_API FExitHitsQueryScratch
+{
+	FExitHitsQueryScratch();
+	FExitHitsQueryScratch(const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams);
+
+	/** Builds all of the collision params used by the queries. Only call this when your params change. */
+	void SetCollisionParams(const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams);
+
+	const FCollisionQueryParams& GetCollisionQueryParams() const { return CollisionQueryParams; }
+	const FCollisionResponseParams& GetCollisionResponseParams() const { return CollisionResponseParams; }
+
+	/** Number of queries that had to grow the buffers. Stops increasing once the scratch is warmed up, which makes it an easy way to verify that your queries are no longer allocating. */
+	int32 GetNumBufferGrowths() const { return NumBufferGrowths; }
+
+private:
+	friend class UGCBlueprintFunctionLibrary_CollisionQueries;
+	friend class UGCBlueprintFunctionLibrary_StrengthCollisionQueries;
+
+	/** Builds only the params that are derived from the caller's. For the non-scratch queries which use the caller's params directly. */
+	void SetDerivedCollisionParams(const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bInForPenetration);
+
+	/** Empties the buffers while keeping their memory */
+	void ResetBuffers();
+	/** Records whether the query that just finished had to grow the buffers */
+	void TrackBufferGrowth();
+	/** Total allocated size of the buffers */
+	SIZE_T GetBufferSize() const;
+
+	/** The caller's params */
+	FCollisionQueryParams CollisionQueryParams;
+	FCollisionResponseParams CollisionResponseParams;
+	/** Params for the backwards scene cast */
+	FCollisionQueryParams BackwardsCollisionQueryParams;
+	/** Params for penetrating through blocking hits (see UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast()) */
+	FCollisionQueryParams PenetrationCollisionQueryParams;
+	FCollisionResponseParams PenetrationCollisionResponseParams;
+	/** Params for the backwards scene cast when penetrating */
+	FCollisionQueryParams PenetrationBackwardsCollisionQueryParams;
+
+	TArray<FHitResult> EntranceHitResults;
+	TArray<FHitResult> ExitHitResults;
+	TArray<FHitResult> SimpleBodyExitHitResults;
+	TArray<FHitResult> SpanExitHitResults;
+	TArray<FHitResult> ChunkHitResults;
+	/** Exits found by querying bodies directly (see FindExitHits()) */
+	TArray<TPair<const UPrimitiveComponent*, FName>, TInlineAllocator<16>> BodiesWithExitsFound;
+	/** Start and end distances of the spans of EExitHitsMethod::BoundedBackwardsSceneCasts */
+	TArray<TPair<float, float>, TInlineAllocator<16>> Spans;
+	FFurthestPossibleExitWorkingMemory FurthestPossibleExitWorkingMemory;
+	FHitsResponseCache ResponseCache;
+
+	/** Where the last query's exit hits looked back from, for the query visualizer */
+	FVector BackwardsStart;
+
+	/** Total allocated size of the buffers at the start of the current query */
+	SIZE_T BufferSize;
+	int32 NumBufferGrowths;
 };
 
+/** Fired when both the forwards and backwards scene casts of an AsyncSceneCastMultiWithExitHits() are done. Same output as SceneCastMultiWithExitHits(). */
+DECLARE_DELEGATE_TwoParams(FOnSceneCastWithExitHitsComplete, const TArray<FExitAwareHitResult>& /*Hits*/, const bool /*bHitBlockingHit*/);
+/** Fired when both the forwards and backwards scene casts of an AsyncPenetrationSceneCastWithExitHits() are done. Same output as PenetrationSceneCastWithExitHits(). */
+DECLARE_DELEGATE_TwoParams(FOnPenetrationSceneCastWithExitHitsComplete, const TArray<FExitAwareHitResult>& /*Hits*/, const FExitAwareHitResult* /*ImpenetrableHit*/);
+
 /**
  *	- Exit hit scene casting -
  *	Exit hits are useful in cases where you need the other side of the geometry that was hit. We achieve this by performing a second scene cast in the opposite direction. This can get expensive as your query length is effectively doubling. To mitigate this, a built-in optimization is provided to minimize the backward query length down to its shortest guaranteed working length.
@@ -51,6 +332,10 @@ public:
 	 * This keeps the scene cast generic to sweeps and linetraces, allowing our custom queries to support both sweeps and linetraces without duplicate code.
 	 */
 	static bool SceneCastMultiByChannel(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam);
+	/**
+	 * Async version of SceneCastMultiByChannel(). Results are given to InDelegate next frame.
+	 */
+	static FTraceHandle AsyncSceneCastMultiByChannel(UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const FTraceDelegate* InDelegate = nullptr);
 
 
 	//  BEGIN Custom query
@@ -59,11 +344,52 @@ public:
 	 * 
 	 * @param  OutHits                              Array of entrance and exit hits (overlap and blocking) that were found until IsHitImpenetrable condition is met
 	 * @param  bOptimizeBackwardsSceneCastLength    Only recommend using this if you're not starting the scene cast inside of geometry, otherwise the exits of any gemometry you're starting inside of may not be found. However, you still could possibly get away with it if you are doing a very lengthy scene cast, because you are more likely to hit an entrance past the exit of the geometry that you started in. If true, will minimize the backwards scene cast length to start no further than the exit of the furthest entrance.
+	 * @param  InExitHitsMethod                     How the exit hits are found. See EExitHitsMethod.
+	 * @param  InFurthestPossibleExitMethod         How bOptimizeBackwardsSceneCastLength finds the furthest possible exit. See EFurthestPossibleExitMethod.
 	 * @return TRUE if hit and stopped at a blocking hit.
 	 */
-	static bool SceneCastMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false);
-	static bool LineTraceMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false);
-	static bool SweepMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false);
+	static bool SceneCastMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false, const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	static bool LineTraceMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false, const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	static bool SweepMultiWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false, const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	/**
+	 * Version of SceneCastMultiWithExitHits() that uses a scratch for its temporary memory and collision params. Once the scratch is warmed up, this does no heap allocations.
+	 * 
+	 * @param  InOutScratch    Provides the collision params (see FExitHitsQueryScratch::SetCollisionParams()) and the reusable buffers
+	 */
+	static bool SceneCastMultiWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false, const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	/** Version of SceneCastMultiWithExitHits() with a scratch that outputs compact hit records instead of full hit results. Each hit is written straight into its record. */
+	static bool SceneCastMultiWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FCompactHitRecord>& OutHitRecords, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const bool bOptimizeBackwardsSceneCastLength = false, const bool bDrawDebugForBackwardsStart = false, const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	//  END Custom query
+
+
+
+	//  BEGIN Custom query
+	/**
+	 * Async version of SceneCastMultiWithExitHits() built on the world's async trace machinery.
+	 * The forwards scene cast is performed next frame and the backwards scene cast is performed the frame after that, at which point InOnComplete is fired (on the game thread).
+	 * Good for non-critical queries (cosmetics, audio, AI) that can afford the latency in exchange for getting off of the game thread.
+	 * 
+	 * @param  InOnComplete    Fired once both the forwards and backwards scene casts are done. If the world goes away in between, it is fired with just the entrance hits.
+	 */
+	static void AsyncSceneCastMultiWithExitHits(UWorld* InWorld, const FOnSceneCastWithExitHitsComplete& InOnComplete, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	static void AsyncLineTraceMultiWithExitHits(UWorld* InWorld, const FOnSceneCastWithExitHitsComplete& InOnComplete, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	static void AsyncSweepMultiWithExitHits(UWorld* InWorld, const FOnSceneCastWithExitHitsComplete& InOnComplete, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const bool bOptimizeBackwardsSceneCastLength = false, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	//  END Custom query
+
+
+
+	//  BEGIN Custom query
+	/**
+	 * Performs many SceneCastMultiWithExitHits() queries at once, spreading them across worker threads.
+	 * Each query's forwards and backwards scene casts run together on the same worker so that no query waits on another. Hits are written contiguously into OutHits and each query is given its range of them in OutResults.
+	 * Since the queries may run off of the game thread, no debug drawing is done for them.
+	 * 
+	 * @param  InQueries      The queries to perform
+	 * @param  OutHits        Hits of every query. Use OutResults to find which hits belong to which query.
+	 * @param  OutResults     One result per query (in the same order as InQueries) describing its range of OutHits
+	 * @param  bInParallel    If false, the queries are performed one after another on the calling thread
+	 */
+	static void SceneCastMultiWithExitHitsBatch(const UWorld* InWorld, const TArray<FSceneCastWithExitHitsQuery>& InQueries, TArray<FExitAwareHitResult>& OutHits, TArray<FSceneCastWithExitHitsBatchResult>& OutResults, const bool bInParallel = true);
 	//  END Custom query
 
 
@@ -89,14 +415,18 @@ public:
 	 *  @param  InCollisionQueryParams       Additional parameters used for the scene cast
 	 *  @param  InCollisionResponseParams    List of this scene cast's responses to certain collision channels
 	 *  @param  IsHitImpenetrable            TFunction where caller indicates whether provided HitResult should stop us. Since we penetrate blocking hits, caller might want to define when to stop.
+	 *  @param  InProgressiveChunkLength     If > 0, scene casts in chunks (starting at this length and doubling each chunk) and stops casting once an impenetrable hit is found, rather than paying for the whole segment. Good for long casts that usually get stopped early.
 	 *  @return The impenetrable hit if we hit one
 	 */
 	static FHitResult* PenetrationSceneCast(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
+		const float InProgressiveChunkLength = 0.f);
 	static FHitResult* PenetrationLineTrace(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
+		const float InProgressiveChunkLength = 0.f);
 	static FHitResult* PenetrationSweep(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
+		const float InProgressiveChunkLength = 0.f);
 	//  END Custom query
 
 
@@ -106,20 +436,77 @@ public:
 	 * Scene cast that also gives us the exit hits using SceneCastMultiWithExitHits() while also providing penetrating functionality
 	 * 
 	 * @param  IsHitImpenetrable         TFunction where caller indicates whether provided HitResult should stop us. Since we penetrate blocking hits, caller might want to define when to stop.
+	 * @param  InExitHitsMethod          How the exit hits are found. See EExitHitsMethod.
+	 * @param  InFurthestPossibleExitMethod    How bOptimizeBackwardsSceneCastLength finds the furthest possible exit. See EFurthestPossibleExitMethod.
+	 * @param  InProgressiveChunkLength        Progressive forwards scene cast. See PenetrationSceneCast().
 	 * @return The impenetrable hit if we hit one (will always be an entrance hit)
 	 */
 	static FExitAwareHitResult* PenetrationSceneCastWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
 		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
 		const bool bOptimizeBackwardsSceneCastLength = false,
-		const bool bDrawDebugForBackwardsStart = false);
+		const bool bDrawDebugForBackwardsStart = false,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
 	static FExitAwareHitResult* PenetrationLineTraceWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
 		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
 		const bool bOptimizeBackwardsSceneCastLength = false,
-		const bool bDrawDebugForBackwardsStart = false);
+		const bool bDrawDebugForBackwardsStart = false,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
 	static FExitAwareHitResult* PenetrationSweepWithExitHits(const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
 		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
 		const bool bOptimizeBackwardsSceneCastLength = false,
-		const bool bDrawDebugForBackwardsStart = false);
+		const bool bDrawDebugForBackwardsStart = false,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+
+	/**
+	 * Version of PenetrationSceneCastWithExitHits() that uses a scratch for its temporary memory and collision params. Once the scratch is warmed up, this does no heap allocations.
+	 * 
+	 * @param  InOutScratch    Provides the collision params (see FExitHitsQueryScratch::SetCollisionParams()) and the reusable buffers
+	 */
+	static FExitAwareHitResult* PenetrationSceneCastWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FExitAwareHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
+		const bool bOptimizeBackwardsSceneCastLength = false,
+		const bool bDrawDebugForBackwardsStart = false,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	/** Version of PenetrationSceneCastWithExitHits() with a scratch that outputs compact hit records instead of full hit results. Each hit is written straight into its record. */
+	static FCompactHitRecord* PenetrationSceneCastWithExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, TArray<FCompactHitRecord>& OutHitRecords, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = DefaultIsHitImpenetrable,
+		const bool bOptimizeBackwardsSceneCastLength = false,
+		const bool bDrawDebugForBackwardsStart = false,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	//  END Custom query
+
+
+
+	//  BEGIN Custom query
+	/**
+	 * Async version of PenetrationSceneCastWithExitHits() built on the world's async trace machinery.
+	 * The forwards scene cast is performed next frame and the backwards scene cast is performed the frame after that, at which point InOnComplete is fired (on the game thread).
+	 * 
+	 * @param  InOnComplete         Fired once both the forwards and backwards scene casts are done. If the world goes away in between, it is fired with just the entrance hits (and the impenetrable hit).
+	 * @param  IsHitImpenetrable    Unlike the sync version, this is a TFunction since it must outlive this call. Unset means nothing is impenetrable.
+	 */
+	static void AsyncPenetrationSceneCastWithExitHits(UWorld* InWorld, const FOnPenetrationSceneCastWithExitHitsComplete& InOnComplete, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		TFunction<bool(const FHitResult&)> IsHitImpenetrable = nullptr,
+		const bool bOptimizeBackwardsSceneCastLength = false,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	static void AsyncPenetrationLineTraceWithExitHits(UWorld* InWorld, const FOnPenetrationSceneCastWithExitHitsComplete& InOnComplete, const FVector& InTraceStart, const FVector& InTraceEnd, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		TFunction<bool(const FHitResult&)> IsHitImpenetrable = nullptr,
+		const bool bOptimizeBackwardsSceneCastLength = false,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
+	static void AsyncPenetrationSweepWithExitHits(UWorld* InWorld, const FOnPenetrationSceneCastWithExitHitsComplete& InOnComplete, const FVector& InSweepStart, const FVector& InSweepEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		TFunction<bool(const FHitResult&)> IsHitImpenetrable = nullptr,
+		const bool bOptimizeBackwardsSceneCastLength = false,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere);
 	//  END Custom query
 
 
@@ -134,29 +521,237 @@ public:
 	static ECollisionResponse GetCollisionResponseForQueryOnBodyInstance(const FBodyInstance& InBodyInstance, const ECollisionChannel InQueryCollisionChannel, const FCollisionResponseParams& InQueryCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam);
 
 private:
+	friend struct FExitHitsQueryScratch;
+	friend class UGCBlueprintFunctionLibrary_StrengthCollisionQueries;
+
+	/**
+	 * Does the work of SceneCastMultiWithExitHits() using the given scratch, leaving the entrance and exit hits in the scratch for the caller to order into its output.
+	 * Takes in the caller's params since the scratch may only have the derived ones.
+	 */
+	static bool SceneCastMultiWithExitHitsInternal(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod);
+	/**
+	 * Does the work of PenetrationSceneCastWithExitHits() using the given scratch, leaving the entrance and exit hits in the scratch for the caller to order into its output.
+	 * Takes in the caller's params since the scratch may only have the derived ones.
+	 * Templated on the IsHitImpenetrable callable (anything callable as bool(const FHitResult&)) so that callers with a compile time policy (e.g. the strength queries) get it inlined instead of going through a TFunctionRef.
+	 * 
+	 * @return The impenetrable entrance hit if we hit one
+	 */
+	template <class ImpenetrableFunctionType>
+	static const FHitResult* PenetrationSceneCastWithExitHitsInternal(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, const float InProgressiveChunkLength);
+
+	/** PenetrationSceneCast() given already made penetration params (see MakePenetrationSceneCastParams()) along with the caller's params */
+	template <class ImpenetrableFunctionType>
+	static FHitResult* PenetrationSceneCastWithPenetrationParams(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InPenetrationCollisionQueryParams, const FCollisionResponseParams& InPenetrationCollisionResponseParams, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, FHitsResponseCache* InOutResponseCache = nullptr);
+
+	/**
+	 * PenetrationSceneCastWithPenetrationParams() done in chunks that grow each time, stopping once an impenetrable hit is found (see InProgressiveChunkLength of PenetrationSceneCast()).
+	 * 
+	 * @param  InOutChunkHitResults    Buffer for each chunk's hits
+	 */
+	template <class ImpenetrableFunctionType>
+	static FHitResult* ProgressivePenetrationSceneCastWithPenetrationParams(const UWorld* InWorld, TArray<FHitResult>& OutHits, TArray<FHitResult>& InOutChunkHitResults, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InPenetrationCollisionQueryParams, const FCollisionResponseParams& InPenetrationCollisionResponseParams, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, const float InInitialChunkLength, FHitsResponseCache* InOutResponseCache = nullptr);
+	/** Removes the hits of a progressive chunk that the previous chunks already found, and makes the rest relative to the whole scene cast */
+	static void PrepareProgressiveChunkHits(TArray<FHitResult>& InOutChunkHitResults, const TArray<FHitResult>& InPreviousHits, const FVector& InStart, const FVector& InEnd, const float InChunkStartDistance, const float InChunkCastStartDistance, const bool bInFirstChunk);
+
+	/** Makes the query and response params that let a scene cast overlap through blocking hits (see PenetrationSceneCast()) */
+	static void MakePenetrationSceneCastParams(FCollisionQueryParams& OutCollisionQueryParams, FCollisionResponseParams& OutCollisionResponseParams, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams);
+	/** Given the hits of a scene cast made with MakePenetrationSceneCastParams(), restore their responses (see ChangeHitsResponseData()) and stop at the first impenetrable hit */
+	template <class ImpenetrableFunctionType>
+	static FHitResult* FinishPenetrationSceneCast(TArray<FHitResult>& InOutHits, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, FHitsResponseCache* InOutResponseCache = nullptr);
+
 	/**
 	 * Modifies existing HitResults to respond appropriately to the caller's ECollisionChannel, FCollisionQueryParams, and FCollisionResponseParams.
 	 * Outputs modified hits and potentially removes some.
+	 * Runs in a single pass and resolves each hit body's response only once, so it stays cheap for the long hit lists of penetration scene casts.
 	 * 
 	 * @param  InOutHits                    Hits to modify
 	 * @param  InTraceChannel               The collision channel in which the hits will conform to (e.g. setting FHitResult::bBlockingHit to true because of the hit component's response to our trace channel)
 	 * @param  InCollisionQueryParams       The collision query params in which the hits will conform to (e.g. removing blocking hits because of FCollisionQueryParams::bIgnoreBlocks)
 	 * @param  InCollisionResponseParams    The trace's response params
+	 * @param  InOutResponseCache           Reusable cache to resolve the responses with (e.g. a scratch's). If null, a temporary one is used.
 	 */
-	static void ChangeHitsResponseData(TArray<FHitResult>& InOutHits, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam);
+	static void ChangeHitsResponseData(TArray<FHitResult>& InOutHits, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, FHitsResponseCache* InOutResponseCache = nullptr);
 
 
-	/** Returns the start point of our backwards scene cast based on information from the forwards cast */
-	static FVector DetermineBackwardsSceneCastStart(const TArray<FHitResult>& InForwardsHitResults, const FVector& InForwardsStart, const FVector& InForwardsEnd, const FHitResult* InHitStoppedAt, const bool bOptimizeBackwardsSceneCastLength, const float InSweepShapeBoundingSphereRadius = 0.f);
+	/**
+	 * Finds the exit hits for the entrance hits (InOutScratch.EntranceHitResults) of an exit hit query's forwards scene cast.
+	 * Outputs them into InOutScratch.ExitHitResults in the order that a backwards scene cast would find them (furthest first) with their data made relative to the forwards scene cast.
+	 * 
+	 * @param  bInPenetrate    Whether blocking hits should be penetrated (for PenetrationSceneCastWithExitHits())
+	 */
+	static void FindExitHits(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FHitResult* InHitStoppedAt, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bInPenetrate, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod);
+
+	/** Whether FindExitHitBySimpleBodyQuery() is able to find the exit of this body */
+	static bool CanFindExitHitBySimpleBodyQuery(const FBodyInstance& InBodyInstance, const bool bInTraceComplex);
+	/**
+	 * Finds the exit of a single body by scene casting against only its own collision, coming from past its furthest possible exit back towards the entrance.
+	 * The outputted exit hit's data is relative to the forwards scene cast.
+	 * 
+	 * @return false if no exit was found
+	 */
+	static bool FindExitHitBySimpleBodyQuery(FHitResult& OutExitHit, const FBodyInstance& InBodyInstance, const FHitResult& InEntranceHit, const FVector& InStart, const FVector& InForwardsDir, const float InForwardsLength, const FQuat& InRotation, const FCollisionShape& InCollisionShape);
+	/**
+	 * Finds the exit hits (for EExitHitsMethod::BoundedBackwardsSceneCasts) by backwards scene casting across only the spans of the penetrated geometry.
+	 * Outputs them into InOutScratch.ExitHitResults in the same order and form as FindExitHits().
+	 */
+	static void FindExitHitsByBoundedBackwardsSceneCasts(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FVector& InBackwardsStart, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionResponseParams& InCollisionResponseParams, const bool bInPenetrate, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod);
+	/** Makes a hit's trace data (TraceStart, TraceEnd, Distance, and Time) relative to the forwards scene cast, given that its location is along it */
+	static void MakeHitDataRelativeToForwardsSceneCast(FHitResult& InOutHitResult, const FVector& InStart, const FVector& InEnd);
+
+	/**
+	 * Returns the start point of our backwards scene cast based on information from the forwards cast
+	 * 
+	 * @param  InOutWorkingMemory    Reusable lists for finding the furthest possible exits (e.g. a scratch's). If null, temporary ones are used.
+	 */
+	static FVector DetermineBackwardsSceneCastStart(const TArray<FHitResult>& InForwardsHitResults, const FVector& InForwardsStart, const FVector& InForwardsEnd, const FHitResult* InHitStoppedAt, const bool bOptimizeBackwardsSceneCastLength, const float InSweepShapeBoundingSphereRadius = 0.f, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere, FFurthestPossibleExitWorkingMemory* InOutWorkingMemory = nullptr);
+	/**
+	 * For each forwards hit, calculates the distance along the forwards scene cast of the furthest location that its geometry could possibly be exited.
+	 * Hits without a component can't be exited past themselves.
+	 * 
+	 * @param  OutFurthestPossibleExitDistances    Must be the same size as InForwardsHitResults
+	 * @param  InOutWorkingMemory                  Reusable lists for the box method. Its FurthestPossibleExitDistances can be the output.
+	 */
+	static void CalculateFurthestPossibleExitDistances(TArrayView<float> OutFurthestPossibleExitDistances, const TArray<FHitResult>& InForwardsHitResults, const FVector& InForwardsStart, const FVector& InForwardsDir, const float InSweepShapeBoundingSphereRadius, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, FFurthestPossibleExitWorkingMemory& InOutWorkingMemory);
 
 	/** Modify data of backwards scene cast to be relevant to the forwards scene cast */
 	static void MakeBackwardsHitsDataRelativeToForwadsSceneCast(TArray<FHitResult>& InOutBackwardsHitResults, const TArray<FHitResult>& InForwardsHitResults);
 
 	/** Given entrance and exit hit results, output a combined array of them in order */
 	static void OrderHitResultsInForwardsDirection(TArray<FExitAwareHitResult>& OutOrderedHitResults, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InForwardsDirection);
+	static void OrderHitResultsInForwardsDirection(TArray<FCompactHitRecord>& OutOrderedHitRecords, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InForwardsDirection);
+	/** Calls InFunction for each hit in forwards order. This is the ordering used by OrderHitResultsInForwardsDirection(). */
+	static void ForEachHitInForwardsDirection(const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InForwardsDirection, const TFunctionRef<void(const FHitResult& /*HitResult*/, const bool /*bIsExitHit*/)>& InFunction);
 
 
 
 	/** Backwards scene cast start location visualization */
 	static void DrawDebugForBackwardsStart(const UWorld* InWorld, const FCollisionShape& InCollisionShape, const FQuat& InRotation, const FVector& InBackwardsStart, const FVector& InBackwardsDir);
 };
+
+
+//  BEGIN Penetration query templates
+template <class ImpenetrableFunctionType>
+const FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHitsInternal(FExitHitsQueryScratch& InOutScratch, const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, const bool bOptimizeBackwardsSceneCastLength, const bool bDrawDebugForBackwardsStart, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, const float InProgressiveChunkLength)
+{
+	GC_QUERY_SCOPE(STAT_GCPenetrationSceneCastWithExitHits);
+
+	InOutScratch.ResetBuffers();
+	TArray<FHitResult>& EntranceHitResults = InOutScratch.EntranceHitResults;
+
+	// Capture this query if we are recording (see FGCQueryRecorder). The replay uses the impenetrable outcomes instead of the game's callback.
+	FGCQueryRecordScope RecordScope = FGCQueryRecordScope(EGCQueryRecordType::PenetrationSceneCastWithExitHits, EntranceHitResults, InOutScratch.ExitHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, bOptimizeBackwardsSceneCastLength, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	const bool bRecording = RecordScope.IsRecording();
+	auto IsHitImpenetrableToUse = [&IsHitImpenetrable, &RecordScope, bRecording](const FHitResult& InHit)
+	{
+		const bool bImpenetrable = IsHitImpenetrable(InHit);
+		if (bRecording)
+		{
+			RecordScope.AddImpenetrableOutcome(bImpenetrable);
+		}
+		return bImpenetrable;
+	};
+
+	const FHitResult* ImpenetrableHit;
+	{
+		GC_QUERY_SCOPE(STAT_GCForwardsSceneCast);
+		if (InProgressiveChunkLength > 0.f)
+		{
+			ImpenetrableHit = ProgressivePenetrationSceneCastWithPenetrationParams(InWorld, EntranceHitResults, InOutScratch.ChunkHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.PenetrationCollisionQueryParams, InOutScratch.PenetrationCollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrableToUse, InProgressiveChunkLength, &InOutScratch.ResponseCache);
+		}
+		else
+		{
+			ImpenetrableHit = PenetrationSceneCastWithPenetrationParams(InWorld, EntranceHitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.PenetrationCollisionQueryParams, InOutScratch.PenetrationCollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrableToUse, &InOutScratch.ResponseCache);
+		}
+	}
+	RecordScope.SetBlockingHit(ImpenetrableHit != nullptr);
+	if (bOptimizeBackwardsSceneCastLength && EntranceHitResults.Num() <= 0)
+	{
+		return nullptr;
+	}
+
+
+	FindExitHits(InOutScratch, InWorld, ImpenetrableHit, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, true, bOptimizeBackwardsSceneCastLength, bDrawDebugForBackwardsStart, InExitHitsMethod, InFurthestPossibleExitMethod);
+	RecordScope.SetBackwardsStart(InOutScratch.BackwardsStart);
+
+	return ImpenetrableHit;
+}
+
+template <class ImpenetrableFunctionType>
+FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithPenetrationParams(const UWorld* InWorld, TArray<FHitResult>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InPenetrationCollisionQueryParams, const FCollisionResponseParams& InPenetrationCollisionResponseParams, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, FHitsResponseCache* InOutResponseCache)
+{
+	SceneCastMultiByChannel(InWorld, OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InPenetrationCollisionQueryParams, InPenetrationCollisionResponseParams);
+	return FinishPenetrationSceneCast(OutHits, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, InOutResponseCache);
+}
+
+template <class ImpenetrableFunctionType>
+FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::ProgressivePenetrationSceneCastWithPenetrationParams(const UWorld* InWorld, TArray<FHitResult>& OutHits, TArray<FHitResult>& InOutChunkHitResults, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InPenetrationCollisionQueryParams, const FCollisionResponseParams& InPenetrationCollisionResponseParams, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, const float InInitialChunkLength, FHitsResponseCache* InOutResponseCache)
+{
+	const FVector ForwardsDir = (InEnd - InStart).GetSafeNormal();
+	const float ForwardsLength = FVector::Distance(InStart, InEnd);
+	if (ForwardsLength <= InInitialChunkLength)
+	{
+		// Only one chunk anyways
+		return PenetrationSceneCastWithPenetrationParams(InWorld, OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InPenetrationCollisionQueryParams, InPenetrationCollisionResponseParams, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, InOutResponseCache);
+	}
+
+	OutHits.Reset();
+
+	float ChunkStartDistance = 0.f;
+	float ChunkLength = InInitialChunkLength;
+	while (ChunkStartDistance < ForwardsLength)
+	{
+		const bool bFirstChunk = (ChunkStartDistance <= 0.f);
+		const float ChunkEndDistance = FMath::Min(ChunkStartDistance + ChunkLength, ForwardsLength);
+
+		// Start each chunk a little before where the previous one ended so that geometry right on the boundary isn't missed
+		const float ChunkCastStartDistance = (bFirstChunk ? 0.f : (ChunkStartDistance - SceneCastStartWallAvoidancePadding));
+		const FVector ChunkStart = InStart + (ForwardsDir * ChunkCastStartDistance);
+		const FVector ChunkEnd = (ChunkEndDistance >= ForwardsLength ? InEnd : (InStart + (ForwardsDir * ChunkEndDistance)));
+
+		InOutChunkHitResults.Reset();
+		SceneCastMultiByChannel(InWorld, InOutChunkHitResults, ChunkStart, ChunkEnd, InRotation, InTraceChannel, InCollisionShape, InPenetrationCollisionQueryParams, InPenetrationCollisionResponseParams);
+		PrepareProgressiveChunkHits(InOutChunkHitResults, OutHits, InStart, InEnd, ChunkStartDistance, ChunkCastStartDistance, bFirstChunk);
+
+		const FHitResult* ImpenetrableChunkHit = FinishPenetrationSceneCast(InOutChunkHitResults, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams, IsHitImpenetrable, InOutResponseCache);
+
+		OutHits.Reserve(OutHits.Num() + InOutChunkHitResults.Num());
+		for (FHitResult& ChunkHit : InOutChunkHitResults)
+		{
+			OutHits.Add(MoveTemp(ChunkHit));
+		}
+
+		if (ImpenetrableChunkHit)
+		{
+			// FinishPenetrationSceneCast() removed everything after the impenetrable hit so it is our last one. No need to cast the rest of the segment.
+			return &OutHits.Last();
+		}
+
+		ChunkStartDistance = ChunkEndDistance;
+		ChunkLength *= 2;
+	}
+
+	return nullptr;
+}
+
+template <class ImpenetrableFunctionType>
+FHitResult* UGCBlueprintFunctionLibrary_CollisionQueries::FinishPenetrationSceneCast(TArray<FHitResult>& InOutHits, const ECollisionChannel InTraceChannel, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const ImpenetrableFunctionType& IsHitImpenetrable, FHitsResponseCache* InOutResponseCache)
+{
+	// Using ECollisionResponse::ECR_Overlap to scene cast was nice since we can get all hits (both overlap and blocking) in the segment without being stopped, but as a result, all of these hits have bBlockingHit as false.
+	// So lets modify these hits to have the correct responses for the caller's Trace Channel and Collision Response Params.
+	ChangeHitsResponseData(InOutHits, InTraceChannel, InCollisionQueryParams, InCollisionResponseParams, InOutResponseCache);
+
+	// Stop at any impenetrable hits
+	for (int32 i = 0; i < InOutHits.Num(); ++i)
+	{
+		if (IsHitImpenetrable(InOutHits[i]))
+		{
+			// Remove the rest if there are any. Keep the memory since this is usually a scratch's buffer.
+			InOutHits.RemoveAt(i + 1, InOutHits.Num() - (i + 1), false);
+			return &InOutHits[i];
+		}
+	}
+
+	// No impenetrable hits stopped us
+	return nullptr;
+}
+//  END Penetration query templates
@@ -5,10 +5,16 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_CollisionQueries.h"
+#include "BlueprintFunctionLibraries/GCBlueprintFunctionLibrary_HitResultHelpers.h"
+#include "Utilities/GCStats.h"
+#include "Async/ParallelFor.h"
 
 #include "GCBlueprintFunctionLibrary_StrengthCollisionQueries.generated.h"
 
 
+class UGCBallisticsMaterialProfile;
+struct FGCRangeFalloffTable;
+
 
 /**
  * Aditional hit info required for strength queries
@@ -34,6 +40,14 @@ struct GAMECORE_API FStrengthHitResult : public FExitAwareHitResult
 		, Strength(0.f)
 	{
 	}
+	FStrengthHitResult(const FHitResult& HitResult, const bool bInIsExitHit)
+		: FExitAwareHitResult(HitResult, bInIsExitHit)
+		, TraveledDistanceBeforeThisTrace(0.f)
+		, RicochetNumber(0)
+		, bIsRicochet(false)
+		, Strength(0.f)
+	{
+	}
 
 	/** Represents the distance the query traveled before getting to this specific trace */
 	float TraveledDistanceBeforeThisTrace;
@@ -49,6 +63,18 @@ struct GAMECORE_API FStrengthHitResult : public FExitAwareHitResult
 	{
 		return TraveledDistanceBeforeThisTrace + Distance;
 	}
+
+	/** FExitAwareHitResult::NetSerialize() plus our strength info. For a whole strength path, FGCNetStrengthHits is much smaller since it quantizes against the query's start. */
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FStrengthHitResult> : public TStructOpsTypeTraitsBase2<FStrengthHitResult>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
 };
 
 /**
@@ -92,6 +118,74 @@ struct GAMECORE_API FStrengthSceneCastInfo
 	float TimeAtStop;
 };
 
+/**
+ * The per cm strength nerfs of the geometry a strength query is currently inside of. Top of the stack is the most recent/inner body being penetrated.
+ * Each nerf is keyed by the body (component and bone) it was entered on, so an exit removes the right nerf even when two bodies share the same nerf value.
+ * A running total is kept so pushing, popping, and getting the total nerf are O(1), and nesting up to NumInlineNerfs deep (e.g. water inside of a building inside of fog) doesn't touch the heap.
+ */
+struct GAMECORE_API FPenetrationNerfStack
+{
+	/** Nerfs we can be inside of before spilling onto the heap */
+	static constexpr int32 NumInlineNerfs = 8;
+
+	FPenetrationNerfStack();
+	/** Starts the stack with a nerf that isn't from any body and is never popped (e.g. a range falloff nerf) */
+	explicit FPenetrationNerfStack(const float InBaseNerf);
+
+	/** Adds the nerf of the body we are entering */
+	void Push(const FHitResult& InEntranceHit, const float InNerf);
+	/**
+	 * Removes the nerf of the body we are exiting. This is the top of the stack unless the bodies overlap without being nested.
+	 * @return False if we never entered this body
+	 */
+	bool Pop(const FHitResult& InExitHit);
+
+	/** The sum of all of our nerfs (including the base nerf) */
+	float GetTotalNerf() const { return TotalNerf; }
+	float GetBaseNerf() const { return BaseNerf; }
+	/** Number of bodies we are inside of */
+	int32 Num() const { return Nerfs.Num(); }
+
+	/** Removes all of the body nerfs, keeping the base nerf */
+	void Reset();
+
+	/**
+	 * Gives a non-linear range falloff to apply on top of our nerfs. Its nerf depends on the distance traveled, which we keep track of as the query nerfs strength.
+	 * The table isn't owned (or serialized) by us so keep it around while we use it.
+	 * @param  InDistanceTraveled    Distance already traveled (e.g. by earlier queries of the same projectile)
+	 */
+	void SetRangeFalloff(const FGCRangeFalloffTable* InRangeFalloff, const float InDistanceTraveled = 0.f);
+	const FGCRangeFalloffTable* GetRangeFalloff() const { return RangeFalloff; }
+	/** The distance traveled as far as the range falloff is concerned */
+	float GetRangeFalloffDistance() const { return RangeFalloffDistance; }
+	void AddRangeFalloffDistance(const float InDistance) { RangeFalloffDistance += InDistance; }
+
+	/**
+	 * Bodies are saved by the path of their component, so they are found again when loaded in the same session or from a level's placed components.
+	 * A body whose component can't be found (e.g. it was destroyed, or spawned on another machine) keeps its nerf until Reset(), since its exit can't be matched to it. Rebuild the stack in that case.
+	 */
+	void Serialize(FArchive& InOutArchive);
+	friend FArchive& operator<<(FArchive& InOutArchive, FPenetrationNerfStack& InOutNerfStack)
+	{
+		InOutNerfStack.Serialize(InOutArchive);
+		return InOutArchive;
+	}
+
+private:
+	struct FBodyNerf
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		FName BoneName;
+		float Nerf;
+	};
+
+	TArray<FBodyNerf, TInlineAllocator<NumInlineNerfs>> Nerfs;
+	float BaseNerf;
+	float TotalNerf;
+	const FGCRangeFalloffTable* RangeFalloff;
+	float RangeFalloffDistance;
+};
+
 /**
  * Struct describing a PenetrationSceneCastWithExitHitsUsingStrength()
  */
@@ -111,6 +205,31 @@ struct GAMECORE_API FPenetrationSceneCastWithExitHitsUsingStrengthResult
 	/** Hit results in this scene cast */
 	TArray<FStrengthHitResult> HitResults;
 };
+/**
+ * Struct describing a PenetrationSceneCastWithExitHitsUsingStrength() that outputs compact hit records
+ */
+USTRUCT()
+struct GAMECORE_API FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult
+{
+	GENERATED_BODY()
+
+	FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult()
+		: StrengthSceneCastInfo(FStrengthSceneCastInfo())
+		, SceneCastEnd(FVector::ZeroVector)
+		, HitRecords(TArray<FCompactHitRecord>())
+	{
+	}
+
+	/** Info about the scene cast that uses strength */
+	FStrengthSceneCastInfo StrengthSceneCastInfo;
+	/** The end location of the scene cast (needed for expanding the hit records) */
+	FVector SceneCastEnd;
+	/** Hit records in this scene cast */
+	TArray<FCompactHitRecord> HitRecords;
+
+	/** Expands one of our hit records into a full strength hit result */
+	FStrengthHitResult ExpandHitRecord(const int32 InIndex) const;
+};
 /**
  * Struct describing a RicochetingPenetrationSceneCastWithExitHitsUsingStrength()
  */
@@ -129,6 +248,309 @@ struct GAMECORE_API FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthRes
 	FStrengthSceneCastInfo StrengthSceneCastInfo;
 	/** Penetration with strength scene casts. The initial and ricochets. */
 	TArray<FPenetrationSceneCastWithExitHitsUsingStrengthResult> PenetrationSceneCastWithExitHitsUsingStrengthResults;
+
+	/** Used by the ricocheting query. Adds a scene cast, giving its info and the hit buffer its hits get appended to. */
+	FStrengthSceneCastInfo& AddSceneCast(TArray<FStrengthHitResult>*& OutHitBuffer)
+	{
+		FPenetrationSceneCastWithExitHitsUsingStrengthResult& SceneCast = PenetrationSceneCastWithExitHitsUsingStrengthResults.AddDefaulted_GetRef();
+		OutHitBuffer = &SceneCast.HitResults;
+		return SceneCast.StrengthSceneCastInfo;
+	}
+	/** Used by the ricocheting query. Gives the hits of the last added scene cast once they have been appended. */
+	TArrayView<FStrengthHitResult> FinishSceneCast()
+	{
+		return PenetrationSceneCastWithExitHitsUsingStrengthResults.Last().HitResults;
+	}
+};
+
+/**
+ * A scene cast of a FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult. Its hits are a range of the result's HitResults.
+ */
+USTRUCT()
+struct GAMECORE_API FFlatStrengthSceneCast
+{
+	GENERATED_BODY()
+
+	FFlatStrengthSceneCast()
+		: StrengthSceneCastInfo(FStrengthSceneCastInfo())
+		, FirstHitIndex(0)
+		, NumHits(0)
+	{
+	}
+
+	/** Info about the scene cast that uses strength */
+	FStrengthSceneCastInfo StrengthSceneCastInfo;
+	/** Index of this scene cast's first hit in the result's HitResults */
+	int32 FirstHitIndex;
+	/** Number of hits in this scene cast */
+	int32 NumHits;
+};
+/**
+ * Struct describing a RicochetingPenetrationSceneCastWithExitHitsUsingStrength(), with the hits of every scene cast in one contiguous buffer.
+ * Unlike FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult, this doesn't allocate a hit array per ricochet. Keep one around and pass it to every query to reuse its memory (the query resets it for you).
+ */
+USTRUCT()
+struct GAMECORE_API FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult
+{
+	GENERATED_BODY()
+
+	FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult()
+		: StrengthSceneCastInfo(FStrengthSceneCastInfo())
+		, SceneCasts(TArray<FFlatStrengthSceneCast>())
+		, HitResults(TArray<FStrengthHitResult>())
+	{
+	}
+
+	/** Info about the scene cast that uses strength */
+	FStrengthSceneCastInfo StrengthSceneCastInfo;
+	/** Penetration with strength scene casts. The initial and ricochets. */
+	TArray<FFlatStrengthSceneCast> SceneCasts;
+	/** Hit results of every scene cast, in order */
+	TArray<FStrengthHitResult> HitResults;
+
+	/** Gets the hits of one of our scene casts */
+	TArrayView<FStrengthHitResult> GetSceneCastHits(const int32 InSceneCastIndex)
+	{
+		const FFlatStrengthSceneCast& SceneCast = SceneCasts[InSceneCastIndex];
+		return TArrayView<FStrengthHitResult>(HitResults.GetData() + SceneCast.FirstHitIndex, SceneCast.NumHits);
+	}
+	TArrayView<const FStrengthHitResult> GetSceneCastHits(const int32 InSceneCastIndex) const
+	{
+		const FFlatStrengthSceneCast& SceneCast = SceneCasts[InSceneCastIndex];
+		return TArrayView<const FStrengthHitResult>(HitResults.GetData() + SceneCast.FirstHitIndex, SceneCast.NumHits);
+	}
+
+	/** Empties this result while keeping its memory for the next query */
+	void Reset()
+	{
+		StrengthSceneCastInfo = FStrengthSceneCastInfo();
+		SceneCasts.Reset();
+		HitResults.Reset();
+	}
+
+	/** Used by the ricocheting query. Adds a scene cast, giving its info and the hit buffer its hits get appended to. */
+	FStrengthSceneCastInfo& AddSceneCast(TArray<FStrengthHitResult>*& OutHitBuffer)
+	{
+		FFlatStrengthSceneCast& SceneCast = SceneCasts.AddDefaulted_GetRef();
+		SceneCast.FirstHitIndex = HitResults.Num();
+		OutHitBuffer = &HitResults;
+		return SceneCast.StrengthSceneCastInfo;
+	}
+	/** Used by the ricocheting query. Gives the hits of the last added scene cast once they have been appended. */
+	TArrayView<FStrengthHitResult> FinishSceneCast()
+	{
+		FFlatStrengthSceneCast& SceneCast = SceneCasts.Last();
+		SceneCast.NumHits = HitResults.Num() - SceneCast.FirstHitIndex;
+		return GetSceneCastHits(SceneCasts.Num() - 1);
+	}
+};
+
+/**
+ * Describes a single RicochetingPenetrationSceneCastWithExitHitsUsingStrength() query to be performed by a ricocheting strength batch
+ */
+USTRUCT()
+struct GAMECORE_API FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery
+{
+	GENERATED_BODY()
+
+	FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery()
+		: InitialStrength(0.f)
+		, RangeFalloffNerf(0.f)
+		, Start(FVector::ZeroVector)
+		, Direction(FVector::ForwardVector)
+		, DistanceCap(0.f)
+		, Rotation(FQuat::Identity)
+		, TraceChannel(ECollisionChannel::ECC_Visibility)
+		, CollisionShape(FCollisionShape())
+		, CollisionQueryParams(FCollisionQueryParams::DefaultQueryParam)
+		, CollisionResponseParams(FCollisionResponseParams::DefaultResponseParam)
+		, RicochetCap(-1)
+		, ExitHitsMethod(EExitHitsMethod::BackwardsSceneCast)
+		, FurthestPossibleExitMethod(EFurthestPossibleExitMethod::BoundingSphere)
+		, ProgressiveChunkLength(0.f)
+	{
+	}
+
+	/** Initial strength of the scene cast */
+	float InitialStrength;
+	/** Per cm strength nerf that is always applied (the base of the query's nerf stack) */
+	float RangeFalloffNerf;
+	/** Start location of the scene cast */
+	FVector Start;
+	/** The direction to scene cast */
+	FVector Direction;
+	/** The max distance to travel */
+	float DistanceCap;
+	/** Rotation of the collision shape (needed for sweeps) */
+	FQuat Rotation;
+	/** The trace channel for this scene cast */
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+	/** Generic collision shape for sweeps/traces (FCollisionShape::LineShape for a line trace) */
+	FCollisionShape CollisionShape;
+	/** Additional parameters used for the scene cast */
+	FCollisionQueryParams CollisionQueryParams;
+	/** List of this scene cast's responses to certain collision channels */
+	FCollisionResponseParams CollisionResponseParams;
+	/** Max number of ricochets (negative for no cap) */
+	int32 RicochetCap;
+	/** See UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits() */
+	EExitHitsMethod ExitHitsMethod;
+	/** See UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits() */
+	EFurthestPossibleExitMethod FurthestPossibleExitMethod;
+	/** See UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast() */
+	float ProgressiveChunkLength;
+};
+
+/**
+ * Where a ricocheting strength query is at between its scene casts
+ */
+struct FRicochetingStrengthSceneCastState
+{
+	FRicochetingStrengthSceneCastState()
+		: SceneCastStart(FVector::ZeroVector)
+		, SceneCastDirection(FVector::ForwardVector)
+		, DistanceTraveled(0.f)
+		, Strength(0.f)
+		, RicochetNumber(0)
+		, LastSceneCastStopLocation(FVector::ZeroVector)
+	{
+	}
+	FRicochetingStrengthSceneCastState(const FVector& InStart, const FVector& InDirection, const float InInitialStrength)
+		: SceneCastStart(InStart)
+		, SceneCastDirection(InDirection)
+		, DistanceTraveled(0.f)
+		, Strength(InInitialStrength)
+		, RicochetNumber(0)
+		, LastSceneCastStopLocation(InStart)
+	{
+	}
+
+	/** Where the next scene cast starts */
+	FVector SceneCastStart;
+	/** Direction of the next scene cast */
+	FVector SceneCastDirection;
+	/** Distance traveled by the scene casts so far */
+	float DistanceTraveled;
+	/** Strength at the start of the next scene cast */
+	float Strength;
+	/** Ricochets before the next scene cast */
+	int32 RicochetNumber;
+	/** Stop location of the latest scene cast (the query's start until the first one). A copy rather than a pointer into the result, so that the state stays valid when the result's scene casts grow or the result is reset. */
+	FVector LastSceneCastStopLocation;
+};
+
+/**
+ * Memory of a ricocheting strength batch (see PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch()) to keep between batches, e.g. one per frame's worth of grenade fragments.
+ * Its arrays and each query's scratch keep their memory, so once they have grown to the size of your batches, setting up and doing a batch allocates nothing of its own.
+ * Only give it to one batch at a time.
+ */
+struct GAMECORE_API FRicochetingStrengthBatchContext
+{
+	/** Where each query is at between its scene casts */
+	TArray<FRicochetingStrengthSceneCastState> States;
+	/** The per cm nerfs of the geometry each query is inside of */
+	TArray<FPenetrationNerfStack> PerCmStrengthNerfStacks;
+	/** The queries that still have scene casts to do */
+	TArray<int32> ActiveQueryIndices;
+	/** Whether each active query has another scene cast to do after this generation */
+	TArray<bool> ShouldContinue;
+	/** One per query, with the query's collision params. A query's scene casts are all done by whichever worker picks it up, so the scratch is never shared between threads. */
+	TArray<FExitHitsQueryScratch> Scratches;
+};
+
+/**
+ * The in-flight state of a ricocheting strength query that is done a bit at a time (e.g. a slow projectile that travels some distance each tick).
+ * Give it to AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength() to continue the query from where it left off instead of recasting it from its start.
+ */
+USTRUCT()
+struct GAMECORE_API FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor
+{
+	GENERATED_BODY()
+
+	FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor();
+	FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor(const float InInitialStrength, const float InRangeFalloffNerf, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const int32 InRicochetCap = -1);
+
+	/** Where the query began */
+	FVector StartLocation;
+	/** The direction the query began in */
+	FVector StartDirection;
+	/** The strength the query began with */
+	float StartStrength;
+	/** The max distance to travel */
+	float DistanceCap;
+	/** Max number of ricochets (negative for no cap) */
+	int32 RicochetCap;
+	/** Where the query is at */
+	FRicochetingStrengthSceneCastState State;
+	/** The per cm nerfs of the geometry we are currently inside of */
+	FPenetrationNerfStack PerCmNerfStack;
+	/** We ran out of strength, distance, or ricochets */
+	bool bFinished;
+
+	/** Distance left before the DistanceCap */
+	float GetRemainingDistance() const { return FMath::Max(DistanceCap - State.DistanceTraveled, 0.f); }
+	/** Distance to advance by for a time budget, given the speed (cm per second) we travel at */
+	static float GetDistanceForTime(const float InDeltaSeconds, const float InSpeed) { return FMath::Max(InDeltaSeconds * InSpeed, 0.f); }
+
+	bool Serialize(FArchive& InOutArchive);
+
+	/** Checks that random queries in this world split into two half advances (with the cursor saved and loaded in between, like a projectile replicated or saved mid flight) give the same hits and final strength as one whole advance. Logs an error for each one that doesn't. */
+	static void RunSplitCheck(const TArray<FString>& InArgs, UWorld* InWorld);
+};
+
+template <>
+struct TStructOpsTypeTraits<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor> : public TStructOpsTypeTraitsBase2<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor>
+{
+	enum
+	{
+		WithSerializer = true
+	};
+};
+
+/**
+ * Policies for the policy versions of the strength queries (e.g. UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PolicyPenetrationSceneCastWithExitHitsUsingStrength()).
+ * They are the compile time alternative to the TFunctionRef callbacks. A policy is any type with the members below (one type can be all three kinds):
+ *
+ *	Penetration nerf policy:    static constexpr bool bHasPenetrationNerf;    float GetPerCmPenetrationNerf(const FHitResult&) const;
+ *	Impenetrable policy:        static constexpr bool bCanBeImpenetrable;     bool IsHitImpenetrable(const FHitResult&) const;
+ *	Ricochet policy:            static constexpr bool bCanRicochet;           float GetRicochetNerf(const FHitResult&) const;    bool IsHitRicochetable(const FHitResult&) const;
+ *
+ * Setting a flag to false compiles out the code that would call that policy's functions.
+ */
+struct FGCNoPenetrationNerfPolicy
+{
+	static constexpr bool bHasPenetrationNerf = false;
+	float GetPerCmPenetrationNerf(const FHitResult& InHit) const { return 0.f; }
+};
+struct FGCNeverImpenetrablePolicy
+{
+	static constexpr bool bCanBeImpenetrable = false;
+	bool IsHitImpenetrable(const FHitResult& InHit) const { return false; }
+};
+struct FGCNoRicochetPolicy
+{
+	static constexpr bool bCanRicochet = false;
+	float GetRicochetNerf(const FHitResult& InHit) const { return 0.f; }
+	bool IsHitRicochetable(const FHitResult& InHit) const { return false; }
+};
+
+/**
+ * Impenetrable policy that stops at the ricochet policy's ricochetable hits. Used for the penetration scene casts of the ricocheting queries.
+ */
+template <class TRicochetPolicy>
+struct TGCRicochetableIsImpenetrablePolicy
+{
+	static constexpr bool bCanBeImpenetrable = TRicochetPolicy::bCanRicochet;
+
+	explicit TGCRicochetableIsImpenetrablePolicy(const TRicochetPolicy& InRicochetPolicy)
+		: RicochetPolicy(InRicochetPolicy)
+	{
+	}
+
+	bool IsHitImpenetrable(const FHitResult& InHit) const { return RicochetPolicy.IsHitRicochetable(InHit); }
+
+private:
+	const TRicochetPolicy& RicochetPolicy;
 };
 
 /**
@@ -153,7 +575,7 @@ public:
 	 * Given an initial strength, perform a scene cast, applying strength nerfs to the query as it penetrates through blocking hits.
 	 *
 	 * @param  InInitialStrength              Initial strength of the scene cast.
-	 * @param  InOutPerCmNerfStack            Stack of values that nerf the query's strength per cm. Top of stack represents the most recent nerf (in penetration terminology, the most recent/inner object currently being penetrated).
+	 * @param  InOutPerCmNerfStack            Stack of values that nerf the query's strength per cm. Top of stack represents the most recent nerf (in penetration terminology, the most recent/inner object currently being penetrated). If it has bodies on it (e.g. continuing a projectile that stopped inside of a wall), the query starts inside of them and does a full length backwards scene cast to find their exits. See FPenetrationNerfStack.
 	 * @param  InWorld                        The world to scene cast in
 	 * @param  OutResult                      Struct that fully describes this query
 	 * @param  InStart                        Start location of the scene cast
@@ -164,14 +586,64 @@ public:
 	 * @param  InCollisionQueryParams         Additional parameters used for the scene cast
 	 * @param  GetPerCmPenetrationNerf        TFunction where caller indicates a per cm strength nerf to apply when entering geometry given a hit
 	 * @param  IsHitImpenetrable              TFunction where caller indicates whether provided HitResult should stop us
+	 * @param  InExitHitsMethod               How the exit hits are found (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InFurthestPossibleExitMethod   How far the geometry could possibly be exited (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InProgressiveChunkLength       If > 0, scene casts in chunks and stops once an impenetrable hit is found (see UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast())
 	 * @return The impenetrable hit if we hit one
 	 */
-	static FStrengthHitResult* PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, TArray<float>& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+	static FStrengthHitResult* PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
 		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
 	static FStrengthHitResult* PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
 		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	/** Version of PenetrationSceneCastWithExitHitsUsingStrength() that outputs compact hit records instead of full strength hit results */
+	static FCompactHitRecord* PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+
+	/**
+	 * Versions of PenetrationSceneCastWithExitHitsUsingStrength() that use a scratch for their temporary memory and collision params (see FExitHitsQueryScratch).
+	 * The hits are written straight from the scratch into OutResult, so once the scratch and OutResult are warmed up these do no heap allocations.
+	 * 
+	 * @param  InOutScratch    Provides the collision params (see FExitHitsQueryScratch::SetCollisionParams()) and the reusable buffers
+	 */
+	static FStrengthHitResult* PenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	static FCompactHitRecord* PenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitImpenetrable = UGCBlueprintFunctionLibrary_CollisionQueries::DefaultIsHitImpenetrable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+
+	/**
+	 * Versions of PenetrationSceneCastWithExitHitsUsingStrength() that get the penetration nerfs and impenetrable surfaces from a ballistics material profile instead of callbacks.
+	 * Set bReturnPhysicalMaterial in your InCollisionQueryParams, otherwise we have to copy them to set it ourselves.
+	 * 
+	 * @param  InMaterialProfile    Penetration values for each physical surface type
+	 */
+	static FStrengthHitResult* PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	static FCompactHitRecord* PenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
 	//  END Custom query
 
 
@@ -185,18 +657,682 @@ public:
 	 * @param  InDistanceCap              The max distance to travel (performance wise, length of the cast will be this large and get smaller as we travel from ricochets)
 	 * @param  GetRicochetNerf            TFunction where caller indicates strength nerf to apply when hitting a ricochetable hit
 	 * @param  IsHitRicochetable          TFunction where caller indicates whether we should ricochet off of the HitResult
+	 * @param  InExitHitsMethod           How the exit hits are found (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InFurthestPossibleExitMethod How far the geometry could possibly be exited (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InProgressiveChunkLength   If > 0, scene casts in chunks and stops once an impenetrable hit is found (see UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast())
 	 */
-	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, TArray<float>& InOutPerCmNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
 		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
 		const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf = DefaultGetRicochetNerf,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
 	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
 		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
 		const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf = DefaultGetRicochetNerf,
-		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable);
+		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+
+	/**
+	 * Version of RicochetingPenetrationSceneCastWithExitHitsUsingStrength() that gets the penetration nerfs, ricochet nerfs, and ricochetable surfaces from a ballistics material profile instead of callbacks.
+	 * Set bReturnPhysicalMaterial in your InCollisionQueryParams, otherwise we have to copy them to set it ourselves.
+	 * 
+	 * @param  InMaterialProfile    Penetration and ricochet values for each physical surface type
+	 */
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+
+	/**
+	 * Versions of RicochetingPenetrationSceneCastWithExitHitsUsingStrength() that output every hit into one contiguous buffer. OutResult is reset first, keeping its memory.
+	 * See FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult.
+	 */
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
+		const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf = DefaultGetRicochetNerf,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, const float InRangeFalloffNerf, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
+		const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf = DefaultGetRicochetNerf,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	//  END Custom query
+
+
+	//  BEGIN Custom query
+	/**
+	 * PenetrationSceneCastWithExitHitsUsingStrength() with compile time policies instead of TFunctionRef callbacks (see FGCNoPenetrationNerfPolicy for what a policy is).
+	 * The policies' functions get inlined into the query, and the paths of policies that never nerf or are never impenetrable are compiled out.
+	 * 
+	 * @param  InPenetrationNerfPolicy    Gives the per cm strength nerf to apply when entering geometry
+	 * @param  InImpenetrablePolicy       Decides whether a hit should stop us
+	 * @param  InExitHitsMethod           How the exit hits are found (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InFurthestPossibleExitMethod How far the geometry could possibly be exited (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InProgressiveChunkLength   If > 0, scene casts in chunks and stops once an impenetrable hit is found (see UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast())
+	 */
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TImpenetrablePolicy = FGCNeverImpenetrablePolicy>
+	static FStrengthHitResult* PolicyPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TImpenetrablePolicy& InImpenetrablePolicy = TImpenetrablePolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InPenetrationNerfPolicy, InImpenetrablePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TImpenetrablePolicy = FGCNeverImpenetrablePolicy>
+	static FCompactHitRecord* PolicyPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TImpenetrablePolicy& InImpenetrablePolicy = TImpenetrablePolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		OutResult.SceneCastEnd = InEnd;
+		return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitRecords, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InPenetrationNerfPolicy, InImpenetrablePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	/** Scratch versions of PolicyPenetrationSceneCastWithExitHitsUsingStrength(). Once the scratch and OutResult are warmed up, these do no heap allocations. */
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TImpenetrablePolicy = FGCNeverImpenetrablePolicy>
+	static FStrengthHitResult* PolicyPenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TImpenetrablePolicy& InImpenetrablePolicy = TImpenetrablePolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InOutScratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitResults, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.GetCollisionQueryParams(), InOutScratch.GetCollisionResponseParams(), InPenetrationNerfPolicy, InImpenetrablePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TImpenetrablePolicy = FGCNeverImpenetrablePolicy>
+	static FCompactHitRecord* PolicyPenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FCompactPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TImpenetrablePolicy& InImpenetrablePolicy = TImpenetrablePolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		OutResult.SceneCastEnd = InEnd;
+		return PenetrationSceneCastWithExitHitsUsingStrengthInternal(InOutScratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult.StrengthSceneCastInfo, OutResult.HitRecords, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InOutScratch.GetCollisionQueryParams(), InOutScratch.GetCollisionResponseParams(), InPenetrationNerfPolicy, InImpenetrablePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+
+	/**
+	 * RicochetingPenetrationSceneCastWithExitHitsUsingStrength() with compile time policies instead of TFunctionRef callbacks (see FGCNoPenetrationNerfPolicy for what a policy is).
+	 * With FGCNoRicochetPolicy, this is a single penetration scene cast that never stops at a hit.
+	 * 
+	 * @param  InPenetrationNerfPolicy    Gives the per cm strength nerf to apply when entering geometry
+	 * @param  InRicochetPolicy           Decides whether we ricochet off of a hit and the strength nerf for doing so
+	 * @param  InExitHitsMethod           How the exit hits are found (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InFurthestPossibleExitMethod How far the geometry could possibly be exited (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits())
+	 * @param  InProgressiveChunkLength   If > 0, scene casts in chunks and stops once an impenetrable hit is found (see UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast())
+	 */
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TRicochetPolicy = FGCNoRicochetPolicy>
+	static void PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TRicochetPolicy& InRicochetPolicy = TRicochetPolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, InPenetrationNerfPolicy, InRicochetPolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TRicochetPolicy = FGCNoRicochetPolicy>
+	static void PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam, const int32 InRicochetCap = -1,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TRicochetPolicy& InRicochetPolicy = TRicochetPolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		OutResult.Reset();
+		RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, InPenetrationNerfPolicy, InRicochetPolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	/** Scratch version of the flat PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength(). Every scene cast of the query uses the scratch, so once it and OutResult are warmed up, this does no heap allocations of its own. */
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TRicochetPolicy = FGCNoRicochetPolicy>
+	static void PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const int32 InRicochetCap = -1,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TRicochetPolicy& InRicochetPolicy = TRicochetPolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f)
+	{
+		OutResult.Reset();
+		RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(InOutScratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InOutScratch.GetCollisionQueryParams(), InOutScratch.GetCollisionResponseParams(), InRicochetCap, InPenetrationNerfPolicy, InRicochetPolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	//  END Custom query
+
+
+	//  BEGIN Custom query
+	/**
+	 * Performs many RicochetingPenetrationSceneCastWithExitHitsUsingStrength() queries at once (e.g. the fragments of a grenade), spreading them across worker threads.
+	 * The queries are advanced together one scene cast at a time: every query's initial scene cast is done as one parallel batch, then every query that ricocheted does its next scene cast as the next batch, and so on until no query has anything left to do.
+	 * Since the queries may run off of the game thread, the policies must be thread safe.
+	 * 
+	 * @param  InOutContext               The batch's memory. Keep it around (along with OutResults) between batches so that they don't allocate.
+	 * @param  InQueries                  The queries to perform
+	 * @param  OutResults                 One result per query (in the same order as InQueries). Reuse this array between batches to reuse its memory.
+	 * @param  bInParallel                If false, the queries are performed on the calling thread
+	 * @param  InPenetrationNerfPolicy    Gives the per cm strength nerf to apply when entering geometry
+	 * @param  InRicochetPolicy           Decides whether we ricochet off of a hit and the strength nerf for doing so
+	 */
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TRicochetPolicy = FGCNoRicochetPolicy>
+	static void PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(FRicochetingStrengthBatchContext& InOutContext, const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel = true,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TRicochetPolicy& InRicochetPolicy = TRicochetPolicy());
+	/** PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch() with a context of its own, for one-off batches */
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TRicochetPolicy = FGCNoRicochetPolicy>
+	static void PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel = true,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TRicochetPolicy& InRicochetPolicy = TRicochetPolicy())
+	{
+		FRicochetingStrengthBatchContext Context;
+		PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(Context, InWorld, InQueries, OutResults, bInParallel, InPenetrationNerfPolicy, InRicochetPolicy);
+	}
+	/**
+	 * Versions of PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch() that get the penetration nerfs, ricochet nerfs, and ricochetable surfaces from a ballistics material profile.
+	 * Set bReturnPhysicalMaterial in your queries' CollisionQueryParams, otherwise we have to copy the queries to set it ourselves.
+	 */
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(FRicochetingStrengthBatchContext& InOutContext, const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, const UGCBallisticsMaterialProfile& InMaterialProfile, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel = true);
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, const UGCBallisticsMaterialProfile& InMaterialProfile, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel = true);
+	//  END Custom query
+
+
+	//  BEGIN Custom query
+	/**
+	 * Continues the ricocheting strength query of InOutCursor for up to InDistance, as RicochetingPenetrationSceneCastWithExitHitsUsingStrength() would have.
+	 * Its scene casts and hits are appended to InOutResult (reset it yourself if you only want the hits of this advance), and InOutResult's StrengthSceneCastInfo is updated to describe the query so far.
+	 * For a time budget, use FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor::GetDistanceForTime().
+	 * An advance that ends inside of geometry keeps that geometry's nerf on the cursor's stack, and the next advance does a full length backwards scene cast to find its exit. Splitting a query into advances gives the same hits and strength as doing it in one.
+	 * 
+	 * @param  InOutCursor    The query to continue. Flagged bFinished once the query is done.
+	 * @param  InDistance     Max distance to travel during this advance
+	 * @return The distance traveled during this advance
+	 */
+	static float AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor& InOutCursor, const float InDistance, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InOutResult, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const TFunctionRef<float(const FHitResult&)>& GetPerCmPenetrationNerf = DefaultGetPerCmPenetrationNerf,
+		const TFunctionRef<float(const FHitResult&)>& GetRicochetNerf = DefaultGetRicochetNerf,
+		const TFunctionRef<bool(const FHitResult&)>& IsHitRicochetable = DefaultIsHitRicochetable,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	static float AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor& InOutCursor, const float InDistance, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InOutResult, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const UGCBallisticsMaterialProfile& InMaterialProfile, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
+	template <class TPenetrationNerfPolicy = FGCNoPenetrationNerfPolicy, class TRicochetPolicy = FGCNoRicochetPolicy>
+	static float PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor& InOutCursor, const float InDistance, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InOutResult, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams = FCollisionQueryParams::DefaultQueryParam, const FCollisionResponseParams& InCollisionResponseParams = FCollisionResponseParams::DefaultResponseParam,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy = TPenetrationNerfPolicy(),
+		const TRicochetPolicy& InRicochetPolicy = TRicochetPolicy(),
+		const EExitHitsMethod InExitHitsMethod = EExitHitsMethod::BackwardsSceneCast,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod = EFurthestPossibleExitMethod::BoundingSphere,
+		const float InProgressiveChunkLength = 0.f);
 	//  END Custom query
 
 
 private:
+	/**
+	 * Does the work of PenetrationSceneCastWithExitHitsUsingStrength() for any output hit type (FStrengthHitResult or FCompactHitRecord) and policies (see FGCNoPenetrationNerfPolicy).
+	 * HitType needs to be constructible from an FHitResult and whether it is an exit hit, and have Strength.
+	 * Every version of the query goes through this (the callback versions use policies that call the callbacks). The hits are walked in the scratch and only the ones we get to are written to OutHits.
+	 * Takes in the caller's params since the scratch may only have the derived ones.
+	 */
+	template <class HitType, class TPenetrationNerfPolicy, class TImpenetrablePolicy>
+	static HitType* PenetrationSceneCastWithExitHitsUsingStrengthInternal(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FStrengthSceneCastInfo& OutStrengthSceneCastInfo, TArray<HitType>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+		const TImpenetrablePolicy& InImpenetrablePolicy,
+		const EExitHitsMethod InExitHitsMethod,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+		const float InProgressiveChunkLength);
+	/** PenetrationSceneCastWithExitHitsUsingStrengthInternal() with a scratch of its own, for the versions of the query that aren't given one */
+	template <class HitType, class TPenetrationNerfPolicy, class TImpenetrablePolicy>
+	static HitType* PenetrationSceneCastWithExitHitsUsingStrengthInternal(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FStrengthSceneCastInfo& OutStrengthSceneCastInfo, TArray<HitType>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+		const TImpenetrablePolicy& InImpenetrablePolicy,
+		const EExitHitsMethod InExitHitsMethod,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+		const float InProgressiveChunkLength)
+	{
+		FExitHitsQueryScratch Scratch;
+		Scratch.SetDerivedCollisionParams(InCollisionQueryParams, InCollisionResponseParams, true);
+		return PenetrationSceneCastWithExitHitsUsingStrengthInternal(Scratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutStrengthSceneCastInfo, OutHits, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InPenetrationNerfPolicy, InImpenetrablePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	/**
+	 * Does the work of RicochetingPenetrationSceneCastWithExitHitsUsingStrength() for any result type and policies.
+	 * RicochetResultType needs StrengthSceneCastInfo, AddSceneCast(), and FinishSceneCast() (see FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult).
+	 */
+	template <class RicochetResultType, class TPenetrationNerfPolicy, class TRicochetPolicy>
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, RicochetResultType& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+		const TRicochetPolicy& InRicochetPolicy,
+		const EExitHitsMethod InExitHitsMethod,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+		const float InProgressiveChunkLength);
+	/** RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal() with a scratch of its own, shared by all of the query's scene casts */
+	template <class RicochetResultType, class TPenetrationNerfPolicy, class TRicochetPolicy>
+	static void RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, RicochetResultType& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+		const TRicochetPolicy& InRicochetPolicy,
+		const EExitHitsMethod InExitHitsMethod,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+		const float InProgressiveChunkLength)
+	{
+		FExitHitsQueryScratch Scratch;
+		Scratch.SetDerivedCollisionParams(InCollisionQueryParams, InCollisionResponseParams, true);
+		RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(Scratch, InInitialStrength, InOutPerCmNerfStack, InWorld, OutResult, InStart, InDirection, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InRicochetCap, InPenetrationNerfPolicy, InRicochetPolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	/** Fills out the start of a ricocheting query's info and gives the state for its first scene cast */
+	static FRicochetingStrengthSceneCastState BeginRicochetingPenetrationSceneCast(FStrengthSceneCastInfo& OutStrengthSceneCastInfo, const float InInitialStrength, const FVector& InStart, const FVector& InDirection, const FQuat& InRotation, const FCollisionShape& InCollisionShape);
+	/**
+	 * Does one scene cast (the initial or a ricochet) of a ricocheting query and sets up InOutState for the next one.
+	 * InOutScratch needs the derived params of InCollisionQueryParams and InCollisionResponseParams.
+	 * @return False if the query is done
+	 */
+	template <class RicochetResultType, class TPenetrationNerfPolicy, class TRicochetPolicy>
+	static bool RicochetingPenetrationSceneCastStep(FExitHitsQueryScratch& InOutScratch, FRicochetingStrengthSceneCastState& InOutState, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, RicochetResultType& OutResult, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+		const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+		const TRicochetPolicy& InRicochetPolicy,
+		const EExitHitsMethod InExitHitsMethod,
+		const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+		const float InProgressiveChunkLength);
+	/** Fills out the stop of a ricocheting query's info once it is done */
+	static void FinishRicochetingPenetrationSceneCast(const FRicochetingStrengthSceneCastState& InState, FStrengthSceneCastInfo& OutStrengthSceneCastInfo, const float InDistanceCap);
+
+	/** Logging for the templates above (our log category isn't available to the modules that compile them) */
+	static void LogStartedInsideOfGeometry(const TCHAR* InFunctionName, const FHitResult& InHit);
+	static void LogExitedBodyNeverEntered(const TCHAR* InFunctionName, const FHitResult& InHit);
+
+	/** Surface lookups need physical materials on the hits. Returns the given params if they already return them, otherwise a copy (in OutCopy) that does. */
+	static const FCollisionQueryParams& GetQueryParamsReturningPhysicalMaterial(const FCollisionQueryParams& InCollisionQueryParams, FCollisionQueryParams& OutCopy);
+
 	static float NerfStrengthPerCm(float& InOutStrength, const float InDistanceToTravel, const float InNerfPerCm);
+	/** NerfStrengthPerCm() with the total nerf of InOutPerCmNerfStack, plus its range falloff if it has one */
+	static float NerfStrength(float& InOutStrength, const float InDistanceToTravel, FPenetrationNerfStack& InOutPerCmNerfStack);
 };
+
+
+//  BEGIN Strength query templates
+template <class RicochetResultType, class TPenetrationNerfPolicy, class TRicochetPolicy>
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastWithExitHitsUsingStrengthInternal(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmStrengthNerfStack, const UWorld* InWorld, RicochetResultType& OutResult, const FVector& InStart, const FVector& InDirection, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const int32 InRicochetCap,
+	const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+	const TRicochetPolicy& InRicochetPolicy,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	GC_QUERY_SCOPE(STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrength);
+
+	if (InDistanceCap <= 0.f)
+	{
+		check(0);
+		return;
+	}
+
+	FRicochetingStrengthSceneCastState State = BeginRicochetingPenetrationSceneCast(OutResult.StrengthSceneCastInfo, InInitialStrength, InStart, InDirection, InRotation, InCollisionShape);
+
+	// The first iteration of this loop is the initial scene cast and the rest of the iterations are ricochet scene casts
+	while (State.RicochetNumber <= InRicochetCap || InRicochetCap < 0)
+	{
+		if (!RicochetingPenetrationSceneCastStep(InOutScratch, State, InOutPerCmStrengthNerfStack, InWorld, OutResult, InDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InPenetrationNerfPolicy, InRicochetPolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength))
+		{
+			break;
+		}
+	}
+
+	FinishRicochetingPenetrationSceneCast(State, OutResult.StrengthSceneCastInfo, InDistanceCap);
+}
+
+template <class RicochetResultType, class TPenetrationNerfPolicy, class TRicochetPolicy>
+bool UGCBlueprintFunctionLibrary_StrengthCollisionQueries::RicochetingPenetrationSceneCastStep(FExitHitsQueryScratch& InOutScratch, FRicochetingStrengthSceneCastState& InOutState, FPenetrationNerfStack& InOutPerCmStrengthNerfStack, const UWorld* InWorld, RicochetResultType& OutResult, const float InDistanceCap, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+	const TRicochetPolicy& InRicochetPolicy,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	// Our penetration scene casts stop at ricochetable hits
+	const TGCRicochetableIsImpenetrablePolicy<TRicochetPolicy> RicochetableIsImpenetrablePolicy = TGCRicochetableIsImpenetrablePolicy<TRicochetPolicy>(InRicochetPolicy);
+
+	const FVector SceneCastEnd = InOutState.SceneCastStart + (InOutState.SceneCastDirection * (InDistanceCap - InOutState.DistanceTraveled));
+
+	TArray<FStrengthHitResult>* SceneCastHitBuffer;
+	FStrengthSceneCastInfo& SceneCastInfo = OutResult.AddSceneCast(SceneCastHitBuffer);
+	FStrengthHitResult* RicochetableHit = PenetrationSceneCastWithExitHitsUsingStrengthInternal(InOutScratch, InOutState.Strength, InOutPerCmStrengthNerfStack, InWorld, SceneCastInfo, *SceneCastHitBuffer, InOutState.SceneCastStart, SceneCastEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InPenetrationNerfPolicy, RicochetableIsImpenetrablePolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	const TArrayView<FStrengthHitResult> SceneCastHits = OutResult.FinishSceneCast();
+
+	InOutState.DistanceTraveled += SceneCastInfo.DistanceToStop;
+	InOutState.Strength = SceneCastInfo.StopStrength;
+	InOutState.LastSceneCastStopLocation = SceneCastInfo.StopLocation;
+
+	// Set more strength hit result data
+	{
+		// Give data to our strength hits for this scene cast
+		for (FStrengthHitResult& StrengthHit : SceneCastHits)
+		{
+			StrengthHit.RicochetNumber = InOutState.RicochetNumber;
+			StrengthHit.TraveledDistanceBeforeThisTrace = (InOutState.DistanceTraveled - SceneCastInfo.DistanceToStop); // distance up until this scene cast
+		}
+
+		// Give data to the ricochet hit
+		if (RicochetableHit)
+		{
+			RicochetableHit->bIsRicochet = true;
+			INC_DWORD_STAT(STAT_GCRicochets);
+		}
+	}
+
+	// Apply ricochet strength nerf
+	if (RicochetableHit)
+	{
+		InOutState.Strength -= InRicochetPolicy.GetRicochetNerf(*RicochetableHit);
+	}
+
+	// Check if we should end here
+	{
+		// Stop if not enough strength for next cast
+		if (InOutState.Strength <= 0.f)
+		{
+			InOutState.Strength = 0.f;
+			return false;
+		}
+
+		// Stop if there was nothing to ricochet off of
+		if (!RicochetableHit)
+		{
+			SceneCastInfo.StopLocation = SceneCastEnd;
+			InOutState.SceneCastStart = SceneCastEnd; // in case we are continued later (see AdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength())
+			return false;
+		}
+	}
+
+
+	// SETUP FOR OUR NEXT SCENE CAST
+	// Next ricochet cast needs a new direction and start location
+	InOutState.SceneCastDirection = InOutState.SceneCastDirection.MirrorByVector(RicochetableHit->ImpactNormal);
+	InOutState.SceneCastStart = RicochetableHit->Location + (InOutState.SceneCastDirection * UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastStartWallAvoidancePadding);
+	++InOutState.RicochetNumber;
+
+	if (InOutState.DistanceTraveled == InDistanceCap)
+	{
+		// Edge case: we should end the whole thing if we ran out of distance exactly when we hit a ricochet
+		SceneCastInfo.StopLocation = RicochetableHit->Location;
+		return false;
+	}
+
+	return true;
+}
+
+template <class TPenetrationNerfPolicy, class TRicochetPolicy>
+void UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PolicyRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch(FRicochetingStrengthBatchContext& InOutContext, const UWorld* InWorld, const TArray<FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery>& InQueries, TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult>& OutResults, const bool bInParallel,
+	const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+	const TRicochetPolicy& InRicochetPolicy)
+{
+	GC_QUERY_SCOPE(STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch);
+
+	OutResults.SetNum(InQueries.Num()); // keep the results we already have so their memory gets reused
+
+	// Reset() and SetNum() keep the context's memory from the previous batches
+	TArray<FRicochetingStrengthSceneCastState>& States = InOutContext.States;
+	TArray<FPenetrationNerfStack>& PerCmStrengthNerfStacks = InOutContext.PerCmStrengthNerfStacks;
+	TArray<int32>& ActiveQueryIndices = InOutContext.ActiveQueryIndices;
+	TArray<FExitHitsQueryScratch>& Scratches = InOutContext.Scratches;
+	States.Reset(InQueries.Num());
+	PerCmStrengthNerfStacks.Reset(InQueries.Num());
+	ActiveQueryIndices.Reset(InQueries.Num());
+	Scratches.SetNum(InQueries.Num(), false);
+
+	for (int32 QueryIndex = 0; QueryIndex < InQueries.Num(); ++QueryIndex)
+	{
+		const FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery& Query = InQueries[QueryIndex];
+		FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& Result = OutResults[QueryIndex];
+
+		Result.Reset();
+		States.Add(BeginRicochetingPenetrationSceneCast(Result.StrengthSceneCastInfo, Query.InitialStrength, Query.Start, Query.Direction, Query.Rotation, Query.CollisionShape));
+		PerCmStrengthNerfStacks.Emplace(Query.RangeFalloffNerf);
+
+		if (Query.DistanceCap > 0.f)
+		{
+			// Built once per query rather than once per scene cast
+			Scratches[QueryIndex].SetDerivedCollisionParams(Query.CollisionQueryParams, Query.CollisionResponseParams, true);
+			ActiveQueryIndices.Add(QueryIndex);
+		}
+	}
+
+	// Advance every query by one scene cast per generation. The first generation is the initial scene casts and the rest are ricochet scene casts.
+	TArray<bool>& ShouldContinue = InOutContext.ShouldContinue;
+	ShouldContinue.SetNumUninitialized(ActiveQueryIndices.Num(), false);
+	while (ActiveQueryIndices.Num() > 0)
+	{
+		// Every query only touches its own state, nerf stack, scratch, and result so they can be worked on side by side
+		ParallelFor(ActiveQueryIndices.Num(), [&](int32 ActiveIndex)
+			{
+				const int32 QueryIndex = ActiveQueryIndices[ActiveIndex];
+				const FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthQuery& Query = InQueries[QueryIndex];
+				FRicochetingStrengthSceneCastState& State = States[QueryIndex];
+
+				const bool bCanRicochet = RicochetingPenetrationSceneCastStep(Scratches[QueryIndex], State, PerCmStrengthNerfStacks[QueryIndex], InWorld, OutResults[QueryIndex], Query.DistanceCap, Query.Rotation, Query.TraceChannel, Query.CollisionShape, Query.CollisionQueryParams, Query.CollisionResponseParams, InPenetrationNerfPolicy, InRicochetPolicy, Query.ExitHitsMethod, Query.FurthestPossibleExitMethod, Query.ProgressiveChunkLength);
+				ShouldContinue[ActiveIndex] = bCanRicochet && (State.RicochetNumber <= Query.RicochetCap || Query.RicochetCap < 0);
+			},
+			(bInParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread));
+
+		// Compact out the queries that stopped so the next generation only has queries with work left
+		int32 NumActive = 0;
+		for (int32 ActiveIndex = 0; ActiveIndex < ActiveQueryIndices.Num(); ++ActiveIndex)
+		{
+			if (ShouldContinue[ActiveIndex])
+			{
+				ActiveQueryIndices[NumActive] = ActiveQueryIndices[ActiveIndex];
+				++NumActive;
+			}
+		}
+		ActiveQueryIndices.SetNum(NumActive, false);
+	}
+
+	for (int32 QueryIndex = 0; QueryIndex < InQueries.Num(); ++QueryIndex)
+	{
+		FinishRicochetingPenetrationSceneCast(States[QueryIndex], OutResults[QueryIndex].StrengthSceneCastInfo, InQueries[QueryIndex].DistanceCap);
+	}
+}
+
+template <class TPenetrationNerfPolicy, class TRicochetPolicy>
+float UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PolicyAdvanceRicochetingPenetrationSceneCastWithExitHitsUsingStrength(FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthCursor& InOutCursor, const float InDistance, const UWorld* InWorld, FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InOutResult, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+	const TRicochetPolicy& InRicochetPolicy,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	GC_QUERY_SCOPE(STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrength);
+
+	if (InOutCursor.bFinished || InDistance <= 0.f)
+	{
+		return 0.f;
+	}
+
+	FRicochetingStrengthSceneCastState& State = InOutCursor.State;
+	const float DistanceTraveledBefore = State.DistanceTraveled;
+
+	// Pretending that the query ends at the end of our budget lets the ricocheting steps stop there for us
+	const float BudgetDistanceCap = FMath::Min(State.DistanceTraveled + InDistance, InOutCursor.DistanceCap);
+
+	// Shared by every scene cast of this advance
+	FExitHitsQueryScratch Scratch;
+	Scratch.SetDerivedCollisionParams(InCollisionQueryParams, InCollisionResponseParams, true);
+
+	while (State.RicochetNumber <= InOutCursor.RicochetCap || InOutCursor.RicochetCap < 0)
+	{
+		if (!RicochetingPenetrationSceneCastStep(Scratch, State, InOutCursor.PerCmNerfStack, InWorld, InOutResult, BudgetDistanceCap, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, InPenetrationNerfPolicy, InRicochetPolicy, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength))
+		{
+			break;
+		}
+	}
+
+	// See if the whole query is done or just this advance
+	const bool bOutOfStrength = (State.Strength <= 0.f);
+	const bool bOutOfDistance = (State.DistanceTraveled >= InOutCursor.DistanceCap - KINDA_SMALL_NUMBER);
+	const bool bOutOfRicochets = (InOutCursor.RicochetCap >= 0 && State.RicochetNumber > InOutCursor.RicochetCap);
+	InOutCursor.bFinished = (bOutOfStrength || bOutOfDistance || bOutOfRicochets);
+
+	// Describe the query so far
+	InOutResult.StrengthSceneCastInfo.CollisionShapeCasted = InCollisionShape;
+	InOutResult.StrengthSceneCastInfo.CollisionShapeCastedRotation = InRotation;
+	InOutResult.StrengthSceneCastInfo.StartLocation = InOutCursor.StartLocation;
+	InOutResult.StrengthSceneCastInfo.StartStrength = InOutCursor.StartStrength;
+	InOutResult.StrengthSceneCastInfo.CastDirection = InOutCursor.StartDirection;
+	FinishRicochetingPenetrationSceneCast(State, InOutResult.StrengthSceneCastInfo, InOutCursor.DistanceCap);
+
+	return State.DistanceTraveled - DistanceTraveledBefore;
+}
+
+template <class HitType, class TPenetrationNerfPolicy, class TImpenetrablePolicy>
+HitType* UGCBlueprintFunctionLibrary_StrengthCollisionQueries::PenetrationSceneCastWithExitHitsUsingStrengthInternal(FExitHitsQueryScratch& InOutScratch, const float InInitialStrength, FPenetrationNerfStack& InOutPerCmNerfStack, const UWorld* InWorld, FStrengthSceneCastInfo& OutStrengthSceneCastInfo, TArray<HitType>& OutHits, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams,
+	const TPenetrationNerfPolicy& InPenetrationNerfPolicy,
+	const TImpenetrablePolicy& InImpenetrablePolicy,
+	const EExitHitsMethod InExitHitsMethod,
+	const EFurthestPossibleExitMethod InFurthestPossibleExitMethod,
+	const float InProgressiveChunkLength)
+{
+	GC_QUERY_SCOPE(STAT_GCPenetrationSceneCastWithExitHitsUsingStrength);
+
+	OutStrengthSceneCastInfo.CollisionShapeCasted = InCollisionShape;
+	OutStrengthSceneCastInfo.CollisionShapeCastedRotation = InRotation;
+	OutStrengthSceneCastInfo.StartLocation = InStart;
+	OutStrengthSceneCastInfo.StartStrength = InInitialStrength;
+	OutStrengthSceneCastInfo.CastDirection = (InEnd - InStart).GetSafeNormal();
+
+	// The optimized backwards scene cast doesn't reach the exits of bodies that we start inside of. We are inside of the bodies on our nerf stack (e.g. an advance or projectile tick that ended inside of a wall), so their exits have to be found to pop their nerfs.
+	const bool bOptimizeBackwardsSceneCastLength = (InOutPerCmNerfStack.Num() <= 0);
+
+	const FHitResult* ImpenetrableHit;
+	if constexpr (TImpenetrablePolicy::bCanBeImpenetrable)
+	{
+		ImpenetrableHit = UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHitsInternal(InOutScratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, [&InImpenetrablePolicy](const FHitResult& InHit) { return InImpenetrablePolicy.IsHitImpenetrable(InHit); }, bOptimizeBackwardsSceneCastLength, false, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	else
+	{
+		ImpenetrableHit = UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCastWithExitHitsInternal(InOutScratch, InWorld, InStart, InEnd, InRotation, InTraceChannel, InCollisionShape, InCollisionQueryParams, InCollisionResponseParams, [](const FHitResult&) { return false; }, bOptimizeBackwardsSceneCastLength, false, InExitHitsMethod, InFurthestPossibleExitMethod, InProgressiveChunkLength);
+	}
+	InOutScratch.TrackBufferGrowth();
+
+	// Everything from here on is walking the hits and nerfing our strength
+	GC_QUERY_SCOPE(STAT_GCEvaluateStrength);
+
+	const TArray<FHitResult>& EntranceHitResults = InOutScratch.EntranceHitResults;
+	const TArray<FHitResult>& ExitHitResults = InOutScratch.ExitHitResults;
+	const FVector SceneCastDirection = (InEnd - InStart).GetSafeNormal();
+
+	// Every hit's trace data is that of the forwards scene cast, so any of them gives its length
+	const FHitResult* AnyHitResult = (EntranceHitResults.Num() > 0 ? &EntranceHitResults[0] : (ExitHitResults.Num() > 0 ? &ExitHitResults[0] : nullptr));
+	const float SceneCastDistance = AnyHitResult ? UGCBlueprintFunctionLibrary_HitResultHelpers::CheapCalculateTraceLength(*AnyHitResult) : FVector::Distance(InStart, InEnd);
+
+	float CurrentStrength = InInitialStrength;
+	float SegmentStartDistance = 0.f;
+
+	// Applies the strength nerfs for the segment from the last hit (or TraceStart) to InSegmentEndDistance. If we ran out of strength in it, gives the stop location and returns false.
+	auto NerfSegment = [&](const float InSegmentEndDistance) -> bool
+	{
+		const float TraveledThroughDistance = NerfStrength(CurrentStrength, InSegmentEndDistance - SegmentStartDistance, InOutPerCmNerfStack);
+		if (CurrentStrength < 0.f)
+		{
+			const float DistanceToStop = SegmentStartDistance + TraveledThroughDistance;
+			OutStrengthSceneCastInfo.StopLocation = InStart + (SceneCastDirection * DistanceToStop);
+			OutStrengthSceneCastInfo.TimeAtStop = DistanceToStop / SceneCastDistance;
+			OutStrengthSceneCastInfo.DistanceToStop = DistanceToStop;
+			OutStrengthSceneCastInfo.StopStrength = 0.f;
+			return false;
+		}
+
+		SegmentStartDistance = InSegmentEndDistance;
+		return true;
+	};
+
+	// Add the hits we get to, in the order that we get to them
+	bool bStopped = false;
+	HitType* ImpenetrableStrengthHit = nullptr;
+	OutHits.Reserve(OutHits.Num() + EntranceHitResults.Num() + ExitHitResults.Num()); // assume that we will add all of the hits. But, there may end up being reserved space that goes unused if we run out of strength
+	UGCBlueprintFunctionLibrary_CollisionQueries::ForEachHitInForwardsDirection(EntranceHitResults, ExitHitResults, SceneCastDirection, [&](const FHitResult& InHitResult, const bool bInIsExitHit)
+		{
+			if (bStopped)
+			{
+				return;
+			}
+
+			// If we ran out of strength before getting to this hit, stop adding further hits
+			if (!NerfSegment(InHitResult.Distance))
+			{
+				bStopped = true;
+				return;
+			}
+
+			HitType& AddedStrengthHit = OutHits.Emplace_GetRef(InHitResult, bInIsExitHit);
+			AddedStrengthHit.Strength = CurrentStrength;
+
+			if (InHitResult.bStartPenetrating)
+			{
+				// Initial overlaps would mess up our PerCmStrengthNerfStack so skip it
+				// Btw this is only a thing for simple collision queries
+				LogStartedInsideOfGeometry(ANSI_TO_TCHAR(__FUNCTION__), InHitResult);
+				return;
+			}
+
+			if constexpr (TImpenetrablePolicy::bCanBeImpenetrable)
+			{
+				if (&InHitResult == ImpenetrableHit)
+				{
+					// Stop - don't calculate penetration nerfing on impenetrable hit
+					OutStrengthSceneCastInfo.StopLocation = InHitResult.Location;
+					OutStrengthSceneCastInfo.TimeAtStop = InHitResult.Time;
+					OutStrengthSceneCastInfo.DistanceToStop = InHitResult.Distance;
+					OutStrengthSceneCastInfo.StopStrength = FMath::Max(CurrentStrength, 0.f);
+					ImpenetrableStrengthHit = &AddedStrengthHit; // we reserved, so adding hits didn't move it
+					bStopped = true;
+					return;
+				}
+			}
+
+			// Update the InOutPerCmNerfStack with this hit
+			if constexpr (TPenetrationNerfPolicy::bHasPenetrationNerf)
+			{
+				if (bInIsExitHit == false)		// Add new nerf if we are entering something
+				{
+					InOutPerCmNerfStack.Push(InHitResult, InPenetrationNerfPolicy.GetPerCmPenetrationNerf(InHitResult));
+				}
+				else							// Remove the nerf of the body we are exiting
+				{
+					if (!InOutPerCmNerfStack.Pop(InHitResult))
+					{
+						LogExitedBodyNeverEntered(ANSI_TO_TCHAR(__FUNCTION__), InHitResult);
+					}
+				}
+			}
+		});
+
+	if (bStopped)
+	{
+		return ImpenetrableStrengthHit;
+	}
+
+	// For the segment from the last hit to trace end, apply strength nerfs and see if we ran out
+	if (!NerfSegment(SceneCastDistance))
+	{
+		return nullptr;
+	}
+
+	// CurrentStrength made it past every nerf
+	OutStrengthSceneCastInfo.StopLocation = InEnd;
+	OutStrengthSceneCastInfo.TimeAtStop = 1.f;
+	OutStrengthSceneCastInfo.DistanceToStop = SceneCastDistance;
+	OutStrengthSceneCastInfo.StopStrength = CurrentStrength;
+	return nullptr;
+}
+//  END Strength query templates
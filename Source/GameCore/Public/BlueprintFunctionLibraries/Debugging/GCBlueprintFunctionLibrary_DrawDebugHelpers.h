@@ -7,6 +7,8 @@
 #include "GCBlueprintFunctionLibrary_DrawDebugHelpers.generated.h"
 
 
+class ULineBatchComponent;
+struct FBatchedLine;
 
 /**
  * 
@@ -21,4 +23,20 @@ public:
 	static void DrawDebugCollisionShape(const UWorld* InWorld, const FVector& InCenter, const FCollisionShape& InCollisionShape, const FQuat& InRotation, const FColor& InColor, const int32 InSegments = 16, const bool bInPersistentLines = false, const float InLifeTime = -1.f, const uint8 InDepthPriority = 0, const float InThickness = 0.f);
 
 	static void DrawDebugLineDotted(const UWorld* InWorld, const FVector& InStart, const FVector& InEnd, const FColor& InColor, const bool bInPersistentLines = false, const float InLifeTime = -1.f, const uint8 InDepthPriority = 0, const float InThickness = 0.f, const float InSegmentsLength = 10.f, const float InSegmentsSpacingLength = 10.f);
+
+	/**
+	 * Adds the lines of DrawDebugCollisionShape() to a batch (see GetDebugLineBatcher()) instead of drawing them, for drawing many shapes at once.
+	 * The shapes are transformed copies of unit shapes that are made once per segment count. Lines have no lines to add. Game thread only, like the line batchers.
+	 */
+	static void AddDebugCollisionShapeLines(TArray<FBatchedLine>& InOutLines, const FVector& InCenter, const FCollisionShape& InCollisionShape, const FQuat& InRotation, const FLinearColor& InColor, const int32 InSegments = 16, const float InLineLifeTime = -1.f, const uint8 InDepthPriority = 0, const float InThickness = 0.f);
+	/** Adds the lines of DrawDebugLineDotted() to a batch (see GetDebugLineBatcher()) instead of drawing them */
+	static void AddDebugLineDottedLines(TArray<FBatchedLine>& InOutLines, const FVector& InStart, const FVector& InEnd, const FLinearColor& InColor, const float InLineLifeTime = -1.f, const uint8 InDepthPriority = 0, const float InThickness = 0.f, const float InSegmentsLength = 10.f, const float InSegmentsSpacingLength = 10.f);
+
+	/**
+	 * The line batcher that DrawDebugLine() would use for these arguments, for submitting many lines at once with ULineBatchComponent::DrawLines().
+	 * Null when there is nothing to draw to (e.g. on a dedicated server).
+	 */
+	static ULineBatchComponent* GetDebugLineBatcher(const UWorld* InWorld, const bool bInPersistentLines = false, const float InLifeTime = -1.f, const uint8 InDepthPriority = 0);
+	/** The life time that DrawDebugLine() would give its lines in this line batcher */
+	static float GetDebugLineLifeTime(const ULineBatchComponent& InLineBatcher, const bool bInPersistentLines = false, const float InLifeTime = -1.f);
 };
@@ -10,6 +10,7 @@
 
 struct FPenetrationSceneCastWithExitHitsUsingStrengthResult;
 struct FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult;
+struct FBatchedLine;
 
 
 
@@ -38,5 +39,7 @@ public:
 	static void DrawCollisionShapeDebug(const UWorld* InWorld, const FRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const bool bInPersistentLines = false, const float InLifeTime = -1.f, const uint8 InDepthPriority = 0, const float InThickness = 0.f, const FLinearColor& InFullStrengthColor = FLinearColor::Green, const FLinearColor& InNoStrengthColor = FLinearColor::Red);
 
 private:
+	/** Adds the lines of DrawStrengthDebugLine() for this scene cast in a single pass over its segments and hits */
+	static void AddStrengthDebugLines(TArray<FBatchedLine>& InOutLines, const FPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult, const float InInitialStrength, const float InLineLifeTime, const uint8 InDepthPriority, const float InThickness, const float InSegmentsLength, const float InSegmentsSpacingLength, const FLinearColor& InFullStrengthColor, const FLinearColor& InNoStrengthColor);
 	static FLinearColor GetDebugColorForStrength(const float InStrength, const float InInitialStrength, const FLinearColor& InFullStrengthColor = FLinearColor::Green, const FLinearColor& InNoStrengthColor = FLinearColor::Red);
 };
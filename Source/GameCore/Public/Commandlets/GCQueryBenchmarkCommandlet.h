@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "GCQueryBenchmarkCommandlet.generated.h"
+
+
+
+/**
+ * Benchmarks every query of our collision query libraries, and a tick of the ballistic projectile subsystem, against procedurally generated stress worlds, so it needs no content and runs headless (-nullrhi).
+ * The worlds are parallel walls, nested volumes, a foliage style field of overlapping shapes, and a crowd of characters made of body shapes.
+ * SceneCastMultiWithExitHitsBatch() is also swept over thread counts (1, 2, 4, ... up to every worker) to show how it scales.
+ * Writes each query's throughput, latency percentiles, and warmed up heap allocations per query (counted on every thread) to a JSON file.
+ * Fails (returns 1) when a query with a warmed up scratch allocates at all, or when given a baseline JSON file that a query's throughput has regressed from by more than the tolerance, or that it allocates more than.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=GCQueryBenchmark -nullrhi [-Output=<Results.json>] [-Baseline=<Baseline.json>] [-Tolerance=10 (percent)] [-Scale=1 (scene size)] [-Rays=1000] [-Iterations=3] [-Seed=1] [-Scene=<Only this scene>] [-Query=<Only queries containing this>]
+ */
+UCLASS()
+class GAMECORE_API UGCQueryBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGCQueryBenchmarkCommandlet();
+
+	//  BEGIN UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//  END UCommandlet interface
+};
@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "GCQueryReplayCommandlet.generated.h"
+
+
+
+/**
+ * Replays a query recording (see FGCQueryRecorder) against its map, and reports the throughput, latency percentiles, and any queries whose results differ from the recording.
+ * Good for reproducing a server's real query load locally, and for checking optimizations for regressions.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=GCQueryReplay -File=<Recording.gcqr> [-Map=<Map package, defaults to the recorded one>] [-Iterations=1] [-MaxDiffsToLog=10] [-FailOnDiffs]
+ */
+UCLASS()
+class GAMECORE_API UGCQueryReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGCQueryReplayCommandlet();
+
+	//  BEGIN UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//  END UCommandlet interface
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+#include "GCBallisticsMaterialProfile.generated.h"
+
+
+
+/**
+ * How a strength query treats one surface type
+ */
+USTRUCT(BlueprintType)
+struct GAMECORE_API FGCBallisticsSurfaceProperties
+{
+	GENERATED_BODY()
+
+	FGCBallisticsSurfaceProperties()
+		: PerCmPenetrationNerf(0.f)
+		, RicochetNerf(0.f)
+		, bImpenetrable(false)
+		, bRicochetable(false)
+	{
+	}
+
+	/** Strength taken away for every cm traveled inside of this surface */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ballistics", meta = (ClampMin = "0"))
+		float PerCmPenetrationNerf;
+	/** Strength taken away when ricocheting off of this surface */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ballistics", meta = (ClampMin = "0"))
+		float RicochetNerf;
+	/** Stops penetration queries */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ballistics")
+		uint8 bImpenetrable : 1;
+	/** Ricocheting queries bounce off of this surface */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ballistics")
+		uint8 bRicochetable : 1;
+};
+
+/**
+ * Designer tunable penetration and ricochet values for each physical surface type. Give this to the strength queries instead of the per hit callbacks.
+ * Lookups are a flat array index by the hit's EPhysicalSurface (no callbacks or maps). Hits without a physical material use SurfaceType_Default.
+ */
+UCLASS(BlueprintType)
+class GAMECORE_API UGCBallisticsMaterialProfile : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	const FGCBallisticsSurfaceProperties& GetSurfaceProperties(const EPhysicalSurface InSurfaceType) const
+	{
+		return SurfaceProperties[InSurfaceType];
+	}
+	/** Properties of the hit's surface. The query needs FCollisionQueryParams::bReturnPhysicalMaterial for the hit to have a physical material. */
+	const FGCBallisticsSurfaceProperties& GetSurfaceProperties(const FHitResult& InHit) const
+	{
+		const UPhysicalMaterial* PhysicalMaterial = InHit.PhysMaterial.Get();
+		return SurfaceProperties[PhysicalMaterial ? PhysicalMaterial->SurfaceType.GetValue() : SurfaceType_Default];
+	}
+
+protected:
+	/** Properties of each surface type (named in Project Settings > Physics > Physical Surface) */
+	UPROPERTY(EditDefaultsOnly, Category = "Ballistics", meta = (ArraySizeEnum = "EPhysicalSurface"))
+		FGCBallisticsSurfaceProperties SurfaceProperties[SurfaceType_Max];
+};
+
+/**
+ * Strength query policy that reads everything from a ballistics material profile (see FGCNoPenetrationNerfPolicy for what a policy is).
+ * Give it as the penetration nerf, impenetrable, and ricochet policy.
+ */
+struct FGCBallisticsMaterialProfilePolicy
+{
+	static constexpr bool bHasPenetrationNerf = true;
+	static constexpr bool bCanBeImpenetrable = true;
+	static constexpr bool bCanRicochet = true;
+
+	explicit FGCBallisticsMaterialProfilePolicy(const UGCBallisticsMaterialProfile& InMaterialProfile)
+		: MaterialProfile(InMaterialProfile)
+	{
+	}
+
+	float GetPerCmPenetrationNerf(const FHitResult& InHit) const { return MaterialProfile.GetSurfaceProperties(InHit).PerCmPenetrationNerf; }
+	bool IsHitImpenetrable(const FHitResult& InHit) const { return MaterialProfile.GetSurfaceProperties(InHit).bImpenetrable; }
+	float GetRicochetNerf(const FHitResult& InHit) const { return MaterialProfile.GetSurfaceProperties(InHit).RicochetNerf; }
+	bool IsHitRicochetable(const FHitResult& InHit) const { return MaterialProfile.GetSurfaceProperties(InHit).bRicochetable; }
+
+private:
+	const UGCBallisticsMaterialProfile& MaterialProfile;
+};
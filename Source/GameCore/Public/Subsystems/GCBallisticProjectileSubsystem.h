@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_StrengthCollisionQueries.h"
+
+#include "GCBallisticProjectileSubsystem.generated.h"
+
+
+class UGCBallisticsMaterialProfile;
+
+
+
+/**
+ * Describes a projectile to fire with UGCBallisticProjectileSubsystem::FireProjectile()
+ */
+USTRUCT(BlueprintType)
+struct GAMECORE_API FGCBallisticProjectileParams
+{
+	GENERATED_BODY()
+
+	FGCBallisticProjectileParams()
+		: Location(FVector::ZeroVector)
+		, Velocity(FVector::ZeroVector)
+		, Strength(0.f)
+		, DragCoefficient(0.f)
+		, GravityScale(1.f)
+		, RangeFalloffNerf(0.f)
+		, RicochetCap(-1)
+		, Lifetime(10.f)
+		, IgnoredActor(nullptr)
+	{
+	}
+
+	/** Where the projectile is fired from */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics")
+		FVector Location;
+	/** Muzzle velocity (cm per second) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics")
+		FVector Velocity;
+	/** Strength at the muzzle velocity. As the projectile slows down its strength goes down with its kinetic energy. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics")
+		float Strength;
+	/** Deceleration per cm per second of speed, applied against the velocity (quadratic drag) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics", meta = (ClampMin = "0"))
+		float DragCoefficient;
+	/** Multiplier for the world's gravity */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics")
+		float GravityScale;
+	/** Per cm strength nerf that is always applied (the base of the projectile's nerf stack) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics", meta = (ClampMin = "0"))
+		float RangeFalloffNerf;
+	/** Max number of ricochets (negative for no cap) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics", meta = (ClampMin = "-1"))
+		int32 RicochetCap;
+	/** Seconds until the projectile is removed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics", meta = (ClampMin = "0"))
+		float Lifetime;
+	/** Actor for the projectile's scene casts to ignore (e.g. whoever fired it) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ballistics")
+		AActor* IgnoredActor;
+};
+
+/**
+ * Projectiles stored as a structure of arrays (every array has one element per projectile, at the same index).
+ * The integration and scene casts only read the arrays they need, so simulating many projectiles stays cache friendly.
+ */
+struct GAMECORE_API FGCBallisticProjectiles
+{
+	/** Adds a projectile and gives its id */
+	int32 Add(const FGCBallisticProjectileParams& InParams);
+	/** Removes the projectiles that are flagged Finished. Doesn't keep the order of the projectiles. */
+	void RemoveFinished();
+	void Reset();
+	int32 Num() const { return Ids.Num(); }
+
+	/** Ids given by Add() */
+	TArray<int32> Ids;
+	TArray<FVector> Locations;
+	TArray<FVector> Velocities;
+	/** Strength is StrengthPerSpeedSquared * speed^2 (strength follows kinetic energy) */
+	TArray<float> StrengthPerSpeedSquared;
+	TArray<float> DragCoefficients;
+	TArray<float> GravityScales;
+	/** Ricochets left (negative for no cap) */
+	TArray<int32> RemainingRicochets;
+	TArray<float> RemainingLifetimes;
+	/** The per cm nerfs of the geometry each projectile is currently inside of */
+	TArray<FPenetrationNerfStack> PerCmNerfStacks;
+	/** Each projectile's collision params (ignored actor included) and its scene casts' reusable memory. Built once by Add() rather than every tick. */
+	TArray<FExitHitsQueryScratch> Scratches;
+	/** The scene casts and hits of each projectile's latest tick. Kept around to reuse their memory. */
+	TArray<FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult> TickResults;
+	/** Projectiles to remove on the next RemoveFinished() */
+	TArray<bool> Finished;
+
+private:
+	int32 NextId = 0;
+};
+
+
+/** Called with a projectile's id and its scene casts for this tick, when it hit something */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FGCOnBallisticProjectileHits, const int32, const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult&);
+
+/**
+ * Simulates ballistic projectiles (gravity, drag, and strength that follows speed) without an actor per projectile.
+ * Each tick, every projectile is integrated and then scene casts the segment it traveled with RicochetingPenetrationSceneCastWithExitHitsUsingStrength(). Both are done in parallel.
+ * Strength lost to penetrations and ricochets slows the projectile down.
+ *
+ * For a headless benchmark, run "GC.BallisticProjectiles.Benchmark [NumProjectiles] [NumTicks]" (e.g. with -nullrhi and -ExecCmds). The GCQueryBenchmark commandlet also benchmarks a tick, with a baseline to check for regressions.
+ */
+UCLASS()
+class GAMECORE_API UGCBallisticProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UGCBallisticProjectileSubsystem();
+
+	//  BEGIN UTickableWorldSubsystem interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//  END UTickableWorldSubsystem interface
+
+	/** Adds a projectile to the simulation and gives its id */
+	int32 FireProjectile(const FGCBallisticProjectileParams& InParams);
+	void DestroyAllProjectiles();
+	int32 GetNumProjectiles() const { return Projectiles.Num(); }
+
+	/** Gives the penetration and ricochet values to use. Without a profile, projectiles never lose strength to geometry and never ricochet. */
+	void SetMaterialProfile(UGCBallisticsMaterialProfile* InMaterialProfile);
+
+	/**
+	 * Moves InOutProjectiles forward by InDeltaSeconds, doing their scene casts and flagging the ones that stopped as Finished.
+	 * Public so that other projectile storage can be simulated with our settings (e.g. for benchmarking).
+	 */
+	void SimulateProjectiles(FGCBallisticProjectiles& InOutProjectiles, const float InDeltaSeconds) const;
+
+	/** Broadcasted on the game thread for every projectile that hit something this tick */
+	FGCOnBallisticProjectileHits OnProjectileHits;
+
+	/** The trace channel for the projectiles' scene casts */
+	UPROPERTY(EditAnywhere, Category = "Ballistics")
+		TEnumAsByte<ECollisionChannel> TraceChannel;
+	/** How the projectiles' scene casts find their exit hits (see UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits()) */
+	UPROPERTY(EditAnywhere, Category = "Ballistics")
+		EExitHitsMethod ExitHitsMethod;
+	/** See UGCBlueprintFunctionLibrary_CollisionQueries::SceneCastMultiWithExitHits() */
+	UPROPERTY(EditAnywhere, Category = "Ballistics")
+		EFurthestPossibleExitMethod FurthestPossibleExitMethod;
+	/** If > 0, the projectiles' scene casts are done in chunks (see UGCBlueprintFunctionLibrary_CollisionQueries::PenetrationSceneCast()) */
+	UPROPERTY(EditAnywhere, Category = "Ballistics", meta = (ClampMin = "0"))
+		float ProgressiveChunkLength;
+	/** If false, projectiles are simulated one after another on the game thread */
+	UPROPERTY(EditAnywhere, Category = "Ballistics")
+		uint8 bSimulateInParallel : 1;
+
+	/** Fires many projectiles into a separate storage, simulates them for some ticks, and logs how long it took */
+	static void RunBenchmark(const TArray<FString>& InArgs, UWorld* InWorld);
+
+protected:
+	UPROPERTY(Transient)
+		UGCBallisticsMaterialProfile* MaterialProfile;
+
+	/** Projectiles in flight */
+	FGCBallisticProjectiles Projectiles;
+
+private:
+	template <class TPolicy>
+	void SimulateProjectilesInternal(FGCBallisticProjectiles& InOutProjectiles, const float InDeltaSeconds, const TPolicy& InPolicy) const;
+};
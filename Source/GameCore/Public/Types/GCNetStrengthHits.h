@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlueprintFunctionLibraries/CollisionQuery/GCBlueprintFunctionLibrary_StrengthCollisionQueries.h"
+
+#include "GCNetStrengthHits.generated.h"
+
+
+
+/**
+ * The hits of a strength query, packed for replication (e.g. for clients to play tracers and impacts).
+ * Every hit is quantized against the query rather than on its own:
+ *  - Locations are sent as their offset from the previous hit (the first from StartLocation), to a tenth of a cm
+ *  - Normals are octahedral encoded
+ *  - Strength is sent as a fraction of StartStrength with StrengthBits bits
+ *  - Flags are bit packed, and the trace of a hit is only sent when it differs from the previous hit's
+ * Distance and Time are rebuilt from the trace on the receiving end. PenetrationDepth, Item, and ElementIndex aren't sent.
+ */
+USTRUCT()
+struct GAMECORE_API FGCNetStrengthHits
+{
+	GENERATED_BODY()
+
+	FGCNetStrengthHits()
+		: StartLocation(FVector::ZeroVector)
+		, StartStrength(0.f)
+		, Hits(TArray<FStrengthHitResult>())
+		, StrengthBits(10)
+		, NormalBitsPerComponent(10)
+	{
+	}
+
+	/** Copies the start and hits of a ricocheting query's result */
+	void SetFromResult(const FFlatRicochetingPenetrationSceneCastWithExitHitsUsingStrengthResult& InResult);
+
+	/** Where the query started */
+	FVector StartLocation;
+	/** The query's strength at StartLocation */
+	float StartStrength;
+	/** The query's hits, in order */
+	TArray<FStrengthHitResult> Hits;
+	/** Bits for each hit's strength. These are sent along with the hits, so the receiving end doesn't need the same settings. */
+	uint8 StrengthBits;
+	/** Bits for each component of the octahedral encoded normals */
+	uint8 NormalBitsPerComponent;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** Logs the size and speed of our serialization compared to FHitResult's and FStrengthHitResult's */
+	static void RunBenchmark(const TArray<FString>& InArgs);
+
+	/** Limit for received hit counts */
+	static constexpr int32 MaxNumHits = 1024;
+};
+
+template <>
+struct TStructOpsTypeTraits<FGCNetStrengthHits> : public TStructOpsTypeTraitsBase2<FGCNetStrengthHits>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
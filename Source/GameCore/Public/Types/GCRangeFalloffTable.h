@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+struct FRichCurve;
+
+/**
+ * A non-linear range falloff for the strength queries: a per cm strength nerf that changes with the distance the query has traveled (e.g. exponential or piecewise falloff).
+ * The falloff is integrated ahead of time into a table so that the strength lost over a segment is two lookups, and the distance at which strength runs out is a binary search over the table instead of sub-stepping the segment.
+ * Give it to the query with FPenetrationNerfStack::SetRangeFalloff(). The table must outlive the nerf stacks that use it.
+ */
+struct GAMECORE_API FGCRangeFalloffTable
+{
+	/** Makes an empty table (no falloff) */
+	FGCRangeFalloffTable();
+
+	/**
+	 * Integrates a falloff into the table
+	 * @param  InGetPerCmNerfAtDistance    Gives the per cm strength nerf at a distance traveled (e.g. [](float D) { return 0.01f * FMath::Exp(D / 10000.f); }). Negative nerfs are treated as 0.
+	 * @param  InMaxDistance               Distance covered by the table. Past it, the nerf at InMaxDistance is used.
+	 * @param  InNumSamples                Number of table entries. More entries follow the falloff more closely.
+	 */
+	void Build(const TFunctionRef<float(float)>& InGetPerCmNerfAtDistance, const float InMaxDistance, const int32 InNumSamples = 256);
+	/** Build() with the per cm nerf given by a curve of distance (e.g. from a UCurveFloat) */
+	void BuildFromCurve(const FRichCurve& InPerCmNerfCurve, const float InMaxDistance, const int32 InNumSamples = 256);
+
+	bool IsEmpty() const { return Integral.Num() <= 0; }
+
+	/** Total strength taken away by the falloff from distance 0 to InDistance */
+	float GetIntegral(const float InDistance) const;
+	/** Strength taken away by the falloff when traveling from InStartDistance to InEndDistance */
+	float GetStrengthLost(const float InStartDistance, const float InEndDistance) const { return GetIntegral(InEndDistance) - GetIntegral(InStartDistance); }
+
+	/**
+	 * Finds how far we get from InStartDistance before InStrength runs out, given the falloff and an additional constant per cm nerf (e.g. the geometry we are in).
+	 * Exact for the table (the falloff is linearly interpolated between entries).
+	 * @return InMaxTravelDistance if we don't run out before it
+	 */
+	float GetTravelDistance(const float InStartDistance, const float InStrength, const float InConstantPerCmNerf, const float InMaxTravelDistance) const;
+
+private:
+	/** Integral[i] is the strength taken away from distance 0 to distance i * SampleSpacing */
+	TArray<float> Integral;
+	float SampleSpacing;
+	float InvSampleSpacing;
+	/** The per cm nerf used past the end of the table */
+	float PerCmNerfPastEnd;
+};
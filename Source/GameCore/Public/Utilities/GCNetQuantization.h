@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+/**
+ * Quantization helpers for our NetSerialize() functions. Each of them both writes and reads (depending on the archive), so the same code path is used on both ends.
+ */
+struct GAMECORE_API FGCNetQuantization
+{
+	/**
+	 * Writes a unit vector in 2 * InBitsPerComponent bits using octahedral encoding (the sphere is folded onto a square, so precision is spread evenly over every direction).
+	 * A zero vector is sent as a zero vector, for hits without a normal.
+	 */
+	static void SerializeOctahedralNormal(FArchive& InOutArchive, FVector& InOutNormal, const int32 InBitsPerComponent);
+
+	/** Writes a 0 to 1 value in InNumBits bits. Values outside of the range are clamped. */
+	static void SerializeQuantizedUnitFloat(FArchive& InOutArchive, float& InOutValue, const int32 InNumBits);
+
+	/**
+	 * Writes a location as its offset from InOrigin, rounded to a tenth of a cm.
+	 * The offset is written with only as many bits as it needs, so locations near the origin (e.g. hits of a query relative to its start) are cheap.
+	 */
+	static bool SerializeRelativeLocation(FArchive& InOutArchive, FVector& InOutLocation, const FVector& InOrigin);
+	/** Gives the location the receiving end gets from SerializeRelativeLocation(). Use it as the next origin so that offsets chained from one another don't drift. */
+	static FVector QuantizeRelativeLocation(const FVector& InLocation, const FVector& InOrigin);
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Atomic.h"
+
+
+class UWorld;
+struct FHitResult;
+
+
+
+/** What one of our scene casts cost, for FGCQueryHeatmap */
+struct GAMECORE_API FGCQueryHeatmapSample
+{
+	FGCQueryHeatmapSample();
+
+	FVector Start;
+	/** Where the query stopped (its blocking or impenetrable hit, or its end) */
+	FVector End;
+	/** Where the exit hits' backwards scene cast started, when there was one */
+	TOptional<FVector> BackwardsStart;
+
+	double Seconds;
+	/** Scene casts and body queries the query issued */
+	uint32 NumSceneCasts;
+};
+
+/** The cost summed into one cell of FGCQueryHeatmap's grid */
+struct GAMECORE_API FGCQueryHeatmapCell
+{
+	FGCQueryHeatmapCell();
+
+	/** Queries that passed through the cell */
+	int32 NumQueries;
+	/** Each query's time, scene casts, and backwards scene cast length are shared out evenly among the cells it passed through */
+	double Seconds;
+	double NumSceneCasts;
+	double BackwardsSceneCastLength;
+	/** Entrance and exit hits within the cell */
+	int32 NumHits;
+};
+
+/** The cells that one thread's queries have added to, so that threads don't contend with each other over one grid */
+struct GAMECORE_API FGCQueryHeatmapThreadCells
+{
+	/** Only contended while the grid is being cleared or gathered */
+	FCriticalSection CriticalSection;
+	TMap<FIntVector, FGCQueryHeatmapCell> Cells;
+};
+
+/**
+ * Sums the cost of our scene casts into a world space grid, so that level designers can see which geometry (e.g. thin stacked walls or dense overlap triggers) makes our queries expensive.
+ * Exported per map as a CSV of every cell, and a top down PNG of the time spent in each column of cells (pixel (0, 0) is the cell with the lowest X and Y).
+ * Meant to be left running on production servers. Stops and exports on its own when its map's world is cleaned up, so start it for every match that should be gathered.
+ * Each thread sums into its own cells, which are only gathered into one grid when stopping or exporting.
+ * Only the queries done in one call are summed. The async exit hit queries (e.g. AsyncSceneCastMultiWithExitHits()) are left out, since their scene casts are spread over frames and threads.
+ *
+ * Start with "GC.QueryHeatmap.Start [CellSize=500]", stop with "GC.QueryHeatmap.Stop", and export with "GC.QueryHeatmap.Export [Filename without extension]".
+ */
+class GAMECORE_API FGCQueryHeatmap
+{
+public:
+	/** Starts summing queries into a grid of InCellSize cells for InWorld's map. Clears the last grid. */
+	static void StartRecording(const UWorld* InWorld, const float InCellSize = 500.f);
+	/** Stops summing queries. The grid is kept for exporting. */
+	static void StopRecording();
+	static bool IsRecording() { return bRecording.Load(EMemoryOrder::Relaxed); }
+
+	/** Adds a finished query's cost, and its hits. Thread safe. */
+	static void AddSample(const FGCQueryHeatmapSample& InSample, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults);
+
+	/** Writes the grid to <InBaseFilename>.csv and <InBaseFilename>.png. Defaults to Saved/Profiling/GCQueryHeatmaps/<Map>_<date>. */
+	static bool Export(FString InBaseFilename = FString());
+
+	/** Counts a scene cast or body query issued on the calling thread, so that FGCQueryRecordScope can tell how many a query made */
+	static void CountSceneCast();
+	static uint32 GetNumSceneCastsOnThisThread();
+
+	/** Images wider or taller than this many cells aren't exported (the CSV still is) */
+	static constexpr int32 MaxImageSize = 4096;
+
+private:
+	/** Gets the cells that a segment passes through, in order and without repeats */
+	static void GetSegmentCells(const FVector& InStart, const FVector& InEnd, TArray<FIntVector, TInlineAllocator<64>>& OutSegmentCells);
+	static FIntVector GetCellCoordinates(const FVector& InLocation);
+
+	/** Gets the calling thread's cells, making them the first time */
+	static FGCQueryHeatmapThreadCells& GetThreadCells();
+	/** Sums every thread's cells into one grid */
+	static void GatherCells(TMap<FIntVector, FGCQueryHeatmapCell>& OutCells);
+
+	static void OnWorldCleanup(UWorld* InWorld, bool bInSessionEnded, bool bInCleanupResources);
+
+	static TAtomic<bool> bRecording;
+	/** Guards ThreadCells and MapName. CellSize is only changed while we aren't recording. */
+	static FCriticalSection CriticalSection;
+	/** Every thread's cells. Shared with the threads' own pointers to them, so that a thread's cells outlive it until they're cleared. */
+	static TArray<TSharedPtr<FGCQueryHeatmapThreadCells, ESPMode::ThreadSafe>> ThreadCells;
+	static float CellSize;
+	static FString MapName;
+	static FDelegateHandle OnWorldCleanupHandle;
+};
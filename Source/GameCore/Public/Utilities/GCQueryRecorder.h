@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Optional.h"
+#include "Templates/Atomic.h"
+#include "WorldCollision.h"
+#include "Utilities/GCQueryVisualizer.h"
+#include "Utilities/GCQueryHeatmap.h"
+
+
+// The collision queries include us for their header-defined templates, so we can't include them
+enum class EExitHitsMethod : uint8;
+enum class EFurthestPossibleExitMethod : uint8;
+struct FExitAwareHitResult;
+
+
+/** The kind of query a record is for. These are the two scene casts that every one of our queries (strength, batch, and cursor ones included) ends up going through. */
+enum class EGCQueryRecordType : uint8
+{
+	SceneCastMultiWithExitHits,
+	PenetrationSceneCastWithExitHits
+};
+
+/**
+ * The inputs, callback outcomes, and results of one of our scene casts. Enough to run it again against the same map and compare.
+ * Ignored actors and components aren't captured (their ids mean nothing outside of the recording process), so queries that relied on them will show as diffs when replayed.
+ */
+struct GAMECORE_API FGCQueryRecord
+{
+	FGCQueryRecord();
+
+	/** The scene cast's inputs */
+	EGCQueryRecordType Type;
+	FVector Start;
+	FVector End;
+	FQuat Rotation;
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+	FCollisionShape CollisionShape;
+	uint8 bTraceComplex : 1;
+	uint8 bFindInitialOverlaps : 1;
+	uint8 bReturnPhysicalMaterial : 1;
+	uint8 bReturnFaceIndex : 1;
+	uint8 bIgnoreTouches : 1;
+	uint8 bOptimizeBackwardsSceneCastLength : 1;
+	EExitHitsMethod ExitHitsMethod;
+	EFurthestPossibleExitMethod FurthestPossibleExitMethod;
+	float ProgressiveChunkLength;
+	FCollisionResponseContainer CollisionResponses;
+
+	/** What IsHitImpenetrable() returned, in the order it was called. Replayed instead of calling the game's callback. */
+	TBitArray<> ImpenetrableOutcomes;
+
+	/** The scene cast's results */
+	uint8 bBlockingHit : 1;
+	int32 NumEntranceHits;
+	int32 NumExitHits;
+	/** Location of the furthest entrance hit (the blocking or impenetrable one when there is one). End when there are no entrance hits. */
+	FVector FurthestEntranceLocation;
+	/** How long the scene cast took */
+	float Microseconds;
+
+	void GetCollisionParams(FCollisionQueryParams& OutCollisionQueryParams, FCollisionResponseParams& OutCollisionResponseParams) const;
+
+	/** Fills in our results from the scene cast's entrance and exit hits */
+	void SetResults(const bool bInBlockingHit, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults);
+	void SetResults(const bool bInBlockingHit, const TArray<FExitAwareHitResult>& InHitResults);
+
+	/** Whether the results of a replay are the same as ours (within InLocationTolerance) */
+	bool HasSameResults(const FGCQueryRecord& InOther, const float InLocationTolerance = .1f) const;
+
+	friend FArchive& operator<<(FArchive& InOutArchive, FGCQueryRecord& InOutRecord);
+};
+
+/**
+ * Captures our scene casts into a binary file while recording, so that a production server's query load can be replayed locally (see UGCQueryReplayCommandlet).
+ * Queries made on any thread are captured. Records are buffered and written out in chunks.
+ *
+ * Start and stop with "GC.QueryRecorder.Start [Filename]" and "GC.QueryRecorder.Stop".
+ */
+class GAMECORE_API FGCQueryRecorder
+{
+public:
+	/** Starts capturing queries into InFilename, along with the name of InWorld's map for the replay to load */
+	static bool StartRecording(const FString& InFilename, const UWorld* InWorld);
+	static void StopRecording();
+	static bool IsRecording() { return bRecording.Load(EMemoryOrder::Relaxed); }
+
+	/** Adds a finished query's record. Thread safe. */
+	static void AddRecord(FGCQueryRecord& InOutRecord);
+
+	/** Reads the records of a file made by StartRecording() */
+	static bool LoadRecording(const FString& InFilename, FString& OutMapName, TArray<FGCQueryRecord>& OutRecords);
+
+	/** Start of our files, followed by a version */
+	static constexpr uint32 FileMagic = 0x52514347; // "GCQR"
+	static constexpr uint32 FileVersion = 1;
+
+private:
+	static void FlushBuffer();
+
+	static TAtomic<bool> bRecording;
+	static FCriticalSection CriticalSection;
+	static TUniquePtr<FArchive> FileWriter;
+	/** Records waiting to be written to the file */
+	static TArray<uint8> Buffer;
+	static int32 NumRecords;
+};
+
+/**
+ * Captures one query for FGCQueryRecorder, FGCQueryVisualizer, and FGCQueryHeatmap, for as long as it is in scope. Does nothing when none of them are enabled.
+ * Give it the query's IsHitImpenetrable() outcomes with AddImpenetrableOutcome() so that the replay can use them, and where the exit hits' backwards scene cast started with SetBackwardsStart() so that the visualizer can show it.
+ */
+class GAMECORE_API FGCQueryRecordScope
+{
+public:
+	FGCQueryRecordScope(const EGCQueryRecordType InType, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults, const FVector& InStart, const FVector& InEnd, const FQuat& InRotation, const ECollisionChannel InTraceChannel, const FCollisionShape& InCollisionShape, const FCollisionQueryParams& InCollisionQueryParams, const FCollisionResponseParams& InCollisionResponseParams, const bool bInOptimizeBackwardsSceneCastLength, const EExitHitsMethod InExitHitsMethod, const EFurthestPossibleExitMethod InFurthestPossibleExitMethod, const float InProgressiveChunkLength = 0.f);
+	/** Adds the record with the hits the query ended up with */
+	~FGCQueryRecordScope();
+
+	bool IsRecording() const { return Record.IsSet(); }
+	void SetBlockingHit(const bool bInBlockingHit) { bBlockingHit = bInBlockingHit; }
+	void AddImpenetrableOutcome(const bool bInImpenetrable) { Record->ImpenetrableOutcomes.Add(bInImpenetrable); }
+	void SetBackwardsStart(const FVector& InBackwardsStart);
+
+private:
+	/** Only set while recording so that queries don't pay for a record otherwise */
+	TOptional<FGCQueryRecord> Record;
+	/** Only set while the visualizer is enabled, for the same reason */
+	TOptional<FGCQueryVisualizerEntry> VisualizerEntry;
+	TOptional<FGCQueryHeatmapSample> HeatmapSample;
+	const TArray<FHitResult>& EntranceHitResults;
+	const TArray<FHitResult>& ExitHitResults;
+	bool bBlockingHit;
+	uint64 StartCycles;
+	/** FGCQueryHeatmap::GetNumSceneCastsOnThisThread() when we started */
+	uint32 StartNumSceneCasts;
+};
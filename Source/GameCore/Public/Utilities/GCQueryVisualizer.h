@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "CollisionShape.h"
+#include "Engine/EngineTypes.h"
+
+
+enum class EGCQueryRecordType : uint8;
+
+
+
+/**
+ * A fixed size summary of one of our scene casts, for FGCQueryVisualizer. Plain data so that recording one is a copy.
+ */
+struct GAMECORE_API FGCQueryVisualizerEntry
+{
+	FGCQueryVisualizerEntry();
+
+	/** Hits past this many are counted but their locations aren't kept */
+	static constexpr int32 MaxHitLocations = 16;
+
+	/** FPlatformTime::Seconds() when the query finished */
+	double Time;
+	EGCQueryRecordType Type;
+	FVector Start;
+	FVector End;
+	FQuat Rotation;
+	TEnumAsByte<ECollisionChannel> TraceChannel;
+	FCollisionShape CollisionShape;
+	/** The query params' owner tag (the name of the actor the query was made for, when given one) */
+	FName OwnerTag;
+	FName TraceTag;
+
+	uint8 bBlockingHit : 1;
+	uint8 bHasBackwardsStart : 1;
+	/** The blocking (or impenetrable) hit's location, or End without one */
+	FVector StopLocation;
+	/** Where the backwards scene cast for the exit hits started */
+	FVector BackwardsStart;
+
+	int32 NumEntranceHits;
+	int32 NumExitHits;
+	/** Entrance hit locations followed by exit hit locations, up to MaxHitLocations */
+	int32 NumHitLocations;
+	FVector HitLocations[MaxHitLocations];
+	/** Bit i is set when HitLocations[i] is an exit */
+	uint32 ExitHitBits;
+
+	/** Fills in our results from the scene cast's entrance and exit hits */
+	void SetResults(const bool bInBlockingHit, const TArray<FHitResult>& InEntranceHitResults, const TArray<FHitResult>& InExitHitResults);
+};
+
+/** Which of the FGCQueryVisualizer's entries to draw or log */
+struct GAMECORE_API FGCQueryVisualizerFilter
+{
+	FGCQueryVisualizerFilter();
+
+	/** Only entries from the last this many seconds (<= 0 for all of them) */
+	float TimeWindow;
+	/** Only entries whose owner tag contains this (empty for any) */
+	FString Actor;
+	/** Only entries of this trace channel */
+	TOptional<ECollisionChannel> TraceChannel;
+
+	/** Reads "Seconds=5 Actor=BP_Character Channel=ECC_Visibility" style args */
+	static FGCQueryVisualizerFilter FromArgs(const TArray<FString>& InArgs);
+
+	bool Matches(const FGCQueryVisualizerEntry& InEntry, const double InNow) const;
+};
+
+/** One thread's ring of FGCQueryVisualizer entries, so that threads don't contend with each other over one ring */
+struct GAMECORE_API FGCQueryVisualizerThreadEntries
+{
+	FGCQueryVisualizerThreadEntries();
+
+	/** Only contended while the entries are being read or cleared */
+	FCriticalSection CriticalSection;
+	TArray<FGCQueryVisualizerEntry> Entries;
+	/** Size of the ring. Entries are added until it is full and then overwritten starting from the oldest. */
+	int32 Capacity;
+	/** Where the next entry goes once full */
+	int32 NextEntryIndex;
+};
+
+/**
+ * Keeps the most recent of our scene casts in a fixed size ring buffer so that they can be looked at after the fact, rather than drawing from inside of the queries.
+ * Recording is a copy into the ring and nothing is drawn until asked for, so it can be left enabled (e.g. on test servers). Queries made on any thread are recorded.
+ * Each thread records into a ring of its own, and the rings are only merged (by time) when the entries are read.
+ *
+ * Enable with "GC.QueryVisualizer.Enabled 1" (and size with "GC.QueryVisualizer.Capacity").
+ * Look with "GC.QueryVisualizer.Draw [Seconds=5] [Actor=<Owner tag>] [Channel=<ECC_ name or number>] [Duration=10]" or "GC.QueryVisualizer.VisLog [...]", and empty with "GC.QueryVisualizer.Clear".
+ */
+class GAMECORE_API FGCQueryVisualizer
+{
+public:
+	static bool IsEnabled();
+
+	/** Adds a finished query's entry to the calling thread's ring, overwriting its oldest one once full. Thread safe. */
+	static void AddEntry(const FGCQueryVisualizerEntry& InEntry);
+	/** Copies out the entries that pass the filter, oldest first, from among the most recent GC.QueryVisualizer.Capacity of them */
+	static void GetEntries(const FGCQueryVisualizerFilter& InFilter, TArray<FGCQueryVisualizerEntry>& OutEntries);
+	static void Clear();
+
+	/** Draws the entries that pass the filter with a single batch of debug lines */
+	static void DrawEntries(const UWorld* InWorld, const FGCQueryVisualizerFilter& InFilter, const float InLifeTime = 10.f);
+	/** Sends the entries that pass the filter to the visual logger, under the world */
+	static void VisLogEntries(const UWorld* InWorld, const FGCQueryVisualizerFilter& InFilter);
+
+private:
+	/** Gets the calling thread's ring, making it the first time */
+	static FGCQueryVisualizerThreadEntries& GetThreadEntries();
+
+	/** Guards ThreadEntries */
+	static FCriticalSection CriticalSection;
+	/** Every thread's ring. Shared with the threads' own pointers to them, so that a thread's entries outlive it until they're cleared. */
+	static TArray<TSharedPtr<FGCQueryVisualizerThreadEntries, ESPMode::ThreadSafe>> ThreadEntries;
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
+
+
+
+/**
+ * Stats for GameCore's queries. View them in game with "stat GameCore".
+ * For Unreal Insights, also enable our trace channel with "-trace=cpu,GameCore" (or "Trace.Enable GameCore") to get our scopes without the rest of the engine's.
+ * These are exported since our header-defined templates (e.g. the strength query policy versions) get compiled into other modules.
+ */
+DECLARE_STATS_GROUP(TEXT("GameCore"), STATGROUP_GameCore, STATCAT_Advanced);
+
+// Collision queries
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SceneCastMultiWithExitHits"), STAT_GCSceneCastMultiWithExitHits, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("SceneCastMultiWithExitHitsBatch"), STAT_GCSceneCastMultiWithExitHitsBatch, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PenetrationSceneCast"), STAT_GCPenetrationSceneCast, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PenetrationSceneCastWithExitHits"), STAT_GCPenetrationSceneCastWithExitHits, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Forwards Scene Cast"), STAT_GCForwardsSceneCast, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Find Exit Hits"), STAT_GCFindExitHits, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Change Hits Response Data"), STAT_GCChangeHitsResponseData, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Order Hits In Forwards Direction"), STAT_GCOrderHitsInForwardsDirection, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Async Scene Cast Completion"), STAT_GCAsyncSceneCastCompletion, STATGROUP_GameCore, GAMECORE_API);
+
+// Strength collision queries
+DECLARE_CYCLE_STAT_EXTERN(TEXT("PenetrationSceneCastWithExitHitsUsingStrength"), STAT_GCPenetrationSceneCastWithExitHitsUsingStrength, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RicochetingPenetrationSceneCastWithExitHitsUsingStrength"), STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrength, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("RicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch"), STAT_GCRicochetingPenetrationSceneCastWithExitHitsUsingStrengthBatch, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Evaluate Strength"), STAT_GCEvaluateStrength, STATGROUP_GameCore, GAMECORE_API);
+
+// Ballistic projectiles
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Simulate Ballistic Projectiles"), STAT_GCSimulateBallisticProjectiles, STATGROUP_GameCore, GAMECORE_API);
+
+// Counters (reset every frame)
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Scene Casts Issued"), STAT_GCSceneCastsIssued, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Body Queries Issued"), STAT_GCBodyQueriesIssued, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Processed"), STAT_GCHitsProcessed, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ricochets"), STAT_GCRicochets, STATGROUP_GameCore, GAMECORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ballistic Projectiles Simulated"), STAT_GCBallisticProjectilesSimulated, STATGROUP_GameCore, GAMECORE_API);
+
+
+/** Trace channel for GameCore's scopes in Unreal Insights */
+UE_TRACE_CHANNEL_EXTERN(GameCoreChannel, GAMECORE_API);
+
+/** LLM tag for memory allocated by GameCore's queries */
+LLM_DECLARE_TAG_API(GameCore, GAMECORE_API);
+
+
+/**
+ * Scope for a GameCore query. Does the stat cycle counter, the Insights scope on our GameCoreChannel, and the LLM tag.
+ */
+#define GC_QUERY_SCOPE(StatName) \
+	SCOPE_CYCLE_COUNTER(StatName); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(StatName, GameCoreChannel); \
+	LLM_SCOPE_BYTAG(GameCore)